@@ -40,9 +40,9 @@
  */
 
 #ifndef G_DISABLE_ASSERT
-# define DEBUG_VALIDATE(a,b) G_STMT_START { if (a) cjh_text_region_node_validate(a,b); } G_STMT_END
+# define DEBUG_VALIDATE(r,a,b) G_STMT_START { if (a) cjh_text_region_node_validate(r,a,b); } G_STMT_END
 #else
-# define DEBUG_VALIDATE(a,b) G_STMT_START { } G_STMT_END
+# define DEBUG_VALIDATE(r,a,b) G_STMT_START { } G_STMT_END
 #endif
 
 static inline void
@@ -53,11 +53,13 @@ cjh_text_region_invalid_cache (CjhTextRegion *region)
 }
 
 G_GNUC_UNUSED static void
-cjh_text_region_node_validate (CjhTextRegionNode *node,
+cjh_text_region_node_validate (CjhTextRegion     *region,
+                               CjhTextRegionNode *node,
                                CjhTextRegionNode *parent)
 {
   gsize length = 0;
   gsize length_in_parent = 0;
+  gsize tracked_in_parent = 0;
 
   g_assert (node != NULL);
   g_assert (UNTAG (node->tagged_parent) == parent);
@@ -72,6 +74,7 @@ cjh_text_region_node_validate (CjhTextRegionNode *node,
         if (child->node == node)
           {
             length_in_parent = child->length;
+            tracked_in_parent = child->tracked;
             goto found;
           }
       });
@@ -80,7 +83,11 @@ cjh_text_region_node_validate (CjhTextRegionNode *node,
 found:
 
   if (parent != NULL)
-    g_assert_cmpint (length_in_parent, ==, cjh_text_region_node_length (node));
+    {
+      g_assert_cmpint (length_in_parent, ==, cjh_text_region_node_length (node));
+      g_assert_cmpint (tracked_in_parent, ==, cjh_text_region_node_tracked (region, node));
+      g_assert_cmpint (tracked_in_parent, <=, length_in_parent);
+    }
 
   for (CjhTextRegionNode *iter = parent;
        iter != NULL;
@@ -108,6 +115,7 @@ found:
         g_assert_nonnull (child->node);
         g_assert_cmpint (child->length, >, 0);
         g_assert_cmpint (child->length, ==, cjh_text_region_node_length (child->node));
+        g_assert_cmpint (child->tracked, ==, cjh_text_region_node_tracked (region, child->node));
         g_assert_true (cjh_text_region_node_get_parent (child->node) == node);
 
         length += child->length;
@@ -176,11 +184,12 @@ cjh_text_region_node_new (CjhTextRegionNode *parent,
 static void
 cjh_text_region_subtract_from_parents (CjhTextRegion     *region,
                                        CjhTextRegionNode *node,
-                                       gsize              length)
+                                       gsize              length,
+                                       gsize              tracked)
 {
   CjhTextRegionNode *parent = cjh_text_region_node_get_parent (node);
 
-  if (parent == NULL || length == 0)
+  if (parent == NULL || (length == 0 && tracked == 0))
     return;
 
   cjh_text_region_invalid_cache (region);
@@ -189,8 +198,10 @@ cjh_text_region_subtract_from_parents (CjhTextRegion     *region,
     if (child->node == node)
       {
         g_assert (length <= child->length);
+        g_assert (tracked <= child->tracked);
         child->length -= length;
-        cjh_text_region_subtract_from_parents (region, parent, length);
+        child->tracked -= tracked;
+        cjh_text_region_subtract_from_parents (region, parent, length, tracked);
         return;
       }
   });
@@ -201,11 +212,12 @@ cjh_text_region_subtract_from_parents (CjhTextRegion     *region,
 static void
 cjh_text_region_add_to_parents (CjhTextRegion     *region,
                                 CjhTextRegionNode *node,
-                                gsize              length)
+                                gsize              length,
+                                gsize              tracked)
 {
   CjhTextRegionNode *parent = cjh_text_region_node_get_parent (node);
 
-  if (parent == NULL || length == 0)
+  if (parent == NULL || (length == 0 && tracked == 0))
     return;
 
   cjh_text_region_invalid_cache (region);
@@ -214,7 +226,38 @@ cjh_text_region_add_to_parents (CjhTextRegion     *region,
     if (child->node == node)
       {
         child->length += length;
-        cjh_text_region_add_to_parents (region, parent, length);
+        child->tracked += tracked;
+        cjh_text_region_add_to_parents (region, parent, length, tracked);
+        return;
+      }
+  });
+
+  g_assert_not_reached ();
+}
+
+/* Inserts and removals may change the data of the runs in @leaf through
+ * the split and join callbacks, so recount what is tracked in @leaf and
+ * update the parents with the difference.
+ */
+static void
+cjh_text_region_sync_tracked (CjhTextRegion     *region,
+                              CjhTextRegionNode *leaf)
+{
+  CjhTextRegionNode *parent = cjh_text_region_node_get_parent (leaf);
+
+  g_assert (cjh_text_region_node_is_leaf (leaf));
+  g_assert (parent != NULL);
+
+  SORTED_ARRAY_FOREACH (&parent->branch.children, CjhTextRegionChild, child, {
+    if (child->node == leaf)
+      {
+        gsize tracked = cjh_text_region_node_tracked (region, leaf);
+
+        if (tracked > child->tracked)
+          cjh_text_region_add_to_parents (region, leaf, 0, tracked - child->tracked);
+        else if (tracked < child->tracked)
+          cjh_text_region_subtract_from_parents (region, leaf, 0, child->tracked - tracked);
+
         return;
       }
   });
@@ -343,17 +386,19 @@ cjh_text_region_root_split (CjhTextRegion     *region,
 
   new_child.node = right;
   new_child.length = cjh_text_region_node_length (right);
+  new_child.tracked = cjh_text_region_node_tracked (region, right);
   SORTED_ARRAY_PUSH_HEAD (&root->branch.children, new_child);
 
   new_child.node = left;
   new_child.length = cjh_text_region_node_length (left);
+  new_child.tracked = cjh_text_region_node_tracked (region, left);
   SORTED_ARRAY_PUSH_HEAD (&root->branch.children, new_child);
 
   g_assert (SORTED_ARRAY_LENGTH (&root->branch.children) == 2);
 
-  DEBUG_VALIDATE (root, NULL);
-  DEBUG_VALIDATE (left, root);
-  DEBUG_VALIDATE (right, root);
+  DEBUG_VALIDATE (region, root, NULL);
+  DEBUG_VALIDATE (region, left, root);
+  DEBUG_VALIDATE (region, right, root);
 }
 
 static CjhTextRegionNode *
@@ -423,14 +468,16 @@ cjh_text_region_branch_split (CjhTextRegion     *region,
 
         right_child.node = right;
         right_child.length = right_length;
+        right_child.tracked = cjh_text_region_node_tracked (region, right);
 
         child->length = left_length;
+        child->tracked = cjh_text_region_node_tracked (region, left);
 
         SORTED_ARRAY_INSERT_VAL (&parent->branch.children, i, right_child);
 
-        DEBUG_VALIDATE (left, parent);
-        DEBUG_VALIDATE (right, parent);
-        DEBUG_VALIDATE (parent, cjh_text_region_node_get_parent (parent));
+        DEBUG_VALIDATE (region, left, parent);
+        DEBUG_VALIDATE (region, right, parent);
+        DEBUG_VALIDATE (region, parent, cjh_text_region_node_get_parent (parent));
 
         return right;
       }
@@ -447,6 +494,7 @@ cjh_text_region_leaf_split (CjhTextRegion     *region,
   CjhTextRegionNode *parent;
   CjhTextRegionNode *right;
   gsize right_length;
+  gsize right_tracked;
   guint i;
 
   g_assert (region != NULL);
@@ -464,13 +512,14 @@ cjh_text_region_leaf_split (CjhTextRegion     *region,
 
   g_assert (length > 0);
 
-  DEBUG_VALIDATE (parent, cjh_text_region_node_get_parent (parent));
-  DEBUG_VALIDATE (left, parent);
+  DEBUG_VALIDATE (region, parent, cjh_text_region_node_get_parent (parent));
+  DEBUG_VALIDATE (region, left, parent);
 
   right = cjh_text_region_node_new (parent, TRUE);
 
   SORTED_ARRAY_SPLIT (&left->leaf.runs, &right->leaf.runs);
   right_length = cjh_text_region_node_length (right);
+  right_tracked = cjh_text_region_node_tracked (region, right);
 
   g_assert (length == right_length + cjh_text_region_node_length (left));
   g_assert (cjh_text_region_node_is_leaf (left));
@@ -501,8 +550,12 @@ cjh_text_region_leaf_split (CjhTextRegion     *region,
 
         right_child.node = right;
         right_child.length = right_length;
+        right_child.tracked = right_tracked;
+
+        g_assert (child->tracked >= right_tracked);
 
         child->length -= right_length;
+        child->tracked -= right_tracked;
 
         g_assert (child->length > 0);
         g_assert (right_child.length > 0);
@@ -514,9 +567,9 @@ cjh_text_region_leaf_split (CjhTextRegion     *region,
         g_assert (right->leaf.prev == left);
         g_assert (left->leaf.next == right);
 
-        DEBUG_VALIDATE (left, parent);
-        DEBUG_VALIDATE (right, parent);
-        DEBUG_VALIDATE (parent, cjh_text_region_node_get_parent (parent));
+        DEBUG_VALIDATE (region, left, parent);
+        DEBUG_VALIDATE (region, right, parent);
+        DEBUG_VALIDATE (region, parent, cjh_text_region_node_get_parent (parent));
 
         return right;
       }
@@ -592,6 +645,7 @@ _cjh_text_region_new (CjhTextRegionJoinFunc  join_func,
 
   child.node = leaf;
   child.length = 0;
+  child.tracked = 0;
 
   SORTED_ARRAY_INIT (&self->root.branch.children);
   SORTED_ARRAY_PUSH_HEAD (&self->root.branch.children, child);
@@ -697,7 +751,7 @@ _cjh_text_region_insert (CjhTextRegion *region,
   /* Split up to region->root if necessary */
   if (cjh_text_region_node_needs_split (target))
     {
-      DEBUG_VALIDATE (target, cjh_text_region_node_get_parent (target));
+      DEBUG_VALIDATE (region, target, cjh_text_region_node_get_parent (target));
 
       /* Split the target into two and then re-locate our position as
        * we might need to be in another node.
@@ -712,7 +766,7 @@ _cjh_text_region_insert (CjhTextRegion *region,
 
       g_assert (cjh_text_region_node_is_leaf (target));
       g_assert (offset_within_node <= cjh_text_region_node_length (target));
-      DEBUG_VALIDATE (target, cjh_text_region_node_get_parent (target));
+      DEBUG_VALIDATE (region, target, cjh_text_region_node_get_parent (target));
     }
 
   i = 0;
@@ -778,6 +832,8 @@ inserted:
 
   g_assert (target != NULL);
 
+  cjh_text_region_sync_tracked (region, target);
+
   /*
    * Now update each of the parent nodes in the tree so that they have
    * an apprporiate length along with the child pointer. This allows them
@@ -799,7 +855,7 @@ inserted:
       g_assert_not_reached ();
 
     found_in_parent:
-      DEBUG_VALIDATE (node, parent);
+      DEBUG_VALIDATE (region, node, parent);
       continue;
     }
 
@@ -837,6 +893,121 @@ _cjh_text_region_get_length (CjhTextRegion *region)
   return region->length;
 }
 
+/*
+ * _cjh_text_region_set_tracked:
+ * @region: an empty region
+ * @data: the data pointer to track
+ *
+ * Sets the data pointer of the runs which the region keeps a count of in
+ * every branch of the tree. That is what allows
+ * _cjh_text_region_get_tracked_length() and _cjh_text_region_find_tracked()
+ * to avoid walking all of the runs.
+ *
+ * By default runs with a %NULL data pointer are tracked.
+ */
+void
+_cjh_text_region_set_tracked (CjhTextRegion *region,
+                              gpointer       data)
+{
+  g_return_if_fail (region != NULL);
+  g_return_if_fail (region->length == 0);
+
+  region->tracked_data = data;
+}
+
+gpointer
+_cjh_text_region_get_tracked (CjhTextRegion *region)
+{
+  g_return_val_if_fail (region != NULL, NULL);
+
+  return region->tracked_data;
+}
+
+/*
+ * _cjh_text_region_get_tracked_length:
+ * @region: a #CjhTextRegion
+ *
+ * Gets the number of characters within runs containing the tracked data
+ * pointer without iterating the runs.
+ *
+ * Returns: the tracked length
+ */
+gsize
+_cjh_text_region_get_tracked_length (CjhTextRegion *region)
+{
+  g_return_val_if_fail (region != NULL, 0);
+
+  return cjh_text_region_node_tracked (region, &region->root);
+}
+
+static gboolean
+cjh_text_region_node_find_tracked (CjhTextRegion     *region,
+                                   CjhTextRegionNode *node,
+                                   gsize              position,
+                                   gsize              offset,
+                                   gsize             *begin,
+                                   gsize             *end)
+{
+  if (cjh_text_region_node_is_leaf (node))
+    {
+      SORTED_ARRAY_FOREACH (&node->leaf.runs, CjhTextRegionRun, run, {
+        if (position + run->length > offset &&
+            run->data == region->tracked_data)
+          {
+            *begin = MAX (position, offset);
+            *end = position + run->length;
+            return TRUE;
+          }
+
+        position += run->length;
+      });
+    }
+  else
+    {
+      /* Only the child containing @offset may fail to have a tracked run
+       * after @offset, so this descends at most twice per level.
+       */
+      SORTED_ARRAY_FOREACH (&node->branch.children, CjhTextRegionChild, child, {
+        if (child->tracked > 0 &&
+            position + child->length > offset &&
+            cjh_text_region_node_find_tracked (region, child->node, position, offset, begin, end))
+          return TRUE;
+
+        position += child->length;
+      });
+    }
+
+  return FALSE;
+}
+
+/*
+ * _cjh_text_region_find_tracked:
+ * @region: a #CjhTextRegion
+ * @offset: the offset to start searching from
+ * @begin: (out): location for the beginning of the run
+ * @end: (out): location for the end of the run
+ *
+ * Locates the first run at or after @offset containing the tracked data
+ * pointer. @begin is clamped to @offset when the run starts before it.
+ *
+ * Returns: %TRUE if a run was found and @begin and @end were set
+ */
+gboolean
+_cjh_text_region_find_tracked (CjhTextRegion *region,
+                               gsize          offset,
+                               gsize         *begin,
+                               gsize         *end)
+{
+  g_return_val_if_fail (region != NULL, FALSE);
+  g_return_val_if_fail (begin != NULL, FALSE);
+  g_return_val_if_fail (end != NULL, FALSE);
+
+  if (offset >= region->length)
+    return FALSE;
+
+  return cjh_text_region_node_find_tracked (region, &region->root, 0, offset, begin, end);
+}
+
 static void
 cjh_text_region_branch_compact (CjhTextRegion     *region,
                                 CjhTextRegionNode *node)
@@ -846,7 +1017,9 @@ cjh_text_region_branch_compact (CjhTextRegion     *region,
   CjhTextRegionNode *right;
   CjhTextRegionNode *target;
   gsize added = 0;
+  gsize added_tracked = 0;
   gsize length;
+  gsize tracked;
 
   g_assert (region != NULL);
   g_assert (node != NULL);
@@ -856,6 +1029,7 @@ cjh_text_region_branch_compact (CjhTextRegion     *region,
     if (child->node == NULL)
       {
         g_assert (child->length == 0);
+        g_assert (child->tracked == 0);
         SORTED_ARRAY_FOREACH_REMOVE (&node->branch.children);
       }
   });
@@ -888,6 +1062,7 @@ cjh_text_region_branch_compact (CjhTextRegion     *region,
 
             descendant->node = NULL;
             descendant->length = 0;
+            descendant->tracked = 0;
 
             goto compact_parent;
           }
@@ -903,7 +1078,8 @@ cjh_text_region_branch_compact (CjhTextRegion     *region,
     return;
 
   length = cjh_text_region_node_length (node);
-  cjh_text_region_subtract_from_parents (region, node, length);
+  tracked = cjh_text_region_node_tracked (region, node);
+  cjh_text_region_subtract_from_parents (region, node, length, tracked);
 
   /* Remove this node, we'll reparent the children with edges */
   SORTED_ARRAY_FOREACH (&parent->branch.children, CjhTextRegionChild, child, {
@@ -937,21 +1113,24 @@ found:
       SORTED_ARRAY_FOREACH_REVERSE (&node->branch.children, CjhTextRegionChild, child, {
         if (SORTED_ARRAY_LENGTH (&target->branch.children) >= CJH_TEXT_REGION_MAX_BRANCHES-1)
           {
-            cjh_text_region_add_to_parents (region, target, added);
+            cjh_text_region_add_to_parents (region, target, added, added_tracked);
             added = 0;
+            added_tracked = 0;
             cjh_text_region_branch_split (region, target);
             g_assert (target->branch.prev == left);
           }
 
         cjh_text_region_node_set_parent (child->node, target);
         added += child->length;
+        added_tracked += child->tracked;
         SORTED_ARRAY_PUSH_HEAD (&target->branch.children, *child);
 
         child->node = NULL;
         child->length = 0;
+        child->tracked = 0;
       });
 
-      cjh_text_region_add_to_parents (region, target, added);
+      cjh_text_region_add_to_parents (region, target, added, added_tracked);
     }
   else
     {
@@ -962,25 +1141,28 @@ found:
       SORTED_ARRAY_FOREACH (&node->branch.children, CjhTextRegionChild, child, {
         if (SORTED_ARRAY_LENGTH (&target->branch.children) >= CJH_TEXT_REGION_MAX_BRANCHES-1)
           {
-            cjh_text_region_add_to_parents (region, target, added);
+            cjh_text_region_add_to_parents (region, target, added, added_tracked);
             added = 0;
+            added_tracked = 0;
             target = cjh_text_region_branch_split (region, target);
           }
 
         cjh_text_region_node_set_parent (child->node, target);
         added += child->length;
+        added_tracked += child->tracked;
         SORTED_ARRAY_PUSH_TAIL (&target->branch.children, *child);
 
         child->node = NULL;
         child->length = 0;
+        child->tracked = 0;
       });
 
-      cjh_text_region_add_to_parents (region, target, added);
+      cjh_text_region_add_to_parents (region, target, added, added_tracked);
     }
 
-  DEBUG_VALIDATE (left, cjh_text_region_node_get_parent (left));
-  DEBUG_VALIDATE (right, cjh_text_region_node_get_parent (right));
-  DEBUG_VALIDATE (parent, cjh_text_region_node_get_parent (parent));
+  DEBUG_VALIDATE (region, left, cjh_text_region_node_get_parent (left));
+  DEBUG_VALIDATE (region, right, cjh_text_region_node_get_parent (right));
+  DEBUG_VALIDATE (region, parent, cjh_text_region_node_get_parent (parent));
 
 compact_parent:
   if (parent != NULL)
@@ -998,6 +1180,7 @@ cjh_text_region_leaf_compact (CjhTextRegion     *region,
   CjhTextRegionNode *left;
   CjhTextRegionNode *right;
   gsize added = 0;
+  gsize added_tracked = 0;
 
   g_assert (region != NULL);
   g_assert (node != NULL);
@@ -1020,8 +1203,9 @@ cjh_text_region_leaf_compact (CjhTextRegion     *region,
   SORTED_ARRAY_FOREACH (&parent->branch.children, CjhTextRegionChild, child, {
     if (child->node == node)
       {
-        cjh_text_region_subtract_from_parents (region, node, child->length);
+        cjh_text_region_subtract_from_parents (region, node, child->length, child->tracked);
         g_assert (child->length == 0);
+        g_assert (child->tracked == 0);
         SORTED_ARRAY_FOREACH_REMOVE (&parent->branch.children);
         goto found;
       }
@@ -1050,17 +1234,19 @@ found:
       SORTED_ARRAY_FOREACH_REVERSE (&node->leaf.runs, CjhTextRegionRun, run, {
         if (SORTED_ARRAY_LENGTH (&target->leaf.runs) >= CJH_TEXT_REGION_MAX_RUNS-1)
           {
-            cjh_text_region_add_to_parents (region, target, added);
+            cjh_text_region_add_to_parents (region, target, added, added_tracked);
             added = 0;
+            added_tracked = 0;
             cjh_text_region_node_split (region, target);
             g_assert (target->leaf.prev == left);
           }
 
         added += run->length;
+        added_tracked += cjh_text_region_run_tracked (region, run);
         SORTED_ARRAY_PUSH_HEAD (&target->leaf.runs, *run);
       });
 
-      cjh_text_region_add_to_parents (region, target, added);
+      cjh_text_region_add_to_parents (region, target, added, added_tracked);
     }
   else
     {
@@ -1071,8 +1257,9 @@ found:
       SORTED_ARRAY_FOREACH (&node->leaf.runs, CjhTextRegionRun, run, {
         if (SORTED_ARRAY_LENGTH (&target->leaf.runs) >= CJH_TEXT_REGION_MAX_RUNS-1)
           {
-            cjh_text_region_add_to_parents (region, target, added);
+            cjh_text_region_add_to_parents (region, target, added, added_tracked);
             added = 0;
+            added_tracked = 0;
 
             target = cjh_text_region_node_split (region, target);
 
@@ -1080,15 +1267,16 @@ found:
           }
 
         added += run->length;
+        added_tracked += cjh_text_region_run_tracked (region, run);
         SORTED_ARRAY_PUSH_TAIL (&target->leaf.runs, *run);
       });
 
-      cjh_text_region_add_to_parents (region, target, added);
+      cjh_text_region_add_to_parents (region, target, added, added_tracked);
     }
 
-  DEBUG_VALIDATE (left, cjh_text_region_node_get_parent (left));
-  DEBUG_VALIDATE (right, cjh_text_region_node_get_parent (right));
-  DEBUG_VALIDATE (parent, cjh_text_region_node_get_parent (parent));
+  DEBUG_VALIDATE (region, left, cjh_text_region_node_get_parent (left));
+  DEBUG_VALIDATE (region, right, cjh_text_region_node_get_parent (right));
+  DEBUG_VALIDATE (region, parent, cjh_text_region_node_get_parent (parent));
 
   cjh_text_region_branch_compact (region, parent);
 
@@ -1244,7 +1432,8 @@ _cjh_text_region_remove (CjhTextRegion *region,
   });
 
   region->length -= length - to_remove;
-  cjh_text_region_subtract_from_parents (region, target, length - to_remove);
+  cjh_text_region_subtract_from_parents (region, target, length - to_remove, 0);
+  cjh_text_region_sync_tracked (region, target);
 
   if (SORTED_ARRAY_LENGTH (&target->leaf.runs) < CJH_TEXT_REGION_MIN_RUNS)
     cjh_text_region_leaf_compact (region, target);
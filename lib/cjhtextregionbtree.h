@@ -459,6 +459,8 @@ struct _CjhTextRegionChild
 {
   CjhTextRegionNode *node;
   gsize              length;
+  /* Length of the runs below @node with the region's tracked data */
+  gsize              tracked;
 };
 
 struct _CjhTextRegionBranch
@@ -493,6 +495,7 @@ struct _CjhTextRegion
   gsize length;
   CjhTextRegionNode *cached_result;
   gsize cached_result_offset;
+  gpointer tracked_data;
 };
 
 #define TAG(ptr,val) GSIZE_TO_POINTER(GPOINTER_TO_SIZE(ptr)|(gsize)val)
@@ -544,6 +547,37 @@ cjh_text_region_node_length (CjhTextRegionNode *node)
   return length;
 }
 
+static inline gsize
+cjh_text_region_run_tracked (CjhTextRegion          *region,
+                             const CjhTextRegionRun *run)
+{
+  return run->data == region->tracked_data ? run->length : 0;
+}
+
+static inline gsize
+cjh_text_region_node_tracked (CjhTextRegion     *region,
+                              CjhTextRegionNode *node)
+{
+  gsize tracked = 0;
+
+  g_assert (node != NULL);
+
+  if (cjh_text_region_node_is_leaf (node))
+    {
+      SORTED_ARRAY_FOREACH (&node->leaf.runs, CjhTextRegionRun, run, {
+        tracked += cjh_text_region_run_tracked (region, run);
+      });
+    }
+  else
+    {
+      SORTED_ARRAY_FOREACH (&node->branch.children, CjhTextRegionChild, child, {
+        tracked += child->tracked;
+      });
+    }
+
+  return tracked;
+}
+
 static inline CjhTextRegionNode *
 _cjh_text_region_get_first_leaf (CjhTextRegion *self)
 {
@@ -91,29 +91,37 @@ typedef void (*CjhTextRegionSplitFunc)     (gsize                     offset,
                                             CjhTextRegionRun         *left,
                                             CjhTextRegionRun         *right);
 
-CjhTextRegion *_cjh_text_region_new              (CjhTextRegionJoinFunc     join_func,
-                                                  CjhTextRegionSplitFunc    split_func);
-void           _cjh_text_region_insert           (CjhTextRegion            *region,
-                                                  gsize                     offset,
-                                                  gsize                     length,
-                                                  gpointer                  data);
-void           _cjh_text_region_replace          (CjhTextRegion            *region,
-                                                  gsize                     offset,
-                                                  gsize                     length,
-                                                  gpointer                  data);
-void           _cjh_text_region_remove           (CjhTextRegion            *region,
-                                                  gsize                     offset,
-                                                  gsize                     length);
-guint          _cjh_text_region_get_length       (CjhTextRegion            *region);
-void           _cjh_text_region_foreach          (CjhTextRegion            *region,
-                                                  CjhTextRegionForeachFunc  func,
-                                                  gpointer                  user_data);
-void           _cjh_text_region_foreach_in_range (CjhTextRegion            *region,
-                                                  gsize                     begin,
-                                                  gsize                     end,
-                                                  CjhTextRegionForeachFunc  func,
-                                                  gpointer                  user_data);
-void           _cjh_text_region_free             (CjhTextRegion            *region);
+CjhTextRegion *_cjh_text_region_new                (CjhTextRegionJoinFunc     join_func,
+                                                    CjhTextRegionSplitFunc    split_func);
+void           _cjh_text_region_insert             (CjhTextRegion            *region,
+                                                    gsize                     offset,
+                                                    gsize                     length,
+                                                    gpointer                  data);
+void           _cjh_text_region_replace            (CjhTextRegion            *region,
+                                                    gsize                     offset,
+                                                    gsize                     length,
+                                                    gpointer                  data);
+void           _cjh_text_region_remove             (CjhTextRegion            *region,
+                                                    gsize                     offset,
+                                                    gsize                     length);
+guint          _cjh_text_region_get_length         (CjhTextRegion            *region);
+void           _cjh_text_region_set_tracked        (CjhTextRegion            *region,
+                                                    gpointer                  data);
+gpointer       _cjh_text_region_get_tracked        (CjhTextRegion            *region);
+gsize          _cjh_text_region_get_tracked_length (CjhTextRegion            *region);
+gboolean       _cjh_text_region_find_tracked       (CjhTextRegion            *region,
+                                                    gsize                     offset,
+                                                    gsize                    *begin,
+                                                    gsize                    *end);
+void           _cjh_text_region_foreach            (CjhTextRegion            *region,
+                                                    CjhTextRegionForeachFunc  func,
+                                                    gpointer                  user_data);
+void           _cjh_text_region_foreach_in_range   (CjhTextRegion            *region,
+                                                    gsize                     begin,
+                                                    gsize                     end,
+                                                    CjhTextRegionForeachFunc  func,
+                                                    gpointer                  user_data);
+void           _cjh_text_region_free               (CjhTextRegion            *region);
 
 static inline gboolean
 _cjh_text_region_get_run_at_offset_cb (gsize                   offset,
@@ -94,6 +94,36 @@ spelling_enchant_dictionary_contains_word (SpellingDictionary *dictionary,
   return enchant_dict_check (self->native, word, word_len) == 0;
 }
 
+static void
+spelling_enchant_dictionary_check_words (SpellingDictionary     *dictionary,
+                                         const char             *text,
+                                         const SpellingBoundary *positions,
+                                         guint                   n_positions,
+                                         GtkBitset              *mistakes)
+{
+  SpellingEnchantDictionary *self = (SpellingEnchantDictionary *)dictionary;
+  EnchantDict *native;
+
+  g_assert (SPELLING_IS_ENCHANT_DICTIONARY (self));
+  g_assert (text != NULL);
+  g_assert (positions != NULL || n_positions == 0);
+  g_assert (mistakes != NULL);
+
+  native = self->native;
+
+  for (guint i = 0; i < n_positions; i++)
+    {
+      const char *word = &text[positions[i].byte_offset];
+      gsize word_len = positions[i].byte_length;
+
+      if (word_is_number (word, word_len))
+        continue;
+
+      if (enchant_dict_check (native, word, word_len) != 0)
+        gtk_bitset_add (mistakes, i);
+    }
+}
+
 static char **
 strv_copy_n (const char * const *strv,
              gsize               n)
@@ -322,6 +352,7 @@ spelling_enchant_dictionary_class_init (SpellingEnchantDictionaryClass *klass)
   object_class->set_property = spelling_enchant_dictionary_set_property;
 
   dictionary_class->contains_word = spelling_enchant_dictionary_contains_word;
+  dictionary_class->check_words = spelling_enchant_dictionary_check_words;
   dictionary_class->list_corrections = spelling_enchant_dictionary_list_corrections;
   dictionary_class->add_word = spelling_enchant_dictionary_add_word;
   dictionary_class->ignore_word = spelling_enchant_dictionary_ignore_word;
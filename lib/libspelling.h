@@ -28,9 +28,11 @@ G_BEGIN_DECLS
 #define LIBSPELLING_INSIDE
 # include "spelling-checker.h"
 # include "spelling-dictionary.h"
+# include "spelling-document.h"
 # include "spelling-init.h"
 # include "spelling-language.h"
 # include "spelling-provider.h"
+# include "spelling-stats.h"
 # include "spelling-text-buffer-adapter.h"
 # include "spelling-types.h"
 # include "spelling-version.h"
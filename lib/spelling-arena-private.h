@@ -0,0 +1,54 @@
+/* spelling-arena-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SpellingArenaBlock SpellingArenaBlock;
+
+/* A bump allocator for scratch memory which is released all at once. The
+ * arena grows by whole blocks so that a job never needs to allocate per
+ * word. Allocations larger than a block get a block of their own.
+ */
+typedef struct _SpellingArena
+{
+  SpellingArenaBlock *blocks;
+  gsize               block_size;
+} SpellingArena;
+
+void     spelling_arena_init   (SpellingArena *self,
+                                gsize          block_size);
+void     spelling_arena_clear  (SpellingArena *self);
+void     spelling_arena_steal  (SpellingArena *self,
+                                SpellingArena *from);
+gpointer spelling_arena_alloc  (SpellingArena *self,
+                                gsize          size);
+gpointer spelling_arena_alloc0 (SpellingArena *self,
+                                gsize          size);
+
+#define spelling_arena_new(arena, Type, n) \
+  ((Type *)spelling_arena_alloc ((arena), sizeof (Type) * (n)))
+#define spelling_arena_new0(arena, Type, n) \
+  ((Type *)spelling_arena_alloc0 ((arena), sizeof (Type) * (n)))
+
+G_END_DECLS
@@ -0,0 +1,139 @@
+/* spelling-arena.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "spelling-arena-private.h"
+
+#define ARENA_ALIGN (2 * sizeof (gpointer))
+
+struct _SpellingArenaBlock
+{
+  SpellingArenaBlock *next;
+  gsize               size;
+  gsize               used;
+  gsize               padding;
+  char                data[];
+};
+
+void
+spelling_arena_init (SpellingArena *self,
+                     gsize          block_size)
+{
+  g_return_if_fail (self != NULL);
+
+  self->blocks = NULL;
+  self->block_size = MAX (block_size, 256);
+}
+
+void
+spelling_arena_clear (SpellingArena *self)
+{
+  g_return_if_fail (self != NULL);
+
+  while (self->blocks != NULL)
+    {
+      SpellingArenaBlock *block = self->blocks;
+
+      self->blocks = block->next;
+      g_free (block);
+    }
+}
+
+/* Moves every block of @from into @self, leaving @from empty. The current
+ * block of @self stays in front so its remaining space is still used.
+ */
+void
+spelling_arena_steal (SpellingArena *self,
+                      SpellingArena *from)
+{
+  SpellingArenaBlock *tail;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (from != NULL);
+
+  if (from->blocks == NULL)
+    return;
+
+  if (self->blocks == NULL)
+    {
+      self->blocks = g_steal_pointer (&from->blocks);
+      return;
+    }
+
+  tail = from->blocks;
+  while (tail->next != NULL)
+    tail = tail->next;
+
+  tail->next = self->blocks->next;
+  self->blocks->next = g_steal_pointer (&from->blocks);
+}
+
+gpointer
+spelling_arena_alloc (SpellingArena *self,
+                      gsize          size)
+{
+  SpellingArenaBlock *block;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
+  size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+  if G_LIKELY (self->blocks != NULL &&
+               self->blocks->size - self->blocks->used >= size)
+    {
+      block = self->blocks;
+      block->used += size;
+      return &block->data[block->used - size];
+    }
+
+  block = g_malloc (sizeof *block + MAX (size, self->block_size));
+  block->size = MAX (size, self->block_size);
+  block->used = size;
+
+  /* Oversized allocations go behind the current block so that its
+   * remaining space can still be used.
+   */
+  if (size > self->block_size && self->blocks != NULL)
+    {
+      block->next = self->blocks->next;
+      self->blocks->next = block;
+    }
+  else
+    {
+      block->next = self->blocks;
+      self->blocks = block;
+    }
+
+  return &block->data[0];
+}
+
+gpointer
+spelling_arena_alloc0 (SpellingArena *self,
+                       gsize          size)
+{
+  gpointer ret = spelling_arena_alloc (self, size);
+
+  memset (ret, 0, size);
+
+  return ret;
+}
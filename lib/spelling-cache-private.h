@@ -0,0 +1,63 @@
+/* spelling-cache-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "spelling-job-private.h"
+
+G_BEGIN_DECLS
+
+char            *spelling_cache_dup_path    (const char             *code,
+                                             const char             *text,
+                                             gsize                   text_len);
+SpellingMistake *spelling_cache_load        (const char             *path,
+                                             guint                   length,
+                                             guint                  *n_mistakes);
+void             spelling_cache_load_async  (const char             *code,
+                                             char                   *text,
+                                             guint                   length,
+                                             GCancellable           *cancellable,
+                                             GAsyncReadyCallback     callback,
+                                             gpointer                user_data);
+SpellingMistake *spelling_cache_load_finish (GAsyncResult           *result,
+                                             char                  **path,
+                                             guint                  *n_mistakes,
+                                             GError                **error);
+gboolean         spelling_cache_save        (const char             *path,
+                                             guint                   length,
+                                             const SpellingMistake  *mistakes,
+                                             guint                   n_mistakes,
+                                             GError                **error);
+void             spelling_cache_save_async  (const char             *code,
+                                             char                   *text,
+                                             guint                   length,
+                                             GArray                 *mistakes,
+                                             const char             *previous,
+                                             GAsyncReadyCallback     callback,
+                                             gpointer                user_data);
+char            *spelling_cache_save_finish (GAsyncResult           *result,
+                                             GError                **error);
+void             spelling_cache_evict       (const char             *dir,
+                                             goffset                 max_size,
+                                             GTimeSpan               max_age);
+
+G_END_DECLS
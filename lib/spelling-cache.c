@@ -0,0 +1,465 @@
+/* spelling-cache.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "spelling-cache-private.h"
+
+/* The cache keeps the mistakes found in a text once it was checked
+ * completely, so that they can be shown right away the next time the
+ * same text is opened. Files are named after a hash of the dictionary
+ * code and the text, so any change to either simply misses the cache.
+ * Restored mistakes are verified by checking the text again, which only
+ * changes the tags where the results differ.
+ */
+#define CACHE_FORMAT  "(ua(uu))"
+#define CACHE_VERSION "1"
+#define CACHE_SUFFIX  ".cache"
+
+/* Every save trims the directory to CACHE_MAX_SIZE bytes, removing the
+ * least recently used files first, and drops files not used for
+ * CACHE_MAX_AGE. Loading a file counts as using it.
+ */
+#define CACHE_MAX_SIZE (16 * 1024 * 1024)
+#define CACHE_MAX_AGE  (30 * G_TIME_SPAN_DAY)
+
+typedef struct
+{
+  char   *code;
+  char   *text;
+  guint   length;
+  GArray *mistakes;
+  char   *previous;
+} SaveState;
+
+typedef struct
+{
+  char            *code;
+  char            *text;
+  guint            length;
+  char            *path;
+  SpellingMistake *mistakes;
+  guint            n_mistakes;
+} LoadState;
+
+typedef struct
+{
+  char   *path;
+  gint64  mtime;
+  goffset size;
+} CacheFile;
+
+static void
+save_state_free (SaveState *state)
+{
+  g_clear_pointer (&state->code, g_free);
+  g_clear_pointer (&state->text, g_free);
+  g_clear_pointer (&state->mistakes, g_array_unref);
+  g_clear_pointer (&state->previous, g_free);
+  g_free (state);
+}
+
+static void
+load_state_free (LoadState *state)
+{
+  g_clear_pointer (&state->code, g_free);
+  g_clear_pointer (&state->text, g_free);
+  g_clear_pointer (&state->path, g_free);
+  g_clear_pointer (&state->mistakes, g_free);
+  g_free (state);
+}
+
+static void
+cache_file_clear (gpointer data)
+{
+  CacheFile *file = data;
+
+  g_clear_pointer (&file->path, g_free);
+}
+
+static int
+cache_file_compare (gconstpointer a,
+                    gconstpointer b)
+{
+  const CacheFile *file_a = a;
+  const CacheFile *file_b = b;
+
+  if (file_a->mtime < file_b->mtime)
+    return -1;
+  else if (file_a->mtime > file_b->mtime)
+    return 1;
+  else
+    return 0;
+}
+
+/* Returns the path of the cache file for @text checked with the
+ * dictionary named @code.
+ */
+char *
+spelling_cache_dup_path (const char *code,
+                         const char *text,
+                         gsize       text_len)
+{
+  g_autoptr(GChecksum) checksum = NULL;
+  g_autofree char *name = NULL;
+
+  g_return_val_if_fail (code != NULL, NULL);
+  g_return_val_if_fail (text != NULL || text_len == 0, NULL);
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *)CACHE_VERSION, sizeof CACHE_VERSION);
+  g_checksum_update (checksum, (const guchar *)code, strlen (code) + 1);
+  g_checksum_update (checksum, (const guchar *)text, text_len);
+
+  name = g_strconcat (g_checksum_get_string (checksum), CACHE_SUFFIX, NULL);
+
+  return g_build_filename (g_get_user_cache_dir (), "libspelling", name, NULL);
+}
+
+/* Returns the mistakes stored at @path for a text of @length characters,
+ * or %NULL if there are none or the file cannot be trusted.
+ */
+SpellingMistake *
+spelling_cache_load (const char *path,
+                     guint       length,
+                     guint      *n_mistakes)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariantIter) iter = NULL;
+  g_autofree SpellingMistake *mistakes = NULL;
+  char *contents = NULL;
+  gsize contents_len = 0;
+  guint cached_length;
+  guint offset;
+  guint mistake_len;
+  guint end = 0;
+  guint n = 0;
+
+  g_return_val_if_fail (path != NULL, NULL);
+  g_return_val_if_fail (n_mistakes != NULL, NULL);
+
+  *n_mistakes = 0;
+
+  if (!g_file_get_contents (path, &contents, &contents_len, NULL))
+    return NULL;
+
+  variant = g_variant_new_from_data (G_VARIANT_TYPE (CACHE_FORMAT),
+                                     contents, contents_len, FALSE,
+                                     g_free, contents);
+  g_variant_ref_sink (variant);
+
+  /* The file may have been truncated or written by someone else */
+  if (!g_variant_is_normal_form (variant))
+    return NULL;
+
+  g_variant_get (variant, CACHE_FORMAT, &cached_length, &iter);
+
+  if (cached_length != length)
+    return NULL;
+
+  mistakes = g_new (SpellingMistake, g_variant_iter_n_children (iter));
+
+  while (g_variant_iter_next (iter, "(uu)", &offset, &mistake_len))
+    {
+      /* Mistakes must be sorted and within the text */
+      if (offset < end || mistake_len == 0 || mistake_len > length - offset)
+        return NULL;
+
+      mistakes[n].offset = offset;
+      mistakes[n].length = mistake_len;
+      mistakes[n].hash = 0;
+      end = offset + mistake_len;
+      n++;
+    }
+
+  if (n == 0)
+    return NULL;
+
+  *n_mistakes = n;
+
+  return g_steal_pointer (&mistakes);
+}
+
+gboolean
+spelling_cache_save (const char             *path,
+                     guint                   length,
+                     const SpellingMistake  *mistakes,
+                     guint                   n_mistakes,
+                     GError                **error)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autofree char *dir = NULL;
+  GVariantBuilder builder;
+
+  g_return_val_if_fail (path != NULL, FALSE);
+  g_return_val_if_fail (mistakes != NULL || n_mistakes == 0, FALSE);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(uu)"));
+  for (guint m = 0; m < n_mistakes; m++)
+    g_variant_builder_add (&builder, "(uu)", mistakes[m].offset, mistakes[m].length);
+
+  variant = g_variant_ref_sink (g_variant_new ("(u@a(uu))",
+                                               length,
+                                               g_variant_builder_end (&builder)));
+
+  dir = g_path_get_dirname (path);
+
+  if (g_mkdir_with_parents (dir, 0700) != 0)
+    {
+      int errsv = errno;
+      g_set_error (error,
+                   G_FILE_ERROR,
+                   g_file_error_from_errno (errsv),
+                   "Failed to create %s: %s",
+                   dir, g_strerror (errsv));
+      return FALSE;
+    }
+
+  return g_file_set_contents_full (path,
+                                   g_variant_get_data (variant),
+                                   g_variant_get_size (variant),
+                                   G_FILE_SET_CONTENTS_CONSISTENT,
+                                   0600,
+                                   error);
+}
+
+/* Removes cache files in @dir which were not used for @max_age
+ * microseconds, then the least recently used ones until the rest
+ * fits in @max_size bytes.
+ */
+void
+spelling_cache_evict (const char *dir,
+                      goffset     max_size,
+                      GTimeSpan   max_age)
+{
+  g_autoptr(GArray) files = NULL;
+  g_autoptr(GDir) gdir = NULL;
+  const char *name;
+  goffset total = 0;
+  gint64 now;
+
+  g_return_if_fail (dir != NULL);
+
+  if (!(gdir = g_dir_open (dir, 0, NULL)))
+    return;
+
+  files = g_array_new (FALSE, FALSE, sizeof (CacheFile));
+  g_array_set_clear_func (files, cache_file_clear);
+  now = g_get_real_time ();
+
+  while ((name = g_dir_read_name (gdir)))
+    {
+      g_autofree char *path = NULL;
+      GStatBuf st;
+      CacheFile file;
+
+      if (!g_str_has_suffix (name, CACHE_SUFFIX))
+        continue;
+
+      path = g_build_filename (dir, name, NULL);
+
+      if (g_stat (path, &st) != 0)
+        continue;
+
+      if (now - (gint64)st.st_mtime * G_USEC_PER_SEC > max_age)
+        {
+          g_unlink (path);
+          continue;
+        }
+
+      file.path = g_steal_pointer (&path);
+      file.mtime = st.st_mtime;
+      file.size = st.st_size;
+      total += file.size;
+
+      g_array_append_val (files, file);
+    }
+
+  if (total <= max_size)
+    return;
+
+  g_array_sort (files, cache_file_compare);
+
+  for (guint i = 0; i < files->len && total > max_size; i++)
+    {
+      const CacheFile *file = &g_array_index (files, CacheFile, i);
+
+      if (g_unlink (file->path) == 0)
+        total -= file->size;
+    }
+}
+
+static void
+spelling_cache_save_worker (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  SaveState *state = task_data;
+  g_autoptr(GError) error = NULL;
+  g_autofree char *path = NULL;
+  g_autofree char *dir = NULL;
+
+  path = spelling_cache_dup_path (state->code, state->text, strlen (state->text));
+
+  if (!spelling_cache_save (path,
+                            state->length,
+                            (const SpellingMistake *)(gpointer)state->mistakes->data,
+                            state->mistakes->len,
+                            &error))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  /* The text changed since the previous file was written, which would
+   * only be found again by undoing those changes.
+   */
+  if (state->previous != NULL && g_strcmp0 (state->previous, path) != 0)
+    g_unlink (state->previous);
+
+  dir = g_path_get_dirname (path);
+  spelling_cache_evict (dir, CACHE_MAX_SIZE, CACHE_MAX_AGE);
+
+  g_task_return_pointer (task, g_steal_pointer (&path), g_free);
+}
+
+/* Hashes @text and writes the cache file on a thread, removing the file
+ * at @previous if it differs. Takes ownership of @text and @mistakes.
+ */
+void
+spelling_cache_save_async (const char          *code,
+                           char                *text,
+                           guint                length,
+                           GArray              *mistakes,
+                           const char          *previous,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  SaveState *state;
+
+  g_return_if_fail (code != NULL);
+  g_return_if_fail (text != NULL);
+  g_return_if_fail (mistakes != NULL);
+
+  state = g_new0 (SaveState, 1);
+  state->code = g_strdup (code);
+  state->text = text;
+  state->length = length;
+  state->mistakes = mistakes;
+  state->previous = g_strdup (previous);
+
+  task = g_task_new (NULL, NULL, callback, user_data);
+  g_task_set_source_tag (task, spelling_cache_save_async);
+  g_task_set_task_data (task, state, (GDestroyNotify)save_state_free);
+  g_task_run_in_thread (task, spelling_cache_save_worker);
+}
+
+/* Returns the path of the file which was written */
+char *
+spelling_cache_save_finish (GAsyncResult  *result,
+                            GError       **error)
+{
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+spelling_cache_load_worker (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  LoadState *state = task_data;
+
+  state->path = spelling_cache_dup_path (state->code, state->text, strlen (state->text));
+  state->mistakes = spelling_cache_load (state->path, state->length, &state->n_mistakes);
+
+  /* Keep it from being evicted as unused */
+  if (state->mistakes != NULL)
+    g_utime (state->path, NULL);
+
+  g_task_return_boolean (task, state->mistakes != NULL);
+}
+
+/* Hashes @text and loads the mistakes cached for it on a thread. Takes
+ * ownership of @text.
+ */
+void
+spelling_cache_load_async (const char          *code,
+                           char                *text,
+                           guint                length,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  LoadState *state;
+
+  g_return_if_fail (code != NULL);
+  g_return_if_fail (text != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  state = g_new0 (LoadState, 1);
+  state->code = g_strdup (code);
+  state->text = text;
+  state->length = length;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, spelling_cache_load_async);
+  g_task_set_task_data (task, state, (GDestroyNotify)load_state_free);
+  g_task_set_return_on_cancel (task, TRUE);
+  g_task_run_in_thread (task, spelling_cache_load_worker);
+}
+
+/* Returns the mistakes which were cached, or %NULL if there are none or
+ * loading was cancelled. @path is set to the file they came from.
+ */
+SpellingMistake *
+spelling_cache_load_finish (GAsyncResult  *result,
+                            char         **path,
+                            guint         *n_mistakes,
+                            GError       **error)
+{
+  LoadState *state;
+
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+  g_return_val_if_fail (path != NULL, NULL);
+  g_return_val_if_fail (n_mistakes != NULL, NULL);
+
+  *path = NULL;
+  *n_mistakes = 0;
+
+  if (!g_task_propagate_boolean (G_TASK (result), error))
+    return NULL;
+
+  state = g_task_get_task_data (G_TASK (result));
+  *path = g_steal_pointer (&state->path);
+  *n_mistakes = state->n_mistakes;
+
+  return g_steal_pointer (&state->mistakes);
+}
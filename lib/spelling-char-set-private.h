@@ -0,0 +1,75 @@
+/* spelling-char-set-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A compiled form of a UTF-8 string of characters such as the extra word
+ * characters of a dictionary. ASCII is looked up in a bitmap and anything
+ * else with a binary search over a sorted array of code points.
+ */
+typedef struct _SpellingCharSet
+{
+  guint32   ascii[4];
+  guint     n_chars;
+  gunichar *chars;
+} SpellingCharSet;
+
+SpellingCharSet *spelling_char_set_new   (const char      *utf8);
+SpellingCharSet *spelling_char_set_ref   (SpellingCharSet *self);
+void             spelling_char_set_unref (SpellingCharSet *self);
+
+static inline gboolean
+spelling_char_set_contains (const SpellingCharSet *self,
+                            gunichar               ch)
+{
+  guint lo;
+  guint hi;
+
+  if (self == NULL)
+    return FALSE;
+
+  if (ch < 0x80)
+    return (self->ascii[ch >> 5] & (1u << (ch & 0x1F))) != 0;
+
+  lo = 0;
+  hi = self->n_chars;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (self->chars[mid] == ch)
+        return TRUE;
+      else if (self->chars[mid] < ch)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return FALSE;
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (SpellingCharSet, spelling_char_set_unref)
+
+G_END_DECLS
@@ -0,0 +1,104 @@
+/* spelling-char-set.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "spelling-char-set-private.h"
+
+static int
+compare_unichar (gconstpointer a,
+                 gconstpointer b)
+{
+  gunichar ca = *(const gunichar *)a;
+  gunichar cb = *(const gunichar *)b;
+
+  if (ca < cb)
+    return -1;
+  else if (ca > cb)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+spelling_char_set_finalize (gpointer data)
+{
+  SpellingCharSet *self = data;
+
+  g_clear_pointer (&self->chars, g_free);
+  self->n_chars = 0;
+}
+
+SpellingCharSet *
+spelling_char_set_new (const char *utf8)
+{
+  SpellingCharSet *self;
+  g_autoptr(GArray) chars = NULL;
+
+  self = g_atomic_rc_box_new0 (SpellingCharSet);
+
+  if (utf8 == NULL)
+    return self;
+
+  chars = g_array_new (FALSE, FALSE, sizeof (gunichar));
+
+  for (const char *c = utf8; *c; c = g_utf8_next_char (c))
+    {
+      gunichar ch = g_utf8_get_char (c);
+
+      if (ch < 0x80)
+        self->ascii[ch >> 5] |= 1u << (ch & 0x1F);
+      else
+        g_array_append_val (chars, ch);
+    }
+
+  if (chars->len > 0)
+    {
+      guint n = 0;
+
+      g_array_sort (chars, compare_unichar);
+
+      /* Drop duplicates so the array stays as small as possible */
+      for (guint i = 0; i < chars->len; i++)
+        {
+          gunichar ch = g_array_index (chars, gunichar, i);
+
+          if (n == 0 || g_array_index (chars, gunichar, n - 1) != ch)
+            g_array_index (chars, gunichar, n++) = ch;
+        }
+
+      self->n_chars = n;
+      self->chars = g_memdup2 (chars->data, n * sizeof (gunichar));
+    }
+
+  return self;
+}
+
+SpellingCharSet *
+spelling_char_set_ref (SpellingCharSet *self)
+{
+  return g_atomic_rc_box_acquire (self);
+}
+
+void
+spelling_char_set_unref (SpellingCharSet *self)
+{
+  g_atomic_rc_box_release_full (self, spelling_char_set_finalize);
+}
@@ -22,23 +22,25 @@
 
 #include <gtk/gtk.h>
 
+#include "spelling-char-set-private.h"
+
 G_BEGIN_DECLS
 
 typedef struct _SpellingCursor SpellingCursor;
 typedef struct _CjhTextRegion  CjhTextRegion;
 
-SpellingCursor *spelling_cursor_new               (GtkTextBuffer  *buffer,
-                                                   CjhTextRegion  *region,
-                                                   GtkTextTag     *no_spell_check_tag,
-                                                   const char     *extra_word_chars);
-void            spelling_cursor_free              (SpellingCursor *cursor);
-gboolean        spelling_cursor_next              (SpellingCursor *cursor,
-                                                   GtkTextIter    *word_begin,
-                                                   GtkTextIter    *word_end);
-gboolean        spelling_iter_forward_word_end    (GtkTextIter    *iter,
-                                                   const char     *extra_word_chars);
-gboolean        spelling_iter_backward_word_start (GtkTextIter    *iter,
-                                                   const char     *extra_word_chars);
+SpellingCursor *spelling_cursor_new               (GtkTextBuffer         *buffer,
+                                                   CjhTextRegion         *region,
+                                                   GtkTextTag            *no_spell_check_tag,
+                                                   const char            *extra_word_chars);
+void            spelling_cursor_free              (SpellingCursor        *cursor);
+gboolean        spelling_cursor_next              (SpellingCursor        *cursor,
+                                                   GtkTextIter           *word_begin,
+                                                   GtkTextIter           *word_end);
+gboolean        spelling_iter_forward_word_end    (GtkTextIter           *iter,
+                                                   const SpellingCharSet *extra_word_chars);
+gboolean        spelling_iter_backward_word_start (GtkTextIter           *iter,
+                                                   const SpellingCharSet *extra_word_chars);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (SpellingCursor, spelling_cursor_free)
 
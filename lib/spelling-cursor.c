@@ -22,6 +22,7 @@
 #include "config.h"
 
 #include "cjhtextregionprivate.h"
+#include "spelling-char-set-private.h"
 #include "spelling-cursor-private.h"
 
 #define RUN_UNCHECKED NULL
@@ -39,12 +40,6 @@ typedef struct
   gssize pos;
 } RegionIter;
 
-typedef struct
-{
-  gsize position;
-  gboolean found;
-} RegionIterNext;
-
 typedef struct
 {
   GtkTextBuffer *buffer;
@@ -64,7 +59,7 @@ struct _SpellingCursor
   RegionIter region;
   TagIter tag;
   WordIter word;
-  const char *extra_word_chars;
+  SpellingCharSet *extra_word_chars;
 };
 
 static void
@@ -77,28 +72,12 @@ region_iter_init (RegionIter    *self,
   self->pos = -1;
 }
 
-static gboolean
-region_iter_next_cb (gsize                   position,
-                     const CjhTextRegionRun *run,
-                     gpointer                user_data)
-{
-  if (run->data == RUN_UNCHECKED)
-    {
-      RegionIterNext *state = user_data;
-
-      state->position = position;
-      state->found = TRUE;
-      RETURN (TRUE);
-    }
-
-  RETURN (FALSE);
-}
-
 static gboolean
 region_iter_next (RegionIter  *self,
                   GtkTextIter *iter)
 {
-  RegionIterNext state = {0};
+  gsize begin;
+  gsize end;
   gsize pos;
 
   if (self->pos >= (gssize)_cjh_text_region_get_length (self->region))
@@ -112,20 +91,15 @@ region_iter_next (RegionIter  *self,
   else
     pos = self->pos;
 
-  _cjh_text_region_foreach_in_range (self->region,
-                                     pos,
-                                     _cjh_text_region_get_length (self->region),
-                                     region_iter_next_cb,
-                                     &state);
-
-  if (!state.found)
+  /* The region tracks RUN_UNCHECKED so this does not visit every run */
+  if (!_cjh_text_region_find_tracked (self->region, pos, &begin, &end))
     {
       gtk_text_buffer_get_end_iter (self->buffer, iter);
       self->pos = _cjh_text_region_get_length (self->region);
       RETURN (FALSE);
     }
 
-  pos = MAX (pos, state.position);
+  pos = begin;
   gtk_text_buffer_get_iter_at_offset (self->buffer, iter, pos);
   self->pos = pos;
 
@@ -173,24 +147,8 @@ tag_iter_seek (TagIter           *self,
 }
 
 static inline gboolean
-utf8_contains_unichar (const char *utf8,
-                       gunichar    ch)
-{
-  if (ch == 0)
-    RETURN (FALSE);
-
-  for (const char *c = utf8; *c; c = g_utf8_next_char (c))
-    {
-      if (ch == g_utf8_get_char (c))
-        RETURN (TRUE);
-    }
-
-  RETURN (FALSE);
-}
-
-static inline gboolean
-is_word_char (const GtkTextIter *iter,
-              const char        *extra_word_chars)
+is_word_char (const GtkTextIter     *iter,
+              const SpellingCharSet *extra_word_chars)
 {
   if (gtk_text_iter_starts_word (iter))
     RETURN (TRUE);
@@ -198,18 +156,15 @@ is_word_char (const GtkTextIter *iter,
   if (gtk_text_iter_inside_word (iter))
     RETURN (TRUE);
 
-  if (extra_word_chars != NULL)
-    {
-      if (utf8_contains_unichar (extra_word_chars, gtk_text_iter_get_char (iter)))
-        RETURN (TRUE);
-    }
+  if (spelling_char_set_contains (extra_word_chars, gtk_text_iter_get_char (iter)))
+    RETURN (TRUE);
 
   RETURN (FALSE);
 }
 
 gboolean
-spelling_iter_forward_word_end (GtkTextIter *iter,
-                                const char  *extra_word_chars)
+spelling_iter_forward_word_end (GtkTextIter           *iter,
+                                const SpellingCharSet *extra_word_chars)
 {
   GtkTextIter orig = *iter;
   GtkTextIter peek;
@@ -240,8 +195,8 @@ spelling_iter_forward_word_end (GtkTextIter *iter,
 }
 
 gboolean
-spelling_iter_backward_word_start (GtkTextIter *iter,
-                                   const char  *extra_word_chars)
+spelling_iter_backward_word_start (GtkTextIter           *iter,
+                                   const SpellingCharSet *extra_word_chars)
 {
   GtkTextIter peek;
 
@@ -277,10 +232,10 @@ word_iter_init (WordIter      *self,
 }
 
 static gboolean
-word_iter_next (WordIter    *self,
-                GtkTextIter *word_begin,
-                GtkTextIter *word_end,
-                const char  *extra_word_chars)
+word_iter_next (WordIter              *self,
+                GtkTextIter           *word_begin,
+                GtkTextIter           *word_end,
+                const SpellingCharSet *extra_word_chars)
 {
   if (!spelling_iter_forward_word_end (&self->word_end, extra_word_chars))
     {
@@ -322,21 +277,30 @@ spelling_cursor_new (GtkTextBuffer *buffer,
 
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
   g_return_val_if_fail (region != NULL, NULL);
+  g_return_val_if_fail (_cjh_text_region_get_tracked (region) == RUN_UNCHECKED, NULL);
   g_return_val_if_fail (!no_spell_check_tag || GTK_IS_TEXT_TAG (no_spell_check_tag), NULL);
 
   self = g_rc_box_new0 (SpellingCursor);
   region_iter_init (&self->region, buffer, region);
   tag_iter_init (&self->tag, buffer, no_spell_check_tag);
   word_iter_init (&self->word, buffer);
-  self->extra_word_chars = extra_word_chars ? g_intern_string (extra_word_chars) : "";
+  self->extra_word_chars = spelling_char_set_new (extra_word_chars);
 
   return self;
 }
 
+static void
+spelling_cursor_finalize (gpointer data)
+{
+  SpellingCursor *self = data;
+
+  g_clear_pointer (&self->extra_word_chars, spelling_char_set_unref);
+}
+
 void
 spelling_cursor_free (SpellingCursor *self)
 {
-  g_rc_box_release (self);
+  g_rc_box_release_full (self, spelling_cursor_finalize);
 }
 
 static gboolean
@@ -22,12 +22,15 @@
 
 #include <gtk/gtk.h>
 
+#include "spelling-char-set-private.h"
 #include "spelling-dictionary.h"
 
 G_BEGIN_DECLS
 
 #define SPELLING_DICTIONARY_GET_CLASS(obj) G_TYPE_INSTANCE_GET_CLASS(obj, SPELLING_TYPE_DICTIONARY, SpellingDictionaryClass)
 
+typedef struct _SpellingDictionarySlot SpellingDictionarySlot;
+
 typedef struct _SpellingBoundary
 {
   guint offset;
@@ -41,6 +44,10 @@ struct _SpellingDictionary
   GObject parent_instance;
   const char *code;
   GMutex mutex;
+  SpellingDictionarySlot *cache;
+  guint cache_hits;
+  guint cache_misses;
+  SpellingCharSet *extra_word_char_set;
 };
 
 struct _SpellingDictionaryClass
@@ -60,11 +67,39 @@ struct _SpellingDictionaryClass
   void         (*ignore_word)          (SpellingDictionary *self,
                                         const char         *word);
   const char  *(*get_extra_word_chars) (SpellingDictionary *self);
+  void         (*check_words)          (SpellingDictionary     *self,
+                                        const char             *text,
+                                        const SpellingBoundary *positions,
+                                        guint                   n_positions,
+                                        GtkBitset              *mistakes);
 };
 
-GtkBitset *_spelling_dictionary_check_words (SpellingDictionary     *self,
-                                             const char             *text,
-                                             const SpellingBoundary *positions,
-                                             guint                   n_positions);
+GtkBitset       *_spelling_dictionary_check_words             (SpellingDictionary     *self,
+                                                               const char             *text,
+                                                               const SpellingBoundary *positions,
+                                                               guint                   n_positions,
+                                                               guint                  *n_cached);
+void             _spelling_dictionary_get_cache_stats         (SpellingDictionary     *self,
+                                                               guint                  *hits,
+                                                               guint                  *misses);
+SpellingCharSet *_spelling_dictionary_get_extra_word_char_set (SpellingDictionary     *self);
+
+/* FNV-1a over the bytes of a word, shared by the dictionary cache and
+ * the word deduplication of SpellingJob.
+ */
+static inline guint64
+_spelling_word_hash (const char *word,
+                     gsize       word_len)
+{
+  guint64 h = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+
+  for (gsize i = 0; i < word_len; i++)
+    {
+      h ^= (guchar)word[i];
+      h *= G_GUINT64_CONSTANT (0x100000001b3);
+    }
+
+  return h;
+}
 
 G_END_DECLS
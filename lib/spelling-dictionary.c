@@ -30,6 +30,33 @@
  * Abstract base class for spellchecking dictionaries.
  */
 
+/* The verdict cache is a direct-mapped table of word hashes which sits
+ * in front of the contains_word vfunc. Each slot keeps the full 64-bit
+ * hash of its word so that hits are exact on every platform, along with
+ * a state word holding the verdict and a sequence number.
+ *
+ * Slots are only ever written while holding the dictionary lock, which is
+ * also held by add_word() and ignore_word() when they flush the table. That
+ * way a verdict computed before the word list changed cannot be stored
+ * after the flush. Lookups do not take the lock. Instead, every write
+ * bumps the sequence number, and a lookup only trusts the hash it read if
+ * the state word did not change meanwhile. The hash is kept as two 32-bit
+ * halves which are only accessed atomically, since that orders them with
+ * the state word and cannot tear on 32-bit platforms.
+ */
+#define CACHE_N_SLOTS      (1 << 13)
+#define CACHE_SLOT_VALID   1u
+#define CACHE_SLOT_CORRECT 2u
+#define CACHE_SLOT_FLAGS   (CACHE_SLOT_VALID | CACHE_SLOT_CORRECT)
+#define CACHE_SLOT_SEQ     4u
+
+struct _SpellingDictionarySlot
+{
+  guint hash_lo;
+  guint hash_hi;
+  guint state;
+};
+
 G_DEFINE_ABSTRACT_TYPE (SpellingDictionary, spelling_dictionary, G_TYPE_OBJECT)
 
 enum {
@@ -64,6 +91,66 @@ spelling_dictionary_unlock (SpellingDictionary *self)
   SPELLING_DICTIONARY_GET_CLASS (self)->unlock (self);
 }
 
+static inline SpellingDictionarySlot *
+spelling_dictionary_cache_slot (SpellingDictionary *self,
+                                guint64             hash)
+{
+  return &self->cache[(hash ^ (hash >> 32)) & (CACHE_N_SLOTS - 1)];
+}
+
+static inline gboolean
+spelling_dictionary_cache_lookup (SpellingDictionary *self,
+                                  guint64             hash,
+                                  gboolean           *correct)
+{
+  SpellingDictionarySlot *slot = spelling_dictionary_cache_slot (self, hash);
+  guint state = g_atomic_int_get (&slot->state);
+  guint hash_lo;
+  guint hash_hi;
+
+  if ((state & CACHE_SLOT_VALID) == 0)
+    return FALSE;
+
+  /* The halves may not match if a writer got in, which the state shows */
+  hash_lo = g_atomic_int_get (&slot->hash_lo);
+  hash_hi = g_atomic_int_get (&slot->hash_hi);
+
+  if (g_atomic_int_get (&slot->state) != state ||
+      hash_lo != (guint)hash ||
+      hash_hi != (guint)(hash >> 32))
+    return FALSE;
+
+  *correct = !!(state & CACHE_SLOT_CORRECT);
+
+  return TRUE;
+}
+
+/* Must be called with the dictionary lock held */
+static inline void
+spelling_dictionary_cache_insert (SpellingDictionary *self,
+                                  guint64             hash,
+                                  gboolean            correct)
+{
+  SpellingDictionarySlot *slot = spelling_dictionary_cache_slot (self, hash);
+  guint seq = (slot->state & ~CACHE_SLOT_FLAGS) + CACHE_SLOT_SEQ;
+
+  /* Invalidate the slot while the hash changes */
+  g_atomic_int_set (&slot->state, seq);
+  g_atomic_int_set (&slot->hash_lo, (guint)hash);
+  g_atomic_int_set (&slot->hash_hi, (guint)(hash >> 32));
+  g_atomic_int_set (&slot->state,
+                    (seq + CACHE_SLOT_SEQ) | CACHE_SLOT_VALID | (correct ? CACHE_SLOT_CORRECT : 0));
+}
+
+/* Must be called with the dictionary lock held */
+static void
+spelling_dictionary_cache_flush (SpellingDictionary *self)
+{
+  for (guint i = 0; i < CACHE_N_SLOTS; i++)
+    g_atomic_int_set (&self->cache[i].state,
+                      (self->cache[i].state & ~CACHE_SLOT_FLAGS) + CACHE_SLOT_SEQ);
+}
+
 static void
 spelling_dictionary_finalize (GObject *object)
 {
@@ -71,6 +158,8 @@ spelling_dictionary_finalize (GObject *object)
 
   self->code = NULL;
 
+  g_clear_pointer (&self->cache, g_free);
+  g_clear_pointer (&self->extra_word_char_set, spelling_char_set_unref);
   g_mutex_clear (&self->mutex);
 
   G_OBJECT_CLASS (spelling_dictionary_parent_class)->finalize (object);
@@ -114,6 +203,27 @@ spelling_dictionary_set_property (GObject      *object,
     }
 }
 
+static void
+spelling_dictionary_real_check_words (SpellingDictionary     *self,
+                                      const char             *text,
+                                      const SpellingBoundary *positions,
+                                      guint                   n_positions,
+                                      GtkBitset              *mistakes)
+{
+  gboolean (*contains_word) (SpellingDictionary *, const char *, gssize);
+
+  contains_word = SPELLING_DICTIONARY_GET_CLASS (self)->contains_word;
+
+  for (guint i = 0; i < n_positions; i++)
+    {
+      const char *word = &text[positions[i].byte_offset];
+      guint wordlen = positions[i].byte_length;
+
+      if (!(*contains_word) (self, word, wordlen))
+        gtk_bitset_add (mistakes, i);
+    }
+}
+
 static void
 spelling_dictionary_class_init (SpellingDictionaryClass *klass)
 {
@@ -125,6 +235,7 @@ spelling_dictionary_class_init (SpellingDictionaryClass *klass)
 
   klass->lock = spelling_dictionary_real_lock;
   klass->unlock = spelling_dictionary_real_unlock;
+  klass->check_words = spelling_dictionary_real_check_words;
 
   /**
    * SpellingDictionary:code:
@@ -145,6 +256,8 @@ static void
 spelling_dictionary_init (SpellingDictionary *self)
 {
   g_mutex_init (&self->mutex);
+
+  self->cache = g_new0 (SpellingDictionarySlot, CACHE_N_SLOTS);
 }
 
 /**
@@ -178,6 +291,7 @@ spelling_dictionary_contains_word (SpellingDictionary *self,
                                    const char         *word,
                                    gssize              word_len)
 {
+  guint64 hash;
   gboolean ret;
 
   g_return_val_if_fail (SPELLING_IS_DICTIONARY (self), FALSE);
@@ -186,8 +300,19 @@ spelling_dictionary_contains_word (SpellingDictionary *self,
   if (word_len < 0)
     word_len = strlen (word);
 
+  hash = _spelling_word_hash (word, word_len);
+
+  if (spelling_dictionary_cache_lookup (self, hash, &ret))
+    {
+      g_atomic_int_inc (&self->cache_hits);
+      return ret;
+    }
+
+  g_atomic_int_inc (&self->cache_misses);
+
   spelling_dictionary_lock (self);
   ret = SPELLING_DICTIONARY_GET_CLASS (self)->contains_word (self, word, word_len);
+  spelling_dictionary_cache_insert (self, hash, ret);
   spelling_dictionary_unlock (self);
 
   return ret;
@@ -246,6 +371,7 @@ spelling_dictionary_add_word (SpellingDictionary *self,
     {
       spelling_dictionary_lock (self);
       SPELLING_DICTIONARY_GET_CLASS (self)->add_word (self, word);
+      spelling_dictionary_cache_flush (self);
       spelling_dictionary_unlock (self);
     }
 }
@@ -268,6 +394,7 @@ spelling_dictionary_ignore_word (SpellingDictionary *self,
     {
       spelling_dictionary_lock (self);
       SPELLING_DICTIONARY_GET_CLASS (self)->ignore_word (self, word);
+      spelling_dictionary_cache_flush (self);
       spelling_dictionary_unlock (self);
     }
 }
@@ -297,35 +424,132 @@ spelling_dictionary_get_extra_word_chars (SpellingDictionary *self)
   return ret;
 }
 
+/*
+ * _spelling_dictionary_get_extra_word_char_set:
+ *
+ * Gets the extra word characters compiled into a `SpellingCharSet`. The set
+ * is built the first time it is requested and lives as long as @self.
+ */
+SpellingCharSet *
+_spelling_dictionary_get_extra_word_char_set (SpellingDictionary *self)
+{
+  SpellingCharSet *set;
+
+  g_return_val_if_fail (SPELLING_IS_DICTIONARY (self), NULL);
+
+  if G_UNLIKELY (!(set = g_atomic_pointer_get (&self->extra_word_char_set)))
+    {
+      set = spelling_char_set_new (spelling_dictionary_get_extra_word_chars (self));
+
+      if (!g_atomic_pointer_compare_and_exchange (&self->extra_word_char_set, NULL, set))
+        {
+          g_clear_pointer (&set, spelling_char_set_unref);
+          set = g_atomic_pointer_get (&self->extra_word_char_set);
+        }
+    }
+
+  return set;
+}
+
 GtkBitset *
 _spelling_dictionary_check_words (SpellingDictionary     *self,
                                   const char             *text,
                                   const SpellingBoundary *positions,
-                                  guint                   n_positions)
+                                  guint                   n_positions,
+                                  guint                  *n_cached)
 {
-  gboolean (*contains_word) (SpellingDictionary *, const char *, gssize);
+  g_autoptr(GArray) miss_positions = NULL;
+  g_autoptr(GArray) miss_index = NULL;
+  g_autoptr(GtkBitset) miss_mistakes = NULL;
   GtkBitset *bitset;
+  guint hits = 0;
 
   g_return_val_if_fail (SPELLING_IS_DICTIONARY (self), NULL);
   g_return_val_if_fail (text != NULL, NULL);
 
   bitset = gtk_bitset_new_empty ();
 
+  if (n_cached != NULL)
+    *n_cached = 0;
+
   if (n_positions == 0)
     return bitset;
 
-  contains_word = SPELLING_DICTIONARY_GET_CLASS (self)->contains_word;
-
-  spelling_dictionary_lock (self);
+  /* First resolve everything we can from the cache without taking
+   * the dictionary lock, collecting the rest for a single locked pass.
+   */
   for (guint i = 0; i < n_positions; i++)
     {
       const char *word = &text[positions[i].byte_offset];
-      guint wordlen = positions[i].byte_length;
+      guint64 hash = _spelling_word_hash (word, positions[i].byte_length);
+      gboolean correct;
+
+      if (spelling_dictionary_cache_lookup (self, hash, &correct))
+        {
+          if (!correct)
+            gtk_bitset_add (bitset, i);
+          hits++;
+          continue;
+        }
+
+      if (miss_index == NULL)
+        {
+          miss_index = g_array_new (FALSE, FALSE, sizeof (guint));
+          miss_positions = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+        }
+
+      g_array_append_val (miss_index, i);
+      g_array_append_vals (miss_positions, &positions[i], 1);
+    }
 
-      if (!(*contains_word) (self, word, wordlen))
-        gtk_bitset_add (bitset, i);
+  g_atomic_int_add (&self->cache_hits, hits);
+
+  if (n_cached != NULL)
+    *n_cached = hits;
+
+  if (miss_index == NULL)
+    return bitset;
+
+  g_atomic_int_add (&self->cache_misses, miss_index->len);
+
+  miss_mistakes = gtk_bitset_new_empty ();
+
+  spelling_dictionary_lock (self);
+
+  SPELLING_DICTIONARY_GET_CLASS (self)->check_words (self,
+                                                     text,
+                                                     &g_array_index (miss_positions, SpellingBoundary, 0),
+                                                     miss_positions->len,
+                                                     miss_mistakes);
+
+  for (guint m = 0; m < miss_index->len; m++)
+    {
+      const SpellingBoundary *b = &g_array_index (miss_positions, SpellingBoundary, m);
+      gboolean correct = !gtk_bitset_contains (miss_mistakes, m);
+
+      spelling_dictionary_cache_insert (self,
+                                        _spelling_word_hash (&text[b->byte_offset], b->byte_length),
+                                        correct);
+
+      if (!correct)
+        gtk_bitset_add (bitset, g_array_index (miss_index, guint, m));
     }
+
   spelling_dictionary_unlock (self);
 
   return bitset;
 }
+
+void
+_spelling_dictionary_get_cache_stats (SpellingDictionary *self,
+                                      guint              *hits,
+                                      guint              *misses)
+{
+  g_return_if_fail (SPELLING_IS_DICTIONARY (self));
+
+  if (hits != NULL)
+    *hits = g_atomic_int_get (&self->cache_hits);
+
+  if (misses != NULL)
+    *misses = g_atomic_int_get (&self->cache_misses);
+}
@@ -0,0 +1,833 @@
+/* spelling-document.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "spelling-char-set-private.h"
+#include "spelling-checker-private.h"
+#include "spelling-dictionary-internal.h"
+#include "spelling-document-private.h"
+#include "spelling-engine-private.h"
+
+/**
+ * SpellingDocument:
+ *
+ * `SpellingDocument` checks a UTF-8 string without any widget involved,
+ * such as for checking commit messages or documentation in a service.
+ *
+ * Text is changed with [method@Spelling.Document.insert] and
+ * [method@Spelling.Document.delete] and checked incrementally on a
+ * thread pool, the same way [class@Spelling.TextBufferAdapter] checks a
+ * buffer. Mistakes are reported with the
+ * [signal@Spelling.Document::mistakes-changed] signal as results arrive
+ * and can be walked with [method@Spelling.Document.next_mistake].
+ *
+ * Checking is driven by the default main context, which must be
+ * iterated for results to arrive.
+ */
+
+struct _SpellingDocument
+{
+  GObject          parent_instance;
+
+  SpellingEngine  *engine;
+  SpellingChecker *checker;
+  GString         *text;
+  GtkBitset       *mistakes;
+
+  /* GTasks of spelling_document_check_async() waiting for the engine */
+  GPtrArray       *waiting;
+  guint            finished_handler;
+
+  /* Length of @text in characters */
+  guint            length;
+
+  /* Where checking starts, see _spelling_document_set_cursor() */
+  guint            cursor;
+
+  /* The last offset converted to a pointer into @text, so that nearby
+   * lookups do not walk from the start of the text.
+   */
+  guint            cached_offset;
+  gsize            cached_byte;
+};
+
+G_DEFINE_FINAL_TYPE (SpellingDocument, spelling_document, G_TYPE_OBJECT)
+
+enum {
+  PROP_0,
+  PROP_CHECKER,
+  N_PROPS
+};
+
+enum {
+  MISTAKES_CHANGED,
+  N_SIGNALS
+};
+
+static GParamSpec *properties[N_PROPS];
+static guint signals[N_SIGNALS];
+
+static const char *
+spelling_document_get_pointer (SpellingDocument *self,
+                               guint             offset)
+{
+  const char *str = self->text->str;
+  const char *p;
+
+  g_assert (offset <= self->length);
+
+  /* Walk from whichever is closest of the start, the end and the last
+   * offset that was looked up.
+   */
+  if (offset >= self->cached_offset)
+    {
+      if (offset - self->cached_offset <= self->length - offset)
+        p = g_utf8_offset_to_pointer (str + self->cached_byte, offset - self->cached_offset);
+      else
+        p = g_utf8_offset_to_pointer (str + self->text->len, -(glong)(self->length - offset));
+    }
+  else
+    {
+      if (offset <= self->cached_offset - offset)
+        p = g_utf8_offset_to_pointer (str, offset);
+      else
+        p = g_utf8_offset_to_pointer (str + self->cached_byte, -(glong)(self->cached_offset - offset));
+    }
+
+  self->cached_offset = offset;
+  self->cached_byte = p - str;
+
+  return p;
+}
+
+static void
+spelling_document_reset_pointer (SpellingDocument *self)
+{
+  self->cached_offset = 0;
+  self->cached_byte = 0;
+}
+
+static gboolean
+spelling_document_is_word_char (SpellingDocument *self,
+                                gunichar          ch)
+{
+  SpellingDictionary *dictionary;
+
+  if (g_unichar_isalnum (ch) || ch == '_' || ch == '\'' || ch == 0x2019)
+    return TRUE;
+
+  return (dictionary = _spelling_checker_get_dictionary (self->checker)) &&
+         spelling_char_set_contains (_spelling_dictionary_get_extra_word_char_set (dictionary), ch);
+}
+
+/* Without a dictionary for the language of the checker nothing can be
+ * checked, see spelling_document_fail_waiting().
+ */
+static gboolean
+spelling_document_check_enabled (gpointer instance)
+{
+  SpellingDocument *self = instance;
+
+  return self->checker != NULL &&
+         _spelling_checker_get_dictionary (self->checker) != NULL;
+}
+
+static guint
+spelling_document_get_cursor (gpointer instance)
+{
+  SpellingDocument *self = instance;
+
+  return self->cursor;
+}
+
+static char *
+spelling_document_copy_text (gpointer instance,
+                             guint    position,
+                             guint    length)
+{
+  SpellingDocument *self = instance;
+  const char *begin;
+  const char *end;
+
+  g_assert (position + length <= self->length);
+
+  begin = spelling_document_get_pointer (self, position);
+  end = spelling_document_get_pointer (self, position + length);
+
+  return g_strndup (begin, end - begin);
+}
+
+static gboolean
+spelling_document_apply_tag (gpointer instance,
+                             guint    position,
+                             guint    length)
+{
+  SpellingDocument *self = instance;
+
+  gtk_bitset_add_range (self->mistakes, position, length);
+  g_signal_emit (self, signals[MISTAKES_CHANGED], 0, position, length);
+
+  return TRUE;
+}
+
+static void
+spelling_document_clear_tag (gpointer instance,
+                             guint    position,
+                             guint    length)
+{
+  SpellingDocument *self = instance;
+
+  gtk_bitset_remove_range (self->mistakes, position, length);
+  g_signal_emit (self, signals[MISTAKES_CHANGED], 0, position, length);
+}
+
+static gboolean
+spelling_document_backward_word_start (gpointer  instance,
+                                       guint    *position)
+{
+  SpellingDocument *self = instance;
+  const char *str = self->text->str;
+  const char *p;
+  guint offset = *position;
+
+  if (offset == 0)
+    return FALSE;
+
+  p = g_utf8_prev_char (spelling_document_get_pointer (self, offset));
+  offset--;
+
+  /* Skip back over what separates us from the previous word */
+  while (!spelling_document_is_word_char (self, g_utf8_get_char (p)))
+    {
+      if (p == str)
+        return FALSE;
+
+      p = g_utf8_prev_char (p);
+      offset--;
+    }
+
+  while (p > str)
+    {
+      const char *prev = g_utf8_prev_char (p);
+
+      if (!spelling_document_is_word_char (self, g_utf8_get_char (prev)))
+        break;
+
+      p = prev;
+      offset--;
+    }
+
+  *position = offset;
+
+  return TRUE;
+}
+
+static gboolean
+spelling_document_forward_word_end (gpointer  instance,
+                                    guint    *position)
+{
+  SpellingDocument *self = instance;
+  const char *end = self->text->str + self->text->len;
+  const char *p;
+  guint offset = *position;
+
+  if (offset >= self->length)
+    return FALSE;
+
+  p = g_utf8_next_char (spelling_document_get_pointer (self, offset));
+  offset++;
+
+  /* Skip over what separates us from the next word */
+  while (p < end && !spelling_document_is_word_char (self, g_utf8_get_char (p)))
+    {
+      p = g_utf8_next_char (p);
+      offset++;
+    }
+
+  if (p >= end)
+    return FALSE;
+
+  while (p < end && spelling_document_is_word_char (self, g_utf8_get_char (p)))
+    {
+      p = g_utf8_next_char (p);
+      offset++;
+    }
+
+  *position = offset;
+
+  return TRUE;
+}
+
+static void
+spelling_document_intersect_spellcheck_region (gpointer   instance,
+                                               GtkBitset *region)
+{
+  /* Everything is checked */
+}
+
+static PangoLanguage *
+spelling_document_get_language (gpointer instance)
+{
+  SpellingDocument *self = instance;
+
+  return _spelling_checker_get_pango_language (self->checker);
+}
+
+static SpellingDictionary *
+spelling_document_get_dictionary (gpointer instance)
+{
+  SpellingDocument *self = instance;
+
+  return _spelling_checker_get_dictionary (self->checker);
+}
+
+static gboolean
+spelling_document_finished_cb (gpointer data)
+{
+  SpellingDocument *self = data;
+  g_autoptr(GPtrArray) waiting = NULL;
+
+  g_assert (SPELLING_IS_DOCUMENT (self));
+
+  self->finished_handler = 0;
+
+  /* The text may have changed again in the meantime */
+  if (spelling_engine_get_busy (self->engine))
+    return G_SOURCE_REMOVE;
+
+  waiting = g_steal_pointer (&self->waiting);
+  self->waiting = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint i = 0; i < waiting->len; i++)
+    {
+      GTask *task = g_ptr_array_index (waiting, i);
+
+      if (!g_task_return_error_if_cancelled (task))
+        g_task_return_boolean (task, TRUE);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+spelling_document_return_unsupported (SpellingDocument *self,
+                                      GTask            *task)
+{
+  const char *code;
+
+  if (!(code = spelling_checker_get_language (self->checker)))
+    code = "";
+
+  g_task_return_new_error (task,
+                           G_IO_ERROR,
+                           G_IO_ERROR_NOT_SUPPORTED,
+                           "No dictionary is available for “%s”",
+                           code);
+}
+
+/* Fails what waits for the text to be checked if the checker has no
+ * dictionary, as the text would never be checked.
+ */
+static void
+spelling_document_fail_waiting (SpellingDocument *self)
+{
+  g_autoptr(GPtrArray) waiting = NULL;
+
+  if (spelling_document_check_enabled (self))
+    return;
+
+  waiting = g_steal_pointer (&self->waiting);
+  self->waiting = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint i = 0; i < waiting->len; i++)
+    spelling_document_return_unsupported (self, g_ptr_array_index (waiting, i));
+}
+
+/* The mistakes found so far belong to the previous language */
+static void
+spelling_document_checker_notify_language (SpellingDocument *self,
+                                           GParamSpec       *pspec,
+                                           SpellingChecker  *checker)
+{
+  g_assert (SPELLING_IS_DOCUMENT (self));
+  g_assert (SPELLING_IS_CHECKER (checker));
+
+  spelling_engine_invalidate_all (self->engine);
+  spelling_document_fail_waiting (self);
+}
+
+static void
+spelling_document_finished (gpointer instance)
+{
+  SpellingDocument *self = instance;
+
+  /* Complete from an idle so that callbacks may change the text without
+   * re-entering the engine.
+   */
+  if (self->waiting->len > 0 && self->finished_handler == 0)
+    self->finished_handler = g_idle_add (spelling_document_finished_cb, self);
+}
+
+static const SpellingAdapter adapter_funcs = {
+  .check_enabled = spelling_document_check_enabled,
+  .get_cursor = spelling_document_get_cursor,
+  .copy_text = spelling_document_copy_text,
+  .apply_tag = spelling_document_apply_tag,
+  .clear_tag = spelling_document_clear_tag,
+  .backward_word_start = spelling_document_backward_word_start,
+  .forward_word_end = spelling_document_forward_word_end,
+  .intersect_spellcheck_region = spelling_document_intersect_spellcheck_region,
+  .get_language = spelling_document_get_language,
+  .get_dictionary = spelling_document_get_dictionary,
+  .finished = spelling_document_finished,
+};
+
+static void
+spelling_document_dispose (GObject *object)
+{
+  SpellingDocument *self = (SpellingDocument *)object;
+
+  g_clear_handle_id (&self->finished_handler, g_source_remove);
+  g_clear_object (&self->engine);
+
+  G_OBJECT_CLASS (spelling_document_parent_class)->dispose (object);
+}
+
+static void
+spelling_document_finalize (GObject *object)
+{
+  SpellingDocument *self = (SpellingDocument *)object;
+
+  g_clear_object (&self->checker);
+  g_clear_pointer (&self->mistakes, gtk_bitset_unref);
+  g_clear_pointer (&self->waiting, g_ptr_array_unref);
+  g_string_free (self->text, TRUE);
+
+  G_OBJECT_CLASS (spelling_document_parent_class)->finalize (object);
+}
+
+static void
+spelling_document_get_property (GObject    *object,
+                                guint       prop_id,
+                                GValue     *value,
+                                GParamSpec *pspec)
+{
+  SpellingDocument *self = SPELLING_DOCUMENT (object);
+
+  switch (prop_id)
+    {
+    case PROP_CHECKER:
+      g_value_set_object (value, spelling_document_get_checker (self));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+spelling_document_set_property (GObject      *object,
+                                guint         prop_id,
+                                const GValue *value,
+                                GParamSpec   *pspec)
+{
+  SpellingDocument *self = SPELLING_DOCUMENT (object);
+
+  switch (prop_id)
+    {
+    case PROP_CHECKER:
+      if (!(self->checker = g_value_dup_object (value)))
+        self->checker = g_object_ref (spelling_checker_get_default ());
+      g_signal_connect_object (self->checker,
+                               "notify::language",
+                               G_CALLBACK (spelling_document_checker_notify_language),
+                               self,
+                               G_CONNECT_SWAPPED);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+spelling_document_class_init (SpellingDocumentClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = spelling_document_dispose;
+  object_class->finalize = spelling_document_finalize;
+  object_class->get_property = spelling_document_get_property;
+  object_class->set_property = spelling_document_set_property;
+
+  /**
+   * SpellingDocument:checker:
+   *
+   * The [class@Spelling.Checker] used to check the text.
+   *
+   * If %NULL when constructing, the default checker is used.
+   */
+  properties[PROP_CHECKER] =
+    g_param_spec_object ("checker", NULL, NULL,
+                         SPELLING_TYPE_CHECKER,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+
+  /**
+   * SpellingDocument::mistakes-changed:
+   * @self: a `SpellingDocument`
+   * @position: the offset in characters of the changed range
+   * @length: the length in characters of the changed range
+   *
+   * Emitted when results mark text as misspelled or correct.
+   */
+  signals[MISTAKES_CHANGED] =
+    g_signal_new ("mistakes-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_UINT);
+}
+
+static void
+spelling_document_init (SpellingDocument *self)
+{
+  self->text = g_string_new (NULL);
+  self->mistakes = gtk_bitset_new_empty ();
+  self->waiting = g_ptr_array_new_with_free_func (g_object_unref);
+  self->engine = spelling_engine_new (&adapter_funcs, G_OBJECT (self));
+}
+
+/**
+ * spelling_document_new:
+ * @checker: (nullable): a `SpellingChecker` or %NULL for the default one
+ *
+ * Creates a new, empty `SpellingDocument`.
+ *
+ * Returns: (transfer full): a newly created `SpellingDocument`
+ */
+SpellingDocument *
+spelling_document_new (SpellingChecker *checker)
+{
+  g_return_val_if_fail (!checker || SPELLING_IS_CHECKER (checker), NULL);
+
+  return g_object_new (SPELLING_TYPE_DOCUMENT,
+                       "checker", checker,
+                       NULL);
+}
+
+/**
+ * spelling_document_get_checker:
+ * @self: a `SpellingDocument`
+ *
+ * Gets the checker used to check the text.
+ *
+ * Returns: (transfer none): a `SpellingChecker`
+ */
+SpellingChecker *
+spelling_document_get_checker (SpellingDocument *self)
+{
+  g_return_val_if_fail (SPELLING_IS_DOCUMENT (self), NULL);
+
+  return self->checker;
+}
+
+/**
+ * spelling_document_get_text:
+ * @self: a `SpellingDocument`
+ *
+ * Gets the text of the document.
+ *
+ * Returns: (transfer none): a UTF-8 string, valid until the next change
+ */
+const char *
+spelling_document_get_text (SpellingDocument *self)
+{
+  g_return_val_if_fail (SPELLING_IS_DOCUMENT (self), NULL);
+
+  return self->text->str;
+}
+
+/**
+ * spelling_document_get_length:
+ * @self: a `SpellingDocument`
+ *
+ * Gets the length of the text in characters.
+ *
+ * Returns: the number of characters
+ */
+guint
+spelling_document_get_length (SpellingDocument *self)
+{
+  g_return_val_if_fail (SPELLING_IS_DOCUMENT (self), 0);
+
+  return self->length;
+}
+
+/**
+ * spelling_document_set_text:
+ * @self: a `SpellingDocument`
+ * @text: UTF-8 text
+ * @len: the length of @text in bytes, or -1 if it is nul-terminated
+ *
+ * Replaces the whole text of the document.
+ */
+void
+spelling_document_set_text (SpellingDocument *self,
+                            const char       *text,
+                            gssize            len)
+{
+  g_return_if_fail (SPELLING_IS_DOCUMENT (self));
+  g_return_if_fail (text != NULL || len == 0);
+
+  spelling_document_delete (self, 0, self->length);
+  spelling_document_insert (self, 0, text, len);
+}
+
+/**
+ * spelling_document_insert:
+ * @self: a `SpellingDocument`
+ * @position: the offset in characters to insert at
+ * @text: UTF-8 text
+ * @len: the length of @text in bytes, or -1 if it is nul-terminated
+ *
+ * Inserts @text at @position. The text around it is checked again.
+ */
+void
+spelling_document_insert (SpellingDocument *self,
+                          guint             position,
+                          const char       *text,
+                          gssize            len)
+{
+  gsize byte_offset;
+  guint n_chars;
+
+  g_return_if_fail (SPELLING_IS_DOCUMENT (self));
+  g_return_if_fail (position <= self->length);
+  g_return_if_fail (text != NULL || len == 0);
+
+  if (len < 0)
+    len = strlen (text);
+
+  if (len == 0)
+    return;
+
+  g_return_if_fail (g_utf8_validate_len (text, len, NULL));
+
+  n_chars = g_utf8_strlen (text, len);
+  byte_offset = spelling_document_get_pointer (self, position) - self->text->str;
+
+  spelling_engine_before_insert_text (self->engine, position, n_chars);
+
+  g_string_insert_len (self->text, byte_offset, text, len);
+  gtk_bitset_splice (self->mistakes, position, 0, n_chars);
+  self->length += n_chars;
+  spelling_document_reset_pointer (self);
+
+  if (self->cursor > position)
+    self->cursor += n_chars;
+
+  spelling_engine_after_insert_text (self->engine, position, n_chars);
+}
+
+/**
+ * spelling_document_delete:
+ * @self: a `SpellingDocument`
+ * @position: the offset in characters of the text to delete
+ * @length: the number of characters to delete
+ *
+ * Deletes @length characters at @position. The text around it is
+ * checked again.
+ */
+void
+spelling_document_delete (SpellingDocument *self,
+                          guint             position,
+                          guint             length)
+{
+  gsize begin;
+  gsize end;
+
+  g_return_if_fail (SPELLING_IS_DOCUMENT (self));
+  g_return_if_fail (position <= self->length);
+  g_return_if_fail (length <= self->length - position);
+
+  if (length == 0)
+    return;
+
+  begin = spelling_document_get_pointer (self, position) - self->text->str;
+  end = spelling_document_get_pointer (self, position + length) - self->text->str;
+
+  spelling_engine_before_delete_range (self->engine, position, length);
+
+  g_string_erase (self->text, begin, end - begin);
+  gtk_bitset_splice (self->mistakes, position, length, 0);
+  self->length -= length;
+  spelling_document_reset_pointer (self);
+
+  if (self->cursor >= position + length)
+    self->cursor -= length;
+  else if (self->cursor > position)
+    self->cursor = position;
+
+  spelling_engine_after_delete_range (self->engine, position);
+}
+
+/**
+ * spelling_document_get_busy:
+ * @self: a `SpellingDocument`
+ *
+ * Gets whether some of the text is still being checked.
+ *
+ * Returns: %TRUE if checking is in progress
+ */
+gboolean
+spelling_document_get_busy (SpellingDocument *self)
+{
+  g_return_val_if_fail (SPELLING_IS_DOCUMENT (self), FALSE);
+
+  return spelling_engine_get_busy (self->engine);
+}
+
+/**
+ * spelling_document_next_mistake:
+ * @self: a `SpellingDocument`
+ * @position: (inout): the offset to start looking at
+ * @length: (out): the length of the mistake
+ *
+ * Finds the first mistake found so far which ends after @position.
+ *
+ * Returns: %TRUE if a mistake was found and @position and @length were
+ *   set to its range
+ */
+gboolean
+spelling_document_next_mistake (SpellingDocument *self,
+                                guint            *position,
+                                guint            *length)
+{
+  GtkBitsetIter iter;
+  guint begin;
+  guint end;
+  guint next;
+
+  g_return_val_if_fail (SPELLING_IS_DOCUMENT (self), FALSE);
+  g_return_val_if_fail (position != NULL, FALSE);
+  g_return_val_if_fail (length != NULL, FALSE);
+
+  if (!gtk_bitset_iter_init_at (&iter, self->mistakes, *position, &begin))
+    return FALSE;
+
+  /* Start from the beginning of a mistake @position is within */
+  while (begin > 0 && gtk_bitset_contains (self->mistakes, begin - 1))
+    begin--;
+
+  end = gtk_bitset_iter_get_value (&iter) + 1;
+  while (gtk_bitset_iter_next (&iter, &next) && next == end)
+    end++;
+
+  *position = begin;
+  *length = end - begin;
+
+  return TRUE;
+}
+
+/**
+ * spelling_document_check_async:
+ * @self: a `SpellingDocument`
+ * @cancellable: (nullable): a `GCancellable`
+ * @callback: a callback to execute upon completion
+ * @user_data: closure data for @callback
+ *
+ * Waits until the whole text has been checked.
+ *
+ * Changing the text while waiting delays completion until the changes
+ * have been checked as well.
+ *
+ * Fails with %G_IO_ERROR_NOT_SUPPORTED if the checker has no dictionary
+ * for its language, or once it changes to such a language.
+ */
+void
+spelling_document_check_async (SpellingDocument    *self,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (SPELLING_IS_DOCUMENT (self));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, spelling_document_check_async);
+
+  if (!spelling_document_check_enabled (self))
+    spelling_document_return_unsupported (self, task);
+  else if (!spelling_engine_get_busy (self->engine))
+    g_task_return_boolean (task, TRUE);
+  else
+    g_ptr_array_add (self->waiting, g_steal_pointer (&task));
+}
+
+/**
+ * spelling_document_check_finish:
+ * @self: a `SpellingDocument`
+ * @result: a `GAsyncResult`
+ * @error: a location for a `GError`, or %NULL
+ *
+ * Completes a request to [method@Spelling.Document.check_async].
+ *
+ * Returns: %TRUE if the text was checked; otherwise %FALSE and @error
+ *   is set
+ */
+gboolean
+spelling_document_check_finish (SpellingDocument  *self,
+                                GAsyncResult      *result,
+                                GError           **error)
+{
+  g_return_val_if_fail (SPELLING_IS_DOCUMENT (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (result), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* Moves the cursor, as if the document was in a view, so that the
+ * text around it is checked first. Used to replay edit traces.
+ */
+void
+_spelling_document_set_cursor (SpellingDocument *self,
+                               guint             position)
+{
+  g_return_if_fail (SPELLING_IS_DOCUMENT (self));
+
+  self->cursor = MIN (position, self->length);
+}
+
+SpellingStats *
+_spelling_document_dup_stats (SpellingDocument *self)
+{
+  g_return_val_if_fail (SPELLING_IS_DOCUMENT (self), NULL);
+
+  return spelling_engine_dup_stats (self->engine);
+}
@@ -0,0 +1,76 @@
+/* spelling-document.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#if !defined(LIBSPELLING_INSIDE) && !defined(LIBSPELLING_COMPILATION)
+# error "Only <libspelling.h> can be included directly."
+#endif
+
+#include <gio/gio.h>
+
+#include "spelling-types.h"
+#include "spelling-version-macros.h"
+
+G_BEGIN_DECLS
+
+#define SPELLING_TYPE_DOCUMENT (spelling_document_get_type())
+
+SPELLING_AVAILABLE_IN_ALL
+G_DECLARE_FINAL_TYPE (SpellingDocument, spelling_document, SPELLING, DOCUMENT, GObject)
+
+SPELLING_AVAILABLE_IN_ALL
+SpellingDocument *spelling_document_new           (SpellingChecker      *checker);
+SPELLING_AVAILABLE_IN_ALL
+SpellingChecker  *spelling_document_get_checker   (SpellingDocument     *self);
+SPELLING_AVAILABLE_IN_ALL
+const char       *spelling_document_get_text      (SpellingDocument     *self);
+SPELLING_AVAILABLE_IN_ALL
+guint             spelling_document_get_length    (SpellingDocument     *self);
+SPELLING_AVAILABLE_IN_ALL
+void              spelling_document_set_text      (SpellingDocument     *self,
+                                                   const char           *text,
+                                                   gssize                len);
+SPELLING_AVAILABLE_IN_ALL
+void              spelling_document_insert        (SpellingDocument     *self,
+                                                   guint                 position,
+                                                   const char           *text,
+                                                   gssize                len);
+SPELLING_AVAILABLE_IN_ALL
+void              spelling_document_delete        (SpellingDocument     *self,
+                                                   guint                 position,
+                                                   guint                 length);
+SPELLING_AVAILABLE_IN_ALL
+gboolean          spelling_document_get_busy      (SpellingDocument     *self);
+SPELLING_AVAILABLE_IN_ALL
+gboolean          spelling_document_next_mistake  (SpellingDocument     *self,
+                                                   guint                *position,
+                                                   guint                *length);
+SPELLING_AVAILABLE_IN_ALL
+void              spelling_document_check_async   (SpellingDocument     *self,
+                                                   GCancellable         *cancellable,
+                                                   GAsyncReadyCallback   callback,
+                                                   gpointer              user_data);
+SPELLING_AVAILABLE_IN_ALL
+gboolean          spelling_document_check_finish  (SpellingDocument     *self,
+                                                   GAsyncResult         *result,
+                                                   GError              **error);
+
+G_END_DECLS
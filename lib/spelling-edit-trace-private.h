@@ -0,0 +1,60 @@
+/* spelling-edit-trace-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum _SpellingEditTraceKind
+{
+  SPELLING_EDIT_TRACE_INSERT = 'i',
+  SPELLING_EDIT_TRACE_DELETE = 'd',
+  SPELLING_EDIT_TRACE_CURSOR = 'c',
+} SpellingEditTraceKind;
+
+typedef struct _SpellingEditTraceEvent
+{
+  /* Microseconds since recording started */
+  gint64                time;
+  SpellingEditTraceKind kind;
+  guint                 position;
+  /* Characters deleted, or inserted along with @text */
+  guint                 length;
+  char                 *text;
+} SpellingEditTraceEvent;
+
+typedef struct _SpellingEditTraceWriter SpellingEditTraceWriter;
+
+SpellingEditTraceWriter *spelling_edit_trace_writer_new_from_env (void);
+void                     spelling_edit_trace_writer_free         (SpellingEditTraceWriter  *self);
+void                     spelling_edit_trace_writer_insert       (SpellingEditTraceWriter  *self,
+                                                                  guint                     position,
+                                                                  const char               *text);
+void                     spelling_edit_trace_writer_delete       (SpellingEditTraceWriter  *self,
+                                                                  guint                     position,
+                                                                  guint                     length);
+void                     spelling_edit_trace_writer_cursor       (SpellingEditTraceWriter  *self,
+                                                                  guint                     position);
+GArray                  *spelling_edit_trace_load                (const char               *path,
+                                                                  GError                  **error);
+
+G_END_DECLS
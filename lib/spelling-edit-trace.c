@@ -0,0 +1,316 @@
+/* spelling-edit-trace.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "spelling-edit-trace-private.h"
+
+/* Edit traces record what was done to a buffer and when, so that typing
+ * patterns which are slow to check can be replayed with spelling-replay.
+ * Recording is enabled by setting LIBSPELLING_EDIT_TRACE_DIR to a
+ * directory, in which every buffer gets a file of its own. Traces
+ * contain the text of the buffer, so they must be shared with care.
+ *
+ * Traces are text, one event per line:
+ *
+ *   TIME i POSITION TEXT
+ *   TIME d POSITION LENGTH
+ *   TIME c POSITION
+ *
+ * TIME is in microseconds since recording started, positions and
+ * lengths are in characters and TEXT is escaped with g_strescape().
+ * The first event inserts what the buffer contained when recording
+ * started.
+ */
+
+#define TRACE_HEADER   "# libspelling edit trace 1"
+#define FLUSH_INTERVAL G_USEC_PER_SEC
+
+struct _SpellingEditTraceWriter
+{
+  GOutputStream *stream;
+  gint64         begin_time;
+  gint64         flush_time;
+};
+
+/* Writes one event, flushing once in a while so that a trace survives
+ * the application being killed while it hangs.
+ */
+static void G_GNUC_PRINTF (2, 3)
+spelling_edit_trace_writer_printf (SpellingEditTraceWriter *self,
+                                   const char              *format,
+                                   ...)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree char *event = NULL;
+  gint64 now = g_get_monotonic_time ();
+  va_list args;
+  gboolean ret;
+
+  if (self->stream == NULL)
+    return;
+
+  va_start (args, format);
+  event = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  ret = g_output_stream_printf (self->stream, NULL, NULL, &error,
+                                "%" G_GINT64_FORMAT " %s\n",
+                                now - self->begin_time, event);
+
+  if (ret && now - self->flush_time >= FLUSH_INTERVAL)
+    {
+      ret = g_output_stream_flush (self->stream, NULL, &error);
+      self->flush_time = now;
+    }
+
+  if (!ret)
+    {
+      g_warning ("Failed to write edit trace: %s", error->message);
+      g_clear_object (&self->stream);
+    }
+}
+
+static const char *
+spelling_edit_trace_get_exceptions (void)
+{
+  static char exceptions[129];
+
+  /* UTF-8 is kept as is, only control characters are escaped */
+  if G_UNLIKELY (exceptions[0] == 0)
+    {
+      for (guint i = 0; i < 128; i++)
+        exceptions[i] = 0x80 + i;
+    }
+
+  return exceptions;
+}
+
+/* Returns a writer for a new trace if LIBSPELLING_EDIT_TRACE_DIR is set */
+SpellingEditTraceWriter *
+spelling_edit_trace_writer_new_from_env (void)
+{
+  static guint sequence;
+  g_autoptr(GFileOutputStream) file_stream = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) file = NULL;
+  g_autofree char *name = NULL;
+  SpellingEditTraceWriter *self;
+  const char *dir;
+
+  if (!(dir = g_getenv ("LIBSPELLING_EDIT_TRACE_DIR")) || dir[0] == 0)
+    return NULL;
+
+  name = g_strdup_printf ("libspelling-%d-%u.trace", getpid (), ++sequence);
+  file = g_file_new_build_filename (dir, name, NULL);
+
+  if (!(file_stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL, &error)))
+    {
+      g_warning ("Failed to record edit trace: %s", error->message);
+      return NULL;
+    }
+
+  self = g_new0 (SpellingEditTraceWriter, 1);
+  self->stream = g_buffered_output_stream_new (G_OUTPUT_STREAM (file_stream));
+  self->begin_time = g_get_monotonic_time ();
+  self->flush_time = self->begin_time;
+
+  if (!g_output_stream_write_all (self->stream, TRACE_HEADER "\n", strlen (TRACE_HEADER "\n"),
+                                  NULL, NULL, &error))
+    {
+      g_warning ("Failed to write edit trace: %s", error->message);
+      g_clear_object (&self->stream);
+    }
+
+  return self;
+}
+
+void
+spelling_edit_trace_writer_free (SpellingEditTraceWriter *self)
+{
+  if (self == NULL)
+    return;
+
+  if (self->stream != NULL)
+    g_output_stream_close (self->stream, NULL, NULL);
+
+  g_clear_object (&self->stream);
+  g_free (self);
+}
+
+void
+spelling_edit_trace_writer_insert (SpellingEditTraceWriter *self,
+                                   guint                    position,
+                                   const char              *text)
+{
+  g_autofree char *escaped = NULL;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (text != NULL);
+
+  escaped = g_strescape (text, spelling_edit_trace_get_exceptions ());
+  spelling_edit_trace_writer_printf (self, "i %u %s", position, escaped);
+}
+
+void
+spelling_edit_trace_writer_delete (SpellingEditTraceWriter *self,
+                                   guint                    position,
+                                   guint                    length)
+{
+  g_return_if_fail (self != NULL);
+
+  spelling_edit_trace_writer_printf (self, "d %u %u", position, length);
+}
+
+void
+spelling_edit_trace_writer_cursor (SpellingEditTraceWriter *self,
+                                   guint                    position)
+{
+  g_return_if_fail (self != NULL);
+
+  spelling_edit_trace_writer_printf (self, "c %u", position);
+}
+
+static void
+clear_event (gpointer data)
+{
+  SpellingEditTraceEvent *event = data;
+
+  g_clear_pointer (&event->text, g_free);
+}
+
+static gboolean
+parse_uint (const char  *str,
+            const char **endptr,
+            guint       *value)
+{
+  guint64 v;
+  char *end;
+
+  if (!g_ascii_isdigit (*str))
+    return FALSE;
+
+  v = g_ascii_strtoull (str, &end, 10);
+
+  if (v > G_MAXUINT)
+    return FALSE;
+
+  *value = v;
+  *endptr = end;
+
+  return TRUE;
+}
+
+static gboolean
+parse_event (const char             *line,
+             SpellingEditTraceEvent *event)
+{
+  const char *p;
+  char *end;
+
+  if (!g_ascii_isdigit (*line))
+    return FALSE;
+
+  event->time = g_ascii_strtoll (line, &end, 10);
+  p = end;
+
+  if (p[0] != ' ' || p[1] == 0 || p[2] != ' ')
+    return FALSE;
+
+  event->kind = p[1];
+
+  if (!parse_uint (p + 3, &p, &event->position))
+    return FALSE;
+
+  switch (event->kind)
+    {
+    case SPELLING_EDIT_TRACE_INSERT:
+      if (*p != ' ')
+        return FALSE;
+      event->text = g_strcompress (p + 1);
+      if (!g_utf8_validate (event->text, -1, NULL))
+        return FALSE;
+      event->length = g_utf8_strlen (event->text, -1);
+      return TRUE;
+
+    case SPELLING_EDIT_TRACE_DELETE:
+      return *p == ' ' && parse_uint (p + 1, &p, &event->length) && *p == 0;
+
+    case SPELLING_EDIT_TRACE_CURSOR:
+      return *p == 0;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Loads the events of a trace, in order. Positions are not validated
+ * since that requires replaying the edits.
+ */
+GArray *
+spelling_edit_trace_load (const char  *path,
+                          GError     **error)
+{
+  g_autoptr(GArray) events = NULL;
+  g_autofree char *contents = NULL;
+  g_auto(GStrv) lines = NULL;
+  gint64 last_time = 0;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  if (!g_file_get_contents (path, &contents, NULL, error))
+    return NULL;
+
+  if (!g_str_has_prefix (contents, TRACE_HEADER "\n"))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                   "%s is not a libspelling edit trace", path);
+      return NULL;
+    }
+
+  events = g_array_new (FALSE, TRUE, sizeof (SpellingEditTraceEvent));
+  g_array_set_clear_func (events, clear_event);
+
+  lines = g_strsplit (contents, "\n", 0);
+
+  for (guint i = 1; lines[i] != NULL; i++)
+    {
+      SpellingEditTraceEvent event = {0};
+
+      if (lines[i][0] == 0 || lines[i][0] == '#')
+        continue;
+
+      if (!parse_event (lines[i], &event) || event.time < last_time)
+        {
+          clear_event (&event);
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                       "%s:%u: invalid event", path, i + 1);
+          return NULL;
+        }
+
+      last_time = event.time;
+      g_array_append_val (events, event);
+    }
+
+  return g_steal_pointer (&events);
+}
@@ -23,6 +23,8 @@
 #include <gtk/gtk.h>
 
 #include "spelling-dictionary-internal.h"
+#include "spelling-scheduler-private.h"
+#include "spelling-stats-private.h"
 
 G_BEGIN_DECLS
 
@@ -35,7 +37,7 @@ typedef struct _SpellingAdapter
   char               *(*copy_text)                   (gpointer   instance,
                                                       guint      position,
                                                       guint      length);
-  void                (*apply_tag)                   (gpointer   instance,
+  gboolean            (*apply_tag)                   (gpointer   instance,
                                                       guint      position,
                                                       guint      length);
   void                (*clear_tag)                   (gpointer   instance,
@@ -49,27 +51,46 @@ typedef struct _SpellingAdapter
                                                       GtkBitset *region);
   PangoLanguage      *(*get_language)                (gpointer   instance);
   SpellingDictionary *(*get_dictionary)              (gpointer   instance);
+  gboolean            (*get_visible_range)           (gpointer   instance,
+                                                      guint     *begin,
+                                                      guint     *end);
+  GdkFrameClock      *(*get_frame_clock)             (gpointer   instance);
+  void                (*finished)                    (gpointer   instance);
 } SpellingAdapter;
 
 G_DECLARE_FINAL_TYPE (SpellingEngine, spelling_engine, SPELLING, ENGINE, GObject)
 
-SpellingEngine *spelling_engine_new                 (const SpellingAdapter *adapter,
-                                                     GObject               *instance);
-void            spelling_engine_before_insert_text  (SpellingEngine        *self,
-                                                     guint                  position,
-                                                     guint                  length);
-void            spelling_engine_after_insert_text   (SpellingEngine        *self,
-                                                     guint                  position,
-                                                     guint                  length);
-void            spelling_engine_before_delete_range (SpellingEngine        *self,
-                                                     guint                  position,
-                                                     guint                  length);
-void            spelling_engine_after_delete_range  (SpellingEngine        *self,
-                                                     guint                  position);
-void            spelling_engine_iteration           (SpellingEngine        *self);
-void            spelling_engine_invalidate          (SpellingEngine        *self,
-                                                     guint                  position,
-                                                     guint                  length);
-void            spelling_engine_invalidate_all      (SpellingEngine        *self);
+SpellingEngine *spelling_engine_new                   (const SpellingAdapter     *adapter,
+                                                       GObject                   *instance);
+void            spelling_engine_before_insert_text    (SpellingEngine            *self,
+                                                       guint                      position,
+                                                       guint                      length);
+void            spelling_engine_after_insert_text     (SpellingEngine            *self,
+                                                       guint                      position,
+                                                       guint                      length);
+void            spelling_engine_before_delete_range   (SpellingEngine            *self,
+                                                       guint                      position,
+                                                       guint                      length);
+void            spelling_engine_after_delete_range    (SpellingEngine            *self,
+                                                       guint                      position);
+void            spelling_engine_iteration             (SpellingEngine            *self);
+void            spelling_engine_invalidate            (SpellingEngine            *self,
+                                                       guint                      position,
+                                                       guint                      length);
+void            spelling_engine_invalidate_all        (SpellingEngine            *self);
+double          spelling_engine_get_rate              (SpellingEngine            *self);
+guint           spelling_engine_get_job_size          (SpellingEngine            *self);
+gboolean        spelling_engine_get_busy              (SpellingEngine            *self);
+guint           spelling_engine_get_n_overruns        (SpellingEngine            *self);
+SpellingStats  *spelling_engine_dup_stats             (SpellingEngine            *self);
+void            spelling_engine_set_use_cache         (SpellingEngine            *self,
+                                                       gboolean                   use_cache);
+void            spelling_engine_restore               (SpellingEngine            *self);
+void            spelling_engine_flush_cache           (SpellingEngine            *self);
+void            spelling_engine_recheck_word          (SpellingEngine            *self,
+                                                       const char                *word);
+void            spelling_engine_visible_range_changed (SpellingEngine            *self);
+void            spelling_engine_set_priority          (SpellingEngine            *self,
+                                                       SpellingSchedulerPriority  priority);
 
 G_END_DECLS
@@ -20,34 +20,170 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gtksourceview/gtksource.h>
 
 #include "cjhtextregionprivate.h"
 
+#include "spelling-cache-private.h"
 #include "spelling-engine-private.h"
 #include "spelling-job-private.h"
+#include "spelling-scheduler-private.h"
+#include "spelling-stats-private.h"
+#include "spelling-trace.h"
 
 #define TAG_NEEDS_CHECK        GUINT_TO_POINTER(1)
 #define TAG_CHECKED            GUINT_TO_POINTER(0)
+#define TAG_IN_FLIGHT          GUINT_TO_POINTER(2)
+#define MISTAKE_NONE           NULL
+#define MISTAKE_TAGGED         GUINT_TO_POINTER(1)
+#define HANDED_OUT_NONE        NULL
+#define HANDED_OUT             GUINT_TO_POINTER(1)
 #define INVALIDATE_DELAY_MSECS 100
-#define WATERMARK_PER_JOB      1000
+
+/* Up to MAX_ACTIVE_JOBS jobs may be checking disjoint ranges at once.
+ * Ranges handed to a job are tagged TAG_IN_FLIGHT in the region so that
+ * they are not collected again until the job delivers its results.
+ */
+#define MAX_ACTIVE_JOBS        4
+
+/* Jobs are sized so that checking them takes about JOB_BUDGET_USEC based
+ * on the rate measured for recent jobs. Until something was measured the
+ * engine starts out with JOB_SIZE_INITIAL characters.
+ */
+#define JOB_BUDGET_USEC        8000
+#define JOB_SIZE_INITIAL       1000
+#define JOB_SIZE_MIN           100
+#define JOB_SIZE_MAX           (1000 * 1000)
+#define RATE_MIN_SAMPLE        64
+#define RATE_SMOOTHING         0.25
+
+/* Results are applied in slices of APPLY_BUDGET_USEC from the frame clock
+ * of the widget, or from an idle callback without one, so that applying
+ * many tags at once does not delay frames. A slice taking longer than a
+ * whole frame is counted as an overrun.
+ */
+#define APPLY_BUDGET_USEC      4000
+#define FRAME_USEC_DEFAULT     16667
+
+/* While the text keeps changing, the cache is written at most once per
+ * CACHE_SAVE_INTERVAL_SECS. spelling_engine_flush_cache() writes what
+ * is left when the text is closed.
+ */
+#define CACHE_SAVE_INTERVAL_SECS 30
+
+/* Edits are applied to the positions of a misspelled word in the index
+ * when they are needed. Once INDEX_MAX_EDITS piled up they are applied
+ * to every word, which also drops positions that are not tagged anymore.
+ */
+#define INDEX_MAX_EDITS        256
 
 struct _SpellingEngine
 {
   GObject          parent_instance;
   CjhTextRegion   *region;
+
+  /* What the adapter was told to tag as misspelled, so that new results
+   * only turn into the tag changes needed to get there.
+   */
+  CjhTextRegion   *mistakes;
+
+  /* Ranges handed to jobs whose results were not applied yet. What is
+   * left once every job is done was discarded because of edits, which
+   * this finds without walking every run of @region.
+   */
+  CjhTextRegion   *handed_out;
+
+  /* Where each misspelled word was tagged, by the hash of the word, so
+   * that accepting a word only visits its own mistakes. Edits since are
+   * kept in @index_edits.
+   */
+  GHashTable      *index;
+  GArray          *index_edits;
+
+  /* Hashes of words accepted while results from before were on their
+   * way, which are filtered from them until everything settled.
+   */
+  GArray          *accepted;
+
   GWeakRef         instance_wr;
-  SpellingJob     *active;
+  GPtrArray       *active;
   SpellingAdapter  adapter;
   guint            queued_update_handler;
+
+  /* Smoothed characters checked per microsecond and the size of the next
+   * job which follows from it.
+   */
+  double           rate;
+  guint            job_size;
+
+  /* Results waiting to be applied, in order, starting at @n_applied. The
+   * mistakes of each result are a range of @pending_mistakes.
+   */
+  GArray          *pending;
+  GArray          *pending_mistakes;
+  guint            n_applied;
+  GdkFrameClock   *frame_clock;
+  gulong           frame_clock_handler;
+  guint            apply_handler;
+  guint            n_overruns;
+
+  /* Shared with every job so they can count from worker threads */
+  SpellingCounters *counters;
+
+  /* What this engine added to the process-wide profiler gauges */
+  gssize           reported_unchecked;
+  gssize           reported_active;
+
+  /* The cache file last written or restored, which is replaced by the
+   * next one written, when that was last done and the pending write.
+   */
+  char            *cache_path;
+  gint64           cache_saved_at;
+  guint            cache_save_handler;
+
+  /* Loading the cache, cancelled by edits which make it stale */
+  GCancellable    *restore_cancellable;
+
+  /* Whether mistakes are saved to the cache once everything is checked,
+   * and whether anything changed since they were saved or restored.
+   */
+  guint            use_cache : 1;
+  guint            cache_dirty : 1;
 };
 
 typedef struct
 {
-  SpellingEngine *self;
+  SpellingBoundary range;
+  guint            first_mistake;
+  guint            n_mistakes;
+  guint            restored : 1;
+} PendingResult;
+
+typedef struct
+{
+  guint position;
+  guint removed;
+  guint inserted;
+} IndexEdit;
+
+typedef struct
+{
+  guint64  hash;
+  guint    length;
+  /* Number of @index_edits applied to @offsets, which are sorted */
+  guint    n_edits;
+  GArray  *offsets;
+} IndexEntry;
+
+typedef struct
+{
   GObject        *instance;
+  SpellingJob    *job;
   GtkBitset      *bitset;
   GtkBitset      *all;
+  GtkBitset      *collected;
   guint           size;
 } CollectRanges;
 
@@ -56,6 +192,38 @@ G_DEFINE_FINAL_TYPE (SpellingEngine, spelling_engine, G_TYPE_OBJECT)
 static void spelling_engine_queue_update (SpellingEngine *self,
                                           guint           delay_msec);
 
+/* Copies text from the adapter, counting how much was copied */
+static char *
+spelling_engine_copy_text (SpellingEngine *self,
+                           GObject        *instance,
+                           guint           position,
+                           guint           length)
+{
+  char *text = self->adapter.copy_text (instance, position, length);
+
+  spelling_counters_add (self->counters, &self->counters->bytes_copied, strlen (text));
+
+  return text;
+}
+
+/* Updates this engine's share of the unchecked and active job gauges */
+static void
+spelling_engine_update_counters (SpellingEngine *self)
+{
+#ifdef SPELLING_PROFILER_ENABLED
+  gssize unchecked = self->region ? _cjh_text_region_get_tracked_length (self->region) : 0;
+  gssize active = self->active ? self->active->len : 0;
+
+  SPELLING_PROFILER_COUNTER_ADD (SPELLING_PROFILER_COUNTER_UNCHECKED,
+                                 unchecked - self->reported_unchecked);
+  SPELLING_PROFILER_COUNTER_ADD (SPELLING_PROFILER_COUNTER_ACTIVE_JOBS,
+                                 active - self->reported_active);
+
+  self->reported_unchecked = unchecked;
+  self->reported_active = active;
+#endif
+}
+
 static gboolean
 spelling_engine_check_enabled (SpellingEngine *self)
 {
@@ -67,22 +235,11 @@ spelling_engine_check_enabled (SpellingEngine *self)
   return FALSE;
 }
 
-static gboolean
-has_unchecked_regions_cb (gsize                   offset,
-                          const CjhTextRegionRun *run,
-                          gpointer                user_data)
-{
-  gboolean *ret = user_data;
-  *ret |= run->data == TAG_NEEDS_CHECK;
-  return *ret;
-}
-
 static gboolean
 spelling_engine_has_unchecked_regions (SpellingEngine *self)
 {
-  gboolean ret = FALSE;
-  _cjh_text_region_foreach (self->region, has_unchecked_regions_cb, &ret);
-  return ret;
+  /* The region keeps a count of TAG_NEEDS_CHECK in the tree */
+  return _cjh_text_region_get_tracked_length (self->region) > 0;
 }
 
 static gboolean
@@ -127,7 +284,7 @@ spelling_engine_add_fragment (SpellingEngine *self,
   g_assert (bitset != NULL);
   g_assert (end >= begin);
 
-  text = self->adapter.copy_text (instance, begin, end - begin + 1);
+  text = spelling_engine_copy_text (self, instance, begin, end - begin + 1);
   bytes = g_bytes_new_take (text, strlen (text));
 
   spelling_job_add_fragment (job, bytes, begin, end - begin + 1);
@@ -164,76 +321,947 @@ spelling_engine_add_fragments (SpellingEngine *self,
             }
         }
 
-      spelling_engine_add_fragment (self, instance, job, bitset, begin, end);
-    }
+      spelling_engine_add_fragment (self, instance, job, bitset, begin, end);
+    }
+}
+
+static gsize
+spelling_engine_add_range (SpellingEngine *self,
+                           GObject        *instance,
+                           SpellingJob    *job,
+                           guint           begin,
+                           guint           end,
+                           GtkBitset      *all,
+                           GtkBitset      *bitset,
+                           GtkBitset      *collected)
+{
+  G_GNUC_UNUSED gint64 intersect_time;
+  gsize ret;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+  g_assert (SPELLING_IS_JOB (job));
+  g_assert (begin <= end);
+  g_assert (all != NULL);
+  g_assert (bitset != NULL);
+  g_assert (collected != NULL);
+
+  /* Ranges are collected from the cursor, the viewport and then the
+   * rest of the buffer which may overlap, so skip anything that is
+   * already part of the job.
+   */
+  gtk_bitset_add_range (bitset, begin, end - begin);
+  gtk_bitset_subtract (bitset, collected);
+  gtk_bitset_add_range (collected, begin, end - begin);
+
+  if (gtk_bitset_is_empty (bitset))
+    return 0;
+
+  /* Track this range in "all" as we'll need to clear the areas
+   * that have "no-spell-check" in our textregion too. We can
+   * figure that out by subtracting bitset from all.
+   */
+  gtk_bitset_union (all, bitset);
+
+  /* Track what the adapter thinks should be in this run */
+  intersect_time = SPELLING_PROFILER_CURRENT_TIME;
+  self->adapter.intersect_spellcheck_region (instance, bitset);
+  SPELLING_PROFILER_MARK (SPELLING_PROFILER_CURRENT_TIME - intersect_time, "Intersect", NULL);
+
+  /* And now subtract that from the all to cover the gaps */
+  gtk_bitset_subtract (all, bitset);
+
+  /* Add fragments for the sub-regions we need to check */
+  spelling_engine_add_fragments (self, instance, job, bitset);
+
+  /* Track the size so we can bail after sufficent data to check */
+  ret = gtk_bitset_get_size (bitset);
+
+  /* Reset bitset for next run */
+  gtk_bitset_remove_all (bitset);
+
+  return ret;
+}
+
+static void
+spelling_engine_collect_range (SpellingEngine *self,
+                               CollectRanges  *collect,
+                               gsize           begin,
+                               gsize           end)
+{
+  gsize run_begin;
+  gsize run_end;
+
+  end = MIN (end, _cjh_text_region_get_length (self->region));
+
+  /* Jump from one TAG_NEEDS_CHECK run to the next using the counts kept
+   * in the region rather than visiting every run in the range.
+   */
+  while (begin < end &&
+         collect->size < self->job_size &&
+         _cjh_text_region_find_tracked (self->region, begin, &run_begin, &run_end) &&
+         run_begin < end)
+    {
+      guint range_begin = run_begin;
+      guint range_end = MIN (run_end, end);
+
+      spelling_engine_extend_range (self, &range_begin, &range_end);
+
+      collect->size += spelling_engine_add_range (self,
+                                                  collect->instance,
+                                                  collect->job,
+                                                  range_begin, range_end,
+                                                  collect->all,
+                                                  collect->bitset,
+                                                  collect->collected);
+
+      begin = run_end;
+    }
+}
+
+static void
+spelling_engine_update_rate (SpellingEngine *self,
+                             SpellingJob    *job)
+{
+  guint length = spelling_job_get_length (job);
+  gint64 elapsed = spelling_job_get_elapsed (job);
+  double rate;
+
+  /* Tiny jobs, such as the word at the cursor, are mostly overhead */
+  if (length < RATE_MIN_SAMPLE || elapsed <= 0)
+    return;
+
+  rate = (double)length / (double)elapsed;
+
+  if (self->rate == 0)
+    self->rate = rate;
+  else
+    self->rate += (rate - self->rate) * RATE_SMOOTHING;
+
+  self->job_size = CLAMP (self->rate * JOB_BUDGET_USEC, JOB_SIZE_MIN, JOB_SIZE_MAX);
+
+  SPELLING_PROFILER_LOG ("Checked %u characters in %"G_GINT64_FORMAT"usec, next job %u characters",
+                         length, elapsed, self->job_size);
+}
+
+/* Appends the contiguous ranges of @bitset to @ranges */
+static void
+spelling_engine_get_ranges (GtkBitset *bitset,
+                            GArray    *ranges)
+{
+  GtkBitsetIter iter;
+  guint pos;
+
+  g_assert (bitset != NULL);
+  g_assert (ranges != NULL);
+
+  if (gtk_bitset_iter_init_first (&iter, bitset, &pos))
+    {
+      SpellingBoundary range = { .offset = pos, .length = 1 };
+
+      while (gtk_bitset_iter_next (&iter, &pos))
+        {
+          if (pos == range.offset + range.length)
+            {
+              range.length++;
+              continue;
+            }
+
+          g_array_append_val (ranges, range);
+
+          range.offset = pos;
+          range.length = 1;
+        }
+
+      g_array_append_val (ranges, range);
+    }
+}
+
+typedef struct
+{
+  GArray *ranges;
+  gsize   begin;
+  gsize   end;
+} RequeueInFlight;
+
+static gboolean
+requeue_in_flight_cb (gsize                   offset,
+                      const CjhTextRegionRun *run,
+                      gpointer                user_data)
+{
+  RequeueInFlight *requeue = user_data;
+
+  if (run->data == TAG_IN_FLIGHT)
+    {
+      gsize begin = MAX (offset, requeue->begin);
+      gsize end = MIN (offset + run->length, requeue->end);
+      SpellingBoundary range = { .offset = begin, .length = end - begin };
+
+      g_array_append_val (requeue->ranges, range);
+    }
+
+  return FALSE;
+}
+
+static void
+spelling_engine_requeue_in_flight (SpellingEngine *self)
+{
+  g_autoptr(GArray) ranges = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+  RequeueInFlight requeue = { ranges, 0, 0 };
+  gsize length;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+  g_assert (self->active->len == 0);
+
+  /* Collect first, the region must not change while iterating it. Only
+   * ranges handed out and never delivered can still be in flight.
+   */
+  while (_cjh_text_region_find_tracked (self->handed_out, requeue.end, &requeue.begin, &requeue.end))
+    _cjh_text_region_foreach_in_range (self->region, requeue.begin, requeue.end,
+                                       requeue_in_flight_cb, &requeue);
+
+  for (guint i = 0; i < ranges->len; i++)
+    {
+      const SpellingBoundary *range = &g_array_index (ranges, SpellingBoundary, i);
+      _cjh_text_region_replace (self->region, range->offset, range->length, TAG_NEEDS_CHECK);
+    }
+
+  if ((length = _cjh_text_region_get_length (self->handed_out)) > 0 &&
+      _cjh_text_region_get_tracked_length (self->handed_out) > 0)
+    _cjh_text_region_replace (self->handed_out, 0, length, HANDED_OUT_NONE);
+}
+
+static void
+index_entry_free (gpointer data)
+{
+  IndexEntry *entry = data;
+
+  g_clear_pointer (&entry->offsets, g_array_unref);
+  g_free (entry);
+}
+
+/* Returns %TRUE if exactly @length characters at @offset are tagged */
+static gboolean
+spelling_engine_is_tagged (SpellingEngine *self,
+                           guint           offset,
+                           guint           length)
+{
+  gsize begin;
+  gsize end;
+
+  return _cjh_text_region_find_tracked (self->mistakes, offset, &begin, &end) &&
+         begin == offset &&
+         end == offset + length;
+}
+
+/* Applies the edits recorded since the positions of @entry were last
+ * used. Edits touching a word change it, so its position is dropped.
+ */
+static void
+spelling_engine_index_catch_up (SpellingEngine *self,
+                                IndexEntry     *entry)
+{
+  for (; entry->n_edits < self->index_edits->len; entry->n_edits++)
+    {
+      const IndexEdit *edit = &g_array_index (self->index_edits, IndexEdit, entry->n_edits);
+      guint n = 0;
+
+      for (guint i = 0; i < entry->offsets->len; i++)
+        {
+          guint offset = g_array_index (entry->offsets, guint, i);
+
+          if (edit->position <= offset + entry->length &&
+              edit->position + edit->removed >= offset)
+            continue;
+
+          if (edit->position < offset)
+            offset = offset - edit->removed + edit->inserted;
+
+          g_array_index (entry->offsets, guint, n++) = offset;
+        }
+
+      g_array_set_size (entry->offsets, n);
+    }
+}
+
+/* Applies every recorded edit and forgets positions which are not
+ * tagged anymore, such as after they were checked again.
+ */
+static void
+spelling_engine_index_compact (SpellingEngine *self)
+{
+  GHashTableIter iter;
+  IndexEntry *entry;
+
+  g_hash_table_iter_init (&iter, self->index);
+
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&entry))
+    {
+      guint n = 0;
+
+      spelling_engine_index_catch_up (self, entry);
+
+      for (guint i = 0; i < entry->offsets->len; i++)
+        {
+          guint offset = g_array_index (entry->offsets, guint, i);
+
+          if (spelling_engine_is_tagged (self, offset, entry->length))
+            g_array_index (entry->offsets, guint, n++) = offset;
+        }
+
+      g_array_set_size (entry->offsets, n);
+      entry->n_edits = 0;
+
+      if (n == 0)
+        g_hash_table_iter_remove (&iter);
+    }
+
+  g_array_set_size (self->index_edits, 0);
+}
+
+/* Records an edit for the positions in the index */
+static void
+spelling_engine_index_edit (SpellingEngine *self,
+                            guint           position,
+                            guint           removed,
+                            guint           inserted)
+{
+  IndexEdit edit = { position, removed, inserted };
+
+  if (g_hash_table_size (self->index) == 0)
+    return;
+
+  g_array_append_val (self->index_edits, edit);
+
+  if (self->index_edits->len >= INDEX_MAX_EDITS)
+    spelling_engine_index_compact (self);
+}
+
+/* Remembers that the word of @mistake is tagged at its offset */
+static void
+spelling_engine_index_add (SpellingEngine        *self,
+                           const SpellingMistake *mistake)
+{
+  IndexEntry *entry;
+  guint lo = 0;
+  guint hi;
+
+  if (mistake->hash == 0)
+    return;
+
+  if (!(entry = g_hash_table_lookup (self->index, &mistake->hash)))
+    {
+      entry = g_new0 (IndexEntry, 1);
+      entry->hash = mistake->hash;
+      entry->length = mistake->length;
+      entry->n_edits = self->index_edits->len;
+      entry->offsets = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (self->index, &entry->hash, entry);
+    }
+
+  /* Another word with the same hash, which is left out */
+  if (entry->length != mistake->length)
+    return;
+
+  spelling_engine_index_catch_up (self, entry);
+
+  hi = entry->offsets->len;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (g_array_index (entry->offsets, guint, mid) < mistake->offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  if (lo < entry->offsets->len && g_array_index (entry->offsets, guint, lo) == mistake->offset)
+    return;
+
+  g_array_insert_val (entry->offsets, lo, mistake->offset);
+}
+
+static void
+spelling_engine_index_clear (SpellingEngine *self)
+{
+  g_hash_table_remove_all (self->index);
+  g_array_set_size (self->index_edits, 0);
+}
+
+/* Returns %TRUE if the word of @mistake was accepted after the result
+ * it came with was looked up.
+ */
+static gboolean
+spelling_engine_is_accepted (SpellingEngine        *self,
+                             const SpellingMistake *mistake)
+{
+  if (mistake->hash == 0)
+    return FALSE;
+
+  for (guint i = 0; i < self->accepted->len; i++)
+    {
+      if (g_array_index (self->accepted, guint64, i) == mistake->hash)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+spelling_engine_apply (SpellingEngine         *self,
+                       GObject                *instance,
+                       const SpellingBoundary *fragments,
+                       guint                   n_fragments,
+                       const SpellingMistake  *mistakes,
+                       guint                   n_mistakes)
+{
+  g_autoptr(GtkBitset) tagged = gtk_bitset_new_empty ();
+  g_autoptr(GtkBitset) removed = NULL;
+  g_autoptr(GArray) ranges = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+
+  /* Find what is tagged within the fragments right now */
+  for (guint f = 0; f < n_fragments; f++)
+    {
+      gsize begin = fragments[f].offset;
+      gsize end = begin + fragments[f].length;
+      gsize run_begin;
+      gsize run_end;
+
+      while (begin < end &&
+             _cjh_text_region_find_tracked (self->mistakes, begin, &run_begin, &run_end) &&
+             run_begin < end)
+        {
+          gtk_bitset_add_range_closed (tagged, run_begin, MIN (run_end, end) - 1);
+          begin = run_end;
+        }
+
+      _cjh_text_region_replace (self->region,
+                                fragments[f].offset, fragments[f].length,
+                                TAG_CHECKED);
+      _cjh_text_region_replace (self->handed_out,
+                                fragments[f].offset, fragments[f].length,
+                                HANDED_OUT_NONE);
+    }
+
+  /* Whatever is tagged but not a mistake anymore is cleared in as few
+   * calls as possible. Mistakes that are tagged already are left alone
+   * so that checking the same text again does not touch the buffer.
+   */
+  removed = gtk_bitset_copy (tagged);
+
+  for (guint m = 0; m < n_mistakes; m++)
+    {
+      if (!spelling_engine_is_accepted (self, &mistakes[m]))
+        gtk_bitset_remove_range (removed, mistakes[m].offset, mistakes[m].length);
+    }
+
+  spelling_engine_get_ranges (removed, ranges);
+
+  for (guint r = 0; r < ranges->len; r++)
+    {
+      const SpellingBoundary *range = &g_array_index (ranges, SpellingBoundary, r);
+
+      self->adapter.clear_tag (instance, range->offset, range->length);
+      _cjh_text_region_replace (self->mistakes, range->offset, range->length, MISTAKE_NONE);
+      self->cache_dirty = TRUE;
+    }
+
+  for (guint m = 0; m < n_mistakes; m++)
+    {
+      if (spelling_engine_is_accepted (self, &mistakes[m]))
+        continue;
+
+      if (gtk_bitset_get_size_in_range (tagged,
+                                        mistakes[m].offset,
+                                        mistakes[m].offset + mistakes[m].length - 1) == mistakes[m].length)
+        {
+          spelling_engine_index_add (self, &mistakes[m]);
+          continue;
+        }
+
+      /* The adapter may refuse, such as for the word being typed */
+      if (self->adapter.apply_tag (instance, mistakes[m].offset, mistakes[m].length))
+        {
+          _cjh_text_region_replace (self->mistakes,
+                                    mistakes[m].offset, mistakes[m].length,
+                                    MISTAKE_TAGGED);
+          spelling_engine_index_add (self, &mistakes[m]);
+          self->cache_dirty = TRUE;
+        }
+    }
+}
+
+static gboolean
+spelling_engine_has_pending (SpellingEngine *self)
+{
+  return self->n_applied < self->pending->len;
+}
+
+static void
+spelling_engine_clear_pending (SpellingEngine *self)
+{
+  g_array_set_size (self->pending, 0);
+  g_array_set_size (self->pending_mistakes, 0);
+  self->n_applied = 0;
+}
+
+/* Queues results to be applied by spelling_engine_apply_pending(). The
+ * mistakes of each checked range directly follow those of the previous
+ * one, as they are collected by the job.
+ */
+static void
+spelling_engine_push_pending (SpellingEngine         *self,
+                              const SpellingBoundary *fragments,
+                              guint                   n_fragments,
+                              const SpellingMistake  *mistakes,
+                              guint                   n_mistakes)
+{
+  guint m = 0;
+
+  for (guint f = 0; f < n_fragments; f++)
+    {
+      PendingResult result;
+      guint end = fragments[f].offset + fragments[f].length;
+
+      result.range = fragments[f];
+      result.first_mistake = self->pending_mistakes->len;
+      result.n_mistakes = 0;
+      result.restored = FALSE;
+
+      for (; m < n_mistakes; m++)
+        {
+          if (mistakes[m].offset < fragments[f].offset ||
+              mistakes[m].offset + mistakes[m].length > end)
+            break;
+
+          g_array_append_val (self->pending_mistakes, mistakes[m]);
+          result.n_mistakes++;
+        }
+
+      g_array_append_val (self->pending, result);
+    }
+
+  g_assert (m == n_mistakes);
+}
+
+/* Queues mistakes restored from the cache, one result each so that
+ * applying them is sliced like the results of jobs.
+ */
+static void
+spelling_engine_push_restored (SpellingEngine        *self,
+                               const SpellingMistake *mistakes,
+                               guint                  n_mistakes)
+{
+  for (guint m = 0; m < n_mistakes; m++)
+    {
+      PendingResult result;
+
+      result.range.offset = mistakes[m].offset;
+      result.range.length = mistakes[m].length;
+      result.first_mistake = self->pending_mistakes->len;
+      result.n_mistakes = 1;
+      result.restored = TRUE;
+
+      g_array_append_val (self->pending_mistakes, mistakes[m]);
+      g_array_append_val (self->pending, result);
+    }
+}
+
+/* Tags a mistake restored from the cache unless its text was checked
+ * since, in which case that result is more recent. The text stays
+ * tagged as needing a check so that the mistake is verified.
+ */
+static void
+spelling_engine_apply_restored (SpellingEngine        *self,
+                                GObject               *instance,
+                                const SpellingMistake *mistake)
+{
+  gsize begin;
+  gsize end;
+
+  if (!_cjh_text_region_find_tracked (self->region, mistake->offset, &begin, &end) ||
+      begin > mistake->offset ||
+      end < mistake->offset + mistake->length)
+    return;
+
+  if (self->adapter.apply_tag (instance, mistake->offset, mistake->length))
+    _cjh_text_region_replace (self->mistakes,
+                              mistake->offset, mistake->length,
+                              MISTAKE_TAGGED);
+}
+
+/* Moves results waiting to be applied along with an edit of the text
+ * between @begin and @end, which shifts the text after it by @shift.
+ * Results touching the edit are dropped so that the text is checked
+ * again.
+ */
+static void
+spelling_engine_edit_pending (SpellingEngine *self,
+                              guint           begin,
+                              guint           end,
+                              int             shift)
+{
+  for (guint i = self->n_applied; i < self->pending->len; i++)
+    {
+      PendingResult *result = &g_array_index (self->pending, PendingResult, i);
+
+      if (result->range.length == 0 ||
+          result->range.offset + result->range.length < begin)
+        continue;
+
+      if (result->range.offset <= end)
+        {
+          result->range.length = 0;
+          result->n_mistakes = 0;
+          continue;
+        }
+
+      result->range.offset += shift;
+
+      for (guint m = 0; m < result->n_mistakes; m++)
+        g_array_index (self->pending_mistakes, SpellingMistake, result->first_mistake + m).offset += shift;
+    }
+}
+
+static gboolean
+collect_mistakes_cb (gsize                   offset,
+                     const CjhTextRegionRun *run,
+                     gpointer                user_data)
+{
+  GArray *mistakes = user_data;
+
+  if (run->data == MISTAKE_TAGGED)
+    {
+      SpellingMistake mistake = { .offset = offset, .length = run->length };
+      g_array_append_val (mistakes, mistake);
+    }
+
+  return FALSE;
+}
+
+static void
+spelling_engine_cache_saved_cb (GObject      *object,
+                                GAsyncResult *result,
+                                gpointer      user_data)
+{
+  g_autoptr(SpellingEngine) self = user_data;
+  g_autoptr(GError) error = NULL;
+  char *path;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+
+  if (!(path = spelling_cache_save_finish (result, &error)))
+    {
+      g_debug ("Failed to save spellcheck cache: %s", error->message);
+      return;
+    }
+
+  g_free (self->cache_path);
+  self->cache_path = path;
+}
+
+/* Saves the mistakes of the text to the cache if it has been checked
+ * completely. Hashing and writing happen on a thread.
+ */
+static void
+spelling_engine_write_cache (SpellingEngine *self)
+{
+  g_autoptr(GObject) instance = NULL;
+  SpellingDictionary *dictionary;
+  GArray *mistakes;
+  guint length;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+
+  g_clear_handle_id (&self->cache_save_handler, g_source_remove);
+
+  if (!self->use_cache ||
+      !self->cache_dirty ||
+      spelling_engine_get_busy (self) ||
+      !(instance = g_weak_ref_get (&self->instance_wr)) ||
+      !self->adapter.check_enabled (instance) ||
+      !(dictionary = self->adapter.get_dictionary (instance)))
+    return;
+
+  if (!(length = _cjh_text_region_get_length (self->region)))
+    return;
+
+  mistakes = g_array_new (FALSE, FALSE, sizeof (SpellingMistake));
+  _cjh_text_region_foreach (self->mistakes, collect_mistakes_cb, mistakes);
+
+  self->cache_dirty = FALSE;
+  self->cache_saved_at = g_get_monotonic_time ();
+
+  spelling_cache_save_async (spelling_dictionary_get_code (dictionary),
+                             spelling_engine_copy_text (self, instance, 0, length),
+                             length,
+                             mistakes,
+                             self->cache_path,
+                             spelling_engine_cache_saved_cb,
+                             g_object_ref (self));
+}
+
+static gboolean
+spelling_engine_save_cache_cb (gpointer data)
+{
+  SpellingEngine *self = data;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+
+  self->cache_save_handler = 0;
+  spelling_engine_write_cache (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Saves the mistakes to the cache, or once CACHE_SAVE_INTERVAL_SECS
+ * passed since the last time so that every pause while typing does not
+ * copy and write out the whole text.
+ */
+static void
+spelling_engine_save_cache (SpellingEngine *self)
+{
+  gint64 elapsed;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+
+  if (!self->use_cache || !self->cache_dirty || self->cache_save_handler != 0)
+    return;
+
+  elapsed = g_get_monotonic_time () - self->cache_saved_at;
+
+  if (self->cache_saved_at == 0 || elapsed >= CACHE_SAVE_INTERVAL_SECS * G_USEC_PER_SEC)
+    spelling_engine_write_cache (self);
+  else
+    self->cache_save_handler =
+      g_timeout_add_full (G_PRIORITY_LOW,
+                          (CACHE_SAVE_INTERVAL_SECS * G_USEC_PER_SEC - elapsed) / 1000,
+                          spelling_engine_save_cache_cb,
+                          self,
+                          NULL);
+}
+
+/* Lets the adapter know once everything has been checked */
+static void
+spelling_engine_notify_finished (SpellingEngine *self)
+{
+  g_autoptr(GObject) instance = NULL;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+
+  if (self->adapter.finished != NULL &&
+      !spelling_engine_get_busy (self) &&
+      (instance = g_weak_ref_get (&self->instance_wr)))
+    self->adapter.finished (instance);
+}
+
+/* Once no job is active and no result is waiting anymore, ranges which
+ * are still tagged as in flight belonged to fragments discarded because
+ * of edits and must be collected again.
+ */
+static void
+spelling_engine_settle (SpellingEngine *self)
+{
+  if (self->active->len == 0 && !spelling_engine_has_pending (self))
+    {
+      spelling_engine_requeue_in_flight (self);
+      g_array_set_size (self->accepted, 0);
+    }
+
+  /* Check immediately if there is more */
+  if (spelling_engine_has_unchecked_regions (self))
+    {
+      spelling_engine_queue_update (self, 0);
+    }
+  else
+    {
+      spelling_engine_save_cache (self);
+      spelling_engine_notify_finished (self);
+    }
+}
+
+/* Applies waiting results for up to APPLY_BUDGET_USEC. Returns %TRUE if
+ * there are more results to apply.
+ */
+static gboolean
+spelling_engine_apply_pending (SpellingEngine *self,
+                               gint64          frame_usec)
+{
+  g_autoptr(GObject) instance = NULL;
+  gint64 begin_time;
+  gint64 elapsed;
+  guint first_result;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+
+  if (!(instance = g_weak_ref_get (&self->instance_wr)) ||
+      !self->adapter.check_enabled (instance))
+    {
+      spelling_engine_clear_pending (self);
+      return FALSE;
+    }
+
+  begin_time = g_get_monotonic_time ();
+  first_result = self->n_applied;
+
+  do
+    {
+      const PendingResult *result = &g_array_index (self->pending, PendingResult, self->n_applied);
+
+      self->n_applied++;
+
+      if (result->range.length > 0 && result->restored)
+        spelling_engine_apply_restored (self, instance,
+                                        &g_array_index (self->pending_mistakes, SpellingMistake, result->first_mistake));
+      else if (result->range.length > 0)
+        spelling_engine_apply (self, instance,
+                               &result->range, 1,
+                               &g_array_index (self->pending_mistakes, SpellingMistake, result->first_mistake),
+                               result->n_mistakes);
+
+      elapsed = g_get_monotonic_time () - begin_time;
+    }
+  while (spelling_engine_has_pending (self) && elapsed < APPLY_BUDGET_USEC);
+
+  spelling_histogram_record (&self->counters->apply_latency, elapsed);
+
+  if G_UNLIKELY (SPELLING_PROFILER_ACTIVE)
+    {
+      G_GNUC_UNUSED g_autofree char *message = g_strdup_printf ("%u results", self->n_applied - first_result);
+      SPELLING_PROFILER_MARK (elapsed * 1000, "Apply", message);
+    }
+
+  if (elapsed > frame_usec)
+    {
+      self->n_overruns++;
+      SPELLING_PROFILER_LOG ("Applying results took %"G_GINT64_FORMAT"usec, longer than a frame",
+                             elapsed);
+    }
+
+  if (spelling_engine_has_pending (self))
+    return TRUE;
+
+  spelling_engine_clear_pending (self);
+  spelling_engine_settle (self);
+
+  return FALSE;
+}
+
+static void
+spelling_engine_stop_applying (SpellingEngine *self)
+{
+  g_clear_handle_id (&self->apply_handler, g_source_remove);
+  g_clear_signal_handler (&self->frame_clock_handler, self->frame_clock);
+  g_clear_object (&self->frame_clock);
 }
 
-static gsize
-spelling_engine_add_range (SpellingEngine *self,
-                           GObject        *instance,
-                           guint           begin,
-                           guint           end,
-                           GtkBitset      *all,
-                           GtkBitset      *bitset)
+static void
+spelling_engine_frame_clock_update_cb (SpellingEngine *self,
+                                       GdkFrameClock  *frame_clock)
 {
-  gsize ret;
+  gint64 frame_usec = 0;
 
   g_assert (SPELLING_IS_ENGINE (self));
-  g_assert (self->active != NULL);
-  g_assert (SPELLING_IS_JOB (self->active));
-  g_assert (begin <= end);
-  g_assert (all != NULL);
-  g_assert (bitset != NULL);
+  g_assert (GDK_IS_FRAME_CLOCK (frame_clock));
 
-  /* Track this range in "all" as we'll need to clear the areas
-   * that have "no-spell-check" in our textregion too. We can
-   * figure that out by subtracting bitset from all.
-   */
-  gtk_bitset_add_range (all, begin, end - begin);
+  gdk_frame_clock_get_refresh_info (frame_clock,
+                                    gdk_frame_clock_get_frame_time (frame_clock),
+                                    &frame_usec, NULL);
 
-  /* Track what the adapter thinks should be in this run */
-  gtk_bitset_add_range (bitset, begin, end - begin);
-  self->adapter.intersect_spellcheck_region (instance, bitset);
+  if (frame_usec <= 0)
+    frame_usec = FRAME_USEC_DEFAULT;
 
-  /* And now subtract that from the all to cover the gaps */
-  gtk_bitset_subtract (all, bitset);
+  if (spelling_engine_apply_pending (self, frame_usec))
+    gdk_frame_clock_request_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_UPDATE);
+  else
+    spelling_engine_stop_applying (self);
+}
 
-  /* Add fragments for the sub-regions we need to check */
-  spelling_engine_add_fragments (self, instance, self->active, bitset);
+static gboolean
+spelling_engine_apply_pending_cb (gpointer data)
+{
+  SpellingEngine *self = data;
 
-  /* Track the size so we can bail after sufficent data to check */
-  ret = gtk_bitset_get_size (bitset);
+  g_assert (SPELLING_IS_ENGINE (self));
 
-  /* Reset bitset for next run */
-  gtk_bitset_remove_all (bitset);
+  if (spelling_engine_apply_pending (self, FRAME_USEC_DEFAULT))
+    return G_SOURCE_CONTINUE;
 
-  return ret;
+  self->apply_handler = 0;
+
+  return G_SOURCE_REMOVE;
 }
 
-static gboolean
-collect_ranges (gsize                   offset,
-                const CjhTextRegionRun *run,
-                gpointer                user_data)
+/* Applies waiting results from the next frames of the widget if it is
+ * shown, or otherwise from an idle callback.
+ */
+static void
+spelling_engine_queue_apply (SpellingEngine *self)
 {
-  CollectRanges *collect = user_data;
-  guint begin;
-  guint end;
+  g_autoptr(GObject) instance = NULL;
+  GdkFrameClock *frame_clock = NULL;
 
-  if (run->data != TAG_NEEDS_CHECK)
-    return FALSE;
+  g_assert (SPELLING_IS_ENGINE (self));
+
+  if (!spelling_engine_has_pending (self))
+    return;
 
-  begin = offset;
-  end = offset + run->length;
+  if ((instance = g_weak_ref_get (&self->instance_wr)) &&
+      self->adapter.get_frame_clock != NULL)
+    frame_clock = self->adapter.get_frame_clock (instance);
+
+  /* The view may have been hidden or moved to another window since */
+  if (frame_clock == self->frame_clock &&
+      (self->frame_clock_handler != 0 || self->apply_handler != 0))
+    return;
+
+  spelling_engine_stop_applying (self);
+
+  if (frame_clock != NULL)
+    {
+      self->frame_clock = g_object_ref (frame_clock);
+      self->frame_clock_handler =
+        g_signal_connect_object (frame_clock,
+                                 "update",
+                                 G_CALLBACK (spelling_engine_frame_clock_update_cb),
+                                 self,
+                                 G_CONNECT_SWAPPED);
+      gdk_frame_clock_request_phase (frame_clock, GDK_FRAME_CLOCK_PHASE_UPDATE);
+    }
+  else
+    {
+      self->apply_handler = g_idle_add_full (G_PRIORITY_LOW,
+                                             spelling_engine_apply_pending_cb,
+                                             self,
+                                             NULL);
+    }
+}
+
+static void
+spelling_engine_job_progress (SpellingJob            *job,
+                              const SpellingBoundary *fragments,
+                              guint                   n_fragments,
+                              const SpellingMistake  *mistakes,
+                              guint                   n_mistakes,
+                              gpointer                user_data)
+{
+  SpellingEngine *self = user_data;
+  g_autoptr(GObject) instance = NULL;
+
+  g_assert (SPELLING_IS_JOB (job));
+  g_assert (SPELLING_IS_ENGINE (self));
 
-  spelling_engine_extend_range (collect->self, &begin, &end);
+  /* Ignore stragglers from a job we already gave up on */
+  if (!g_ptr_array_find (self->active, job, NULL))
+    return;
 
-  collect->size += spelling_engine_add_range (collect->self,
-                                              collect->instance,
-                                              begin, end,
-                                              collect->all,
-                                              collect->bitset);
+  if (!(instance = g_weak_ref_get (&self->instance_wr)) ||
+      !self->adapter.check_enabled (instance))
+    return;
 
-  return collect->size >= WATERMARK_PER_JOB;
+  spelling_engine_push_pending (self, fragments, n_fragments, mistakes, n_mistakes);
+  spelling_engine_queue_apply (self);
 }
 
 static void
@@ -253,7 +1281,12 @@ spelling_engine_job_finished (GObject      *object,
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (SPELLING_IS_ENGINE (self));
 
-  g_clear_object (&self->active);
+  /* Jobs dropped by spelling_engine_invalidate_all() are stale */
+  if (!g_ptr_array_remove_fast (self->active, job))
+    return;
+
+  spelling_engine_update_counters (self);
+  spelling_engine_update_rate (self, job);
 
   if (!(instance = g_weak_ref_get (&self->instance_wr)))
     return;
@@ -262,53 +1295,32 @@ spelling_engine_job_finished (GObject      *object,
     return;
 
   spelling_job_run_finish (job, result, &fragments, &n_fragments, &mistakes, &n_mistakes);
+  spelling_engine_push_pending (self, fragments, n_fragments, mistakes, n_mistakes);
+  spelling_engine_queue_apply (self);
 
-  for (guint f = 0; f < n_fragments; f++)
-    {
-      self->adapter.clear_tag (instance, fragments[f].offset, fragments[f].length);
-      _cjh_text_region_replace (self->region,
-                                fragments[f].offset, fragments[f].length,
-                                TAG_CHECKED);
-    }
-
-  for (guint m = 0; m < n_mistakes; m++)
-    self->adapter.apply_tag (instance, mistakes[m].offset, mistakes[m].length);
-
-  /* Check immediately if there is more */
-  if (spelling_engine_has_unchecked_regions (self))
-    spelling_engine_queue_update (self, 0);
+  spelling_engine_settle (self);
 }
 
 static void
-spelling_engine_clear_runs (SpellingEngine *self,
-                            GtkBitset      *bitset)
+spelling_engine_replace_runs (SpellingEngine *self,
+                              GtkBitset      *bitset,
+                              gpointer        tag)
 {
-  GtkBitsetIter iter;
-  guint pos;
+  g_autoptr(GArray) ranges = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
 
   g_assert (SPELLING_IS_ENGINE (self));
   g_assert (bitset != NULL);
 
-  if (gtk_bitset_iter_init_first (&iter, bitset, &pos))
-    {
-      guint begin = pos;
-      guint end = pos;
-
-      while (gtk_bitset_iter_next (&iter, &pos))
-        {
-          if (pos == end + 1)
-            {
-              end++;
-              continue;
-            }
+  spelling_engine_get_ranges (bitset, ranges);
 
-          _cjh_text_region_replace (self->region, begin, end - begin + 1, TAG_CHECKED);
+  for (guint i = 0; i < ranges->len; i++)
+    {
+      const SpellingBoundary *range = &g_array_index (ranges, SpellingBoundary, i);
 
-          begin = pos;
-          end = pos;
-        }
+      _cjh_text_region_replace (self->region, range->offset, range->length, tag);
 
-      _cjh_text_region_replace (self->region, begin, end - begin + 1, TAG_CHECKED);
+      if (tag == TAG_IN_FLIGHT)
+        _cjh_text_region_replace (self->handed_out, range->offset, range->length, HANDED_OUT);
     }
 }
 
@@ -318,16 +1330,22 @@ spelling_engine_tick (gpointer data)
   SpellingEngine *self = data;
   g_autoptr(GtkBitset) bitset = NULL;
   g_autoptr(GtkBitset) all = NULL;
+  g_autoptr(GtkBitset) collected = NULL;
   g_autoptr(GObject) instance = NULL;
   const CjhTextRegionRun *run;
   SpellingDictionary *dictionary;
   PangoLanguage *language;
+  g_autoptr(SpellingJob) job = NULL;
   CollectRanges collect;
   gsize real_offset;
+  guint visible_begin;
+  guint visible_end;
   guint cursor;
 
+  SPELLING_PROFILER_BEGIN_MARK;
+
   g_assert (SPELLING_IS_ENGINE (self));
-  g_assert (self->active == NULL);
+  g_assert (self->active->len < MAX_ACTIVE_JOBS);
 
   /* Be safe against weak-pointer lost or bad dictionary installations */
   if (!(instance = g_weak_ref_get (&self->instance_wr)) ||
@@ -338,10 +1356,14 @@ spelling_engine_tick (gpointer data)
       return G_SOURCE_REMOVE;
     }
 
-  self->active = spelling_job_new (dictionary, language);
+  job = spelling_job_new (dictionary, language);
+  spelling_job_set_owner (job, self);
+  spelling_job_set_counters (job, self->counters);
 
   bitset = gtk_bitset_new_empty ();
   all = gtk_bitset_new_empty ();
+  collected = gtk_bitset_new_empty ();
+  collect.size = 0;
 
   /* Always check the cursor location so that spellcheck feels snappy */
   cursor = self->adapter.get_cursor (instance);
@@ -353,28 +1375,68 @@ spelling_engine_tick (gpointer data)
       guint end = cursor;
 
       if (spelling_engine_extend_range (self, &begin, &end))
-        spelling_engine_add_range (self, instance, begin, end, all, bitset);
+        collect.size = spelling_engine_add_range (self, instance, job, begin, end, all, bitset, collected);
     }
 
-  collect.self = self;
+  collect.job = job;
   collect.bitset = bitset;
   collect.all = all;
-  collect.size = 0;
+  collect.collected = collected;
   collect.instance = instance;
 
-  _cjh_text_region_foreach (self->region, collect_ranges, &collect);
+  /* Then what is visible, followed by a page below and above it so
+   * that scrolling a little does not show unchecked text, and finally
+   * everything else from the start of the buffer.
+   */
+  if (self->adapter.get_visible_range != NULL &&
+      self->adapter.get_visible_range (instance, &visible_begin, &visible_end) &&
+      visible_begin < visible_end)
+    {
+      guint page = visible_end - visible_begin;
+
+      spelling_engine_collect_range (self, &collect, visible_begin, visible_end);
+      spelling_engine_collect_range (self, &collect, visible_end, (gsize)visible_end + page);
+      spelling_engine_collect_range (self, &collect, visible_begin - MIN (visible_begin, page), visible_begin);
+    }
+
+  spelling_engine_collect_range (self, &collect, 0, G_MAXSIZE);
 
   /* We need to clear everything from our textregion that is still
    * in @all as those are gaps in what should be checked, such as
-   * no-spell-check regions.
+   * no-spell-check regions. What remains was handed to the job and
+   * must not be collected by the next one.
    */
-  spelling_engine_clear_runs (self, all);
+  spelling_engine_replace_runs (self, all, TAG_CHECKED);
+  gtk_bitset_subtract (collected, all);
+  spelling_engine_replace_runs (self, collected, TAG_IN_FLIGHT);
+
+  SPELLING_PROFILER_END_MARK ("Collect", NULL);
+
+  g_clear_handle_id (&self->queued_update_handler, g_source_remove);
+
+  if (collect.size == 0)
+    {
+      spelling_engine_update_counters (self);
+      spelling_engine_notify_finished (self);
+      return G_SOURCE_REMOVE;
+    }
 
-  spelling_job_run (self->active,
+  /* Apply results of the first fragments while the rest is checked */
+  spelling_job_set_progress_func (job,
+                                  spelling_engine_job_progress,
+                                  g_object_ref (self),
+                                  g_object_unref);
+
+  g_ptr_array_add (self->active, g_object_ref (job));
+  spelling_engine_update_counters (self);
+
+  spelling_job_run (job,
                     spelling_engine_job_finished,
                     g_object_ref (self));
 
-  g_clear_handle_id (&self->queued_update_handler, g_source_remove);
+  /* Keep the pipeline full while there is more to check */
+  if (spelling_engine_has_unchecked_regions (self))
+    spelling_engine_queue_update (self, 0);
 
   return G_SOURCE_REMOVE;
 }
@@ -385,7 +1447,7 @@ spelling_engine_queue_update (SpellingEngine *self,
 {
   g_assert (SPELLING_IS_ENGINE (self));
 
-  if (self->active != NULL)
+  if (self->active->len >= MAX_ACTIVE_JOBS)
     return;
 
   if (!spelling_engine_check_enabled (self))
@@ -429,8 +1491,12 @@ spelling_engine_dispose (GObject *object)
 {
   SpellingEngine *self = (SpellingEngine *)object;
 
-  g_clear_object (&self->active);
+  g_ptr_array_set_size (self->active, 0);
   g_clear_handle_id (&self->queued_update_handler, g_source_remove);
+  g_clear_handle_id (&self->cache_save_handler, g_source_remove);
+  spelling_engine_stop_applying (self);
+  spelling_engine_clear_pending (self);
+  g_cancellable_cancel (self->restore_cancellable);
   g_weak_ref_set (&self->instance_wr, NULL);
 
   G_OBJECT_CLASS (spelling_engine_parent_class)->dispose (object);
@@ -441,8 +1507,23 @@ spelling_engine_finalize (GObject *object)
 {
   SpellingEngine *self = (SpellingEngine *)object;
 
+  spelling_scheduler_forget (spelling_scheduler_get_default (), self);
+
   g_weak_ref_clear (&self->instance_wr);
   g_clear_pointer (&self->region, _cjh_text_region_free);
+  g_clear_pointer (&self->mistakes, _cjh_text_region_free);
+  g_clear_pointer (&self->handed_out, _cjh_text_region_free);
+  g_clear_pointer (&self->index, g_hash_table_unref);
+  g_clear_pointer (&self->index_edits, g_array_unref);
+  g_clear_pointer (&self->accepted, g_array_unref);
+  g_clear_pointer (&self->active, g_ptr_array_unref);
+  g_clear_pointer (&self->pending, g_array_unref);
+  g_clear_pointer (&self->pending_mistakes, g_array_unref);
+  g_clear_pointer (&self->counters, spelling_counters_unref);
+  g_clear_pointer (&self->cache_path, g_free);
+  g_clear_object (&self->restore_cancellable);
+
+  spelling_engine_update_counters (self);
 
   G_OBJECT_CLASS (spelling_engine_parent_class)->finalize (object);
 }
@@ -461,8 +1542,24 @@ spelling_engine_init (SpellingEngine *self)
 {
   g_weak_ref_init (&self->instance_wr, NULL);
 
+  self->job_size = JOB_SIZE_INITIAL;
+  self->active = g_ptr_array_new_with_free_func (g_object_unref);
+  self->pending = g_array_new (FALSE, FALSE, sizeof (PendingResult));
+  self->pending_mistakes = g_array_new (FALSE, FALSE, sizeof (SpellingMistake));
+  self->counters = spelling_counters_new ();
+  self->index = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, index_entry_free);
+  self->index_edits = g_array_new (FALSE, FALSE, sizeof (IndexEdit));
+  self->accepted = g_array_new (FALSE, FALSE, sizeof (guint64));
+
   self->region = _cjh_text_region_new (spelling_engine_join_range,
                                        spelling_engine_split_range);
+  _cjh_text_region_set_tracked (self->region, TAG_NEEDS_CHECK);
+
+  self->mistakes = _cjh_text_region_new (spelling_engine_join_range, NULL);
+  _cjh_text_region_set_tracked (self->mistakes, MISTAKE_TAGGED);
+
+  self->handed_out = _cjh_text_region_new (spelling_engine_join_range, NULL);
+  _cjh_text_region_set_tracked (self->handed_out, HANDED_OUT);
 }
 
 SpellingEngine *
@@ -491,10 +1588,16 @@ spelling_engine_before_insert_text (SpellingEngine *self,
   if (length == 0)
     return;
 
-  if (self->active)
-    spelling_job_notify_insert (self->active, position, length);
+  for (guint i = 0; i < self->active->len; i++)
+    spelling_job_notify_insert (g_ptr_array_index (self->active, i), position, length);
+  spelling_engine_edit_pending (self, position, position, length);
+  spelling_engine_index_edit (self, position, 0, length);
+  g_cancellable_cancel (self->restore_cancellable);
+  self->cache_dirty = TRUE;
 
   _cjh_text_region_insert (self->region, position, length, TAG_NEEDS_CHECK);
+  _cjh_text_region_insert (self->mistakes, position, length, MISTAKE_NONE);
+  _cjh_text_region_insert (self->handed_out, position, length, HANDED_OUT_NONE);
 }
 
 void
@@ -520,10 +1623,16 @@ spelling_engine_before_delete_range (SpellingEngine *self,
   if (length == 0)
     return;
 
-  if (self->active)
-    spelling_job_notify_delete (self->active, position, length);
+  for (guint i = 0; i < self->active->len; i++)
+    spelling_job_notify_delete (g_ptr_array_index (self->active, i), position, length);
+  spelling_engine_edit_pending (self, position, position + length, -(int)length);
+  spelling_engine_index_edit (self, position, length, 0);
+  g_cancellable_cancel (self->restore_cancellable);
+  self->cache_dirty = TRUE;
 
   _cjh_text_region_remove (self->region, position, length);
+  _cjh_text_region_remove (self->mistakes, position, length);
+  _cjh_text_region_remove (self->handed_out, position, length);
 }
 
 void
@@ -549,7 +1658,7 @@ spelling_engine_iteration (SpellingEngine *self)
 {
   g_return_if_fail (SPELLING_IS_ENGINE (self));
 
-  if (self->active == NULL)
+  if (self->active->len < MAX_ACTIVE_JOBS)
     spelling_engine_tick (self);
 }
 
@@ -561,19 +1670,37 @@ spelling_engine_invalidate_all (SpellingEngine *self)
 
   g_return_if_fail (SPELLING_IS_ENGINE (self));
 
-  g_clear_object (&self->active);
+  g_ptr_array_set_size (self->active, 0);
   g_clear_handle_id (&self->queued_update_handler, g_source_remove);
+  spelling_engine_stop_applying (self);
+  spelling_engine_clear_pending (self);
+  g_cancellable_cancel (self->restore_cancellable);
+
+  /* Jobs that did not start yet would only produce stale results */
+  spelling_scheduler_cancel (spelling_scheduler_get_default (), self);
 
   length = _cjh_text_region_get_length (self->region);
 
   if (length > 0)
     {
       _cjh_text_region_replace (self->region, 0, length, TAG_NEEDS_CHECK);
-
-      if ((instance = g_weak_ref_get (&self->instance_wr)))
-        self->adapter.clear_tag (instance, 0, length);
+      _cjh_text_region_replace (self->handed_out, 0, length, HANDED_OUT_NONE);
+
+      /* Existing tags are kept while checking again so that they only
+       * change where the results differ. If nothing is going to be
+       * checked, such as after disabling, they must go now.
+       */
+      if ((instance = g_weak_ref_get (&self->instance_wr)) &&
+          !self->adapter.check_enabled (instance))
+        {
+          self->adapter.clear_tag (instance, 0, length);
+          _cjh_text_region_replace (self->mistakes, 0, length, MISTAKE_NONE);
+          spelling_engine_index_clear (self);
+          self->cache_dirty = TRUE;
+        }
     }
 
+  spelling_engine_update_counters (self);
   spelling_engine_queue_update (self, 0);
 }
 
@@ -586,13 +1713,288 @@ spelling_engine_invalidate (SpellingEngine *self,
 
   g_assert (SPELLING_IS_ENGINE (self));
 
-  if (self->active)
-    spelling_job_invalidate (self->active, position, length);
+  for (guint i = 0; i < self->active->len; i++)
+    spelling_job_invalidate (g_ptr_array_index (self->active, i), position, length);
+  spelling_engine_edit_pending (self, position, position + length, 0);
 
   _cjh_text_region_replace (self->region, position, length, TAG_NEEDS_CHECK);
 
   if ((instance = g_weak_ref_get (&self->instance_wr)))
-    self->adapter.clear_tag (instance, position, length);
+    {
+      self->adapter.clear_tag (instance, position, length);
+      _cjh_text_region_replace (self->mistakes, position, length, MISTAKE_NONE);
+      self->cache_dirty = TRUE;
+    }
 
   spelling_engine_queue_update (self, 0);
 }
+
+/* Returns the smoothed number of characters checked per second, or 0
+ * if no job was measured yet.
+ */
+double
+spelling_engine_get_rate (SpellingEngine *self)
+{
+  g_return_val_if_fail (SPELLING_IS_ENGINE (self), 0);
+
+  return self->rate * G_USEC_PER_SEC;
+}
+
+/* Returns the number of characters the next job will be sized to */
+guint
+spelling_engine_get_job_size (SpellingEngine *self)
+{
+  g_return_val_if_fail (SPELLING_IS_ENGINE (self), 0);
+
+  return self->job_size;
+}
+
+/* Returns %TRUE while there is text left to check or results that were
+ * not applied yet.
+ */
+gboolean
+spelling_engine_get_busy (SpellingEngine *self)
+{
+  g_return_val_if_fail (SPELLING_IS_ENGINE (self), FALSE);
+
+  return self->active->len > 0 ||
+         spelling_engine_has_pending (self) ||
+         spelling_engine_has_unchecked_regions (self);
+}
+
+/* Enables saving mistakes to the cache in $XDG_CACHE_HOME once the text
+ * has been checked, for spelling_engine_restore() to find them again.
+ */
+void
+spelling_engine_set_use_cache (SpellingEngine *self,
+                               gboolean        use_cache)
+{
+  g_return_if_fail (SPELLING_IS_ENGINE (self));
+
+  self->use_cache = !!use_cache;
+
+  if (self->use_cache)
+    {
+      self->cache_dirty = TRUE;
+      spelling_engine_restore (self);
+    }
+}
+
+static void
+spelling_engine_restored_cb (GObject      *object,
+                             GAsyncResult *result,
+                             gpointer      user_data)
+{
+  g_autoptr(SpellingEngine) self = user_data;
+  g_autoptr(GObject) instance = NULL;
+  g_autofree SpellingMistake *mistakes = NULL;
+  g_autofree char *path = NULL;
+  guint n_mistakes = 0;
+  guint length;
+
+  g_assert (SPELLING_IS_ENGINE (self));
+
+  /* Cancelled once the text changed, which makes the cache stale */
+  if (!(mistakes = spelling_cache_load_finish (result, &path, &n_mistakes, NULL)))
+    return;
+
+  if (!(instance = g_weak_ref_get (&self->instance_wr)) ||
+      !self->adapter.check_enabled (instance))
+    return;
+
+  SPELLING_PROFILER_LOG ("Restored %u mistakes from %s", n_mistakes, path);
+
+  g_clear_object (&self->restore_cancellable);
+  g_free (self->cache_path);
+  self->cache_path = g_steal_pointer (&path);
+
+  /* The cache matches the text, no need to write it again unless the
+   * results differ from it. If something was checked already, that
+   * may have changed the tags.
+   */
+  length = _cjh_text_region_get_length (self->region);
+  if (_cjh_text_region_get_tracked_length (self->region) == length)
+    self->cache_dirty = FALSE;
+
+  spelling_engine_push_restored (self, mistakes, n_mistakes);
+  spelling_engine_queue_apply (self);
+}
+
+/* Loads the mistakes cached for the current text on a thread and tags
+ * them along with the results of jobs. They are verified as the text is
+ * checked again, which only changes the tags where the results differ.
+ */
+void
+spelling_engine_restore (SpellingEngine *self)
+{
+  g_autoptr(GObject) instance = NULL;
+  SpellingDictionary *dictionary;
+  guint length;
+
+  g_return_if_fail (SPELLING_IS_ENGINE (self));
+
+  g_cancellable_cancel (self->restore_cancellable);
+  g_clear_object (&self->restore_cancellable);
+
+  if (!self->use_cache ||
+      !(instance = g_weak_ref_get (&self->instance_wr)) ||
+      !self->adapter.check_enabled (instance) ||
+      !(dictionary = self->adapter.get_dictionary (instance)))
+    return;
+
+  if (!(length = _cjh_text_region_get_length (self->region)))
+    return;
+
+  /* Only copying the text needs the main thread */
+  self->restore_cancellable = g_cancellable_new ();
+  spelling_cache_load_async (spelling_dictionary_get_code (dictionary),
+                             spelling_engine_copy_text (self, instance, 0, length),
+                             length,
+                             self->restore_cancellable,
+                             spelling_engine_restored_cb,
+                             g_object_ref (self));
+}
+
+/* Writes the mistakes to the cache right away if they changed, such as
+ * before the text is closed.
+ */
+void
+spelling_engine_flush_cache (SpellingEngine *self)
+{
+  g_return_if_fail (SPELLING_IS_ENGINE (self));
+
+  spelling_engine_write_cache (self);
+}
+
+/* Clears the tags of @word wherever it is correct now, such as after it
+ * was added to the dictionary, along with its capitalized forms. Only
+ * the positions the index has for these words are visited. Results
+ * which are on their way were looked up before and are filtered instead
+ * of checking their text again.
+ */
+void
+spelling_engine_recheck_word (SpellingEngine *self,
+                              const char     *word)
+{
+  g_autoptr(GObject) instance = NULL;
+  g_autofree char *upper = NULL;
+  g_autofree char *title = NULL;
+  SpellingDictionary *dictionary;
+  const char *forms[3];
+  guint64 hashes[3];
+  char first[6];
+
+  g_return_if_fail (SPELLING_IS_ENGINE (self));
+  g_return_if_fail (word != NULL);
+
+  if (*word == 0 ||
+      !(instance = g_weak_ref_get (&self->instance_wr)) ||
+      !self->adapter.check_enabled (instance) ||
+      !(dictionary = self->adapter.get_dictionary (instance)))
+    return;
+
+  first[g_unichar_to_utf8 (g_unichar_totitle (g_utf8_get_char (word)), first)] = 0;
+  title = g_strconcat (first, g_utf8_next_char (word), NULL);
+  upper = g_utf8_strup (word, -1);
+
+  forms[0] = word;
+  forms[1] = title;
+  forms[2] = upper;
+
+  for (guint f = 0; f < G_N_ELEMENTS (forms); f++)
+    {
+      IndexEntry *entry;
+      gboolean seen = FALSE;
+      guint n = 0;
+
+      hashes[f] = _spelling_word_hash (forms[f], strlen (forms[f]));
+
+      for (guint g = 0; g < f; g++)
+        seen |= hashes[g] == hashes[f];
+
+      if (seen || !spelling_dictionary_contains_word (dictionary, forms[f], -1))
+        continue;
+
+      if (self->active->len > 0 || spelling_engine_has_pending (self))
+        g_array_append_val (self->accepted, hashes[f]);
+
+      if (!(entry = g_hash_table_lookup (self->index, &hashes[f])))
+        continue;
+
+      spelling_engine_index_catch_up (self, entry);
+
+      for (guint i = 0; i < entry->offsets->len; i++)
+        {
+          guint offset = g_array_index (entry->offsets, guint, i);
+          g_autofree char *text = NULL;
+
+          if (!spelling_engine_is_tagged (self, offset, entry->length))
+            continue;
+
+          /* The hash may belong to another word */
+          text = spelling_engine_copy_text (self, instance, offset, entry->length);
+
+          if (!spelling_dictionary_contains_word (dictionary, text, -1))
+            {
+              g_array_index (entry->offsets, guint, n++) = offset;
+              continue;
+            }
+
+          self->adapter.clear_tag (instance, offset, entry->length);
+          _cjh_text_region_replace (self->mistakes, offset, entry->length, MISTAKE_NONE);
+          self->cache_dirty = TRUE;
+        }
+
+      g_array_set_size (entry->offsets, n);
+
+      if (n == 0)
+        g_hash_table_remove (self->index, &hashes[f]);
+    }
+}
+
+/* Returns how many times applying results took longer than a frame */
+guint
+spelling_engine_get_n_overruns (SpellingEngine *self)
+{
+  g_return_val_if_fail (SPELLING_IS_ENGINE (self), 0);
+
+  return self->n_overruns;
+}
+
+/* Returns a snapshot of what checking has cost so far */
+SpellingStats *
+spelling_engine_dup_stats (SpellingEngine *self)
+{
+  guint queue_depth;
+
+  g_return_val_if_fail (SPELLING_IS_ENGINE (self), NULL);
+
+  queue_depth = self->active->len + self->pending->len - self->n_applied;
+
+  return _spelling_stats_new (self->counters, queue_depth);
+}
+
+/* Called by the adapter when a different part of the buffer is shown so
+ * that what became visible is checked first.
+ */
+void
+spelling_engine_visible_range_changed (SpellingEngine *self)
+{
+  g_return_if_fail (SPELLING_IS_ENGINE (self));
+
+  if (spelling_engine_has_unchecked_regions (self))
+    spelling_engine_queue_update (self, 0);
+}
+
+/* Sets how urgently the jobs of @self are run compared to those of other
+ * engines in the process, such as whether the text is focused, visible
+ * or in a background tab.
+ */
+void
+spelling_engine_set_priority (SpellingEngine            *self,
+                              SpellingSchedulerPriority  priority)
+{
+  g_return_if_fail (SPELLING_IS_ENGINE (self));
+
+  spelling_scheduler_set_priority (spelling_scheduler_get_default (), self, priority);
+}
@@ -23,19 +23,29 @@
 #include <gio/gio.h>
 
 #include "spelling-dictionary-internal.h"
+#include "spelling-stats-private.h"
 
 G_BEGIN_DECLS
 
 typedef struct _SpellingMistake
 {
-  guint offset;
-  guint length;
+  guint   offset;
+  guint   length;
+  /* _spelling_word_hash() of the word, or 0 if it is not known */
+  guint64 hash;
 } SpellingMistake;
 
 #define SPELLING_TYPE_JOB (spelling_job_get_type())
 
 G_DECLARE_FINAL_TYPE (SpellingJob, spelling_job, SPELLING, JOB, GObject)
 
+typedef void (*SpellingJobProgressFunc) (SpellingJob            *job,
+                                         const SpellingBoundary *fragments,
+                                         guint                   n_fragments,
+                                         const SpellingMistake  *mistakes,
+                                         guint                   n_mistakes,
+                                         gpointer                user_data);
+
 SpellingJob     *spelling_job_new           (SpellingDictionary   *dictionary,
                                              PangoLanguage        *language);
 void             spelling_job_discard       (SpellingJob          *self);
@@ -48,6 +58,15 @@ void             spelling_job_run_finish    (SpellingJob          *self,
                                              guint                *n_fragments,
                                              SpellingMistake     **mistakes,
                                              guint                *n_mistakes);
+void             spelling_job_set_progress_func
+                                            (SpellingJob             *self,
+                                             SpellingJobProgressFunc  func,
+                                             gpointer                 user_data,
+                                             GDestroyNotify           user_data_destroy);
+void             spelling_job_set_owner     (SpellingJob          *self,
+                                             gconstpointer         owner);
+void             spelling_job_set_counters  (SpellingJob          *self,
+                                             SpellingCounters     *counters);
 void             spelling_job_run_sync      (SpellingJob          *self,
                                              SpellingBoundary    **fragments,
                                              guint                *n_fragments,
@@ -66,5 +85,7 @@ void             spelling_job_notify_insert (SpellingJob          *self,
 void             spelling_job_invalidate    (SpellingJob          *self,
                                              guint                 position,
                                              guint                 length);
+guint            spelling_job_get_length    (SpellingJob          *self);
+gint64           spelling_job_get_elapsed   (SpellingJob          *self);
 
 G_END_DECLS
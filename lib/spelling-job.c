@@ -20,10 +20,15 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <pango/pango.h>
 
+#include "spelling-arena-private.h"
 #include "spelling-dictionary-internal.h"
 #include "spelling-job-private.h"
+#include "spelling-scheduler-private.h"
+#include "spelling-stats-private.h"
 #include "spelling-trace.h"
 
 #define GDK_ARRAY_NAME spelling_boundaries
@@ -34,27 +39,106 @@
 #define GDK_ARRAY_NO_MEMSET
 #include "gdkarrayimpl.c"
 
-typedef struct _SpellingFragment
+#define MAX_FRAGMENT_EDITS 32
+#define CHECK_SLICE_WORDS 256
+#define DRAIN_SLICE_FRAGMENTS 8
+
+typedef enum _SpellingEditKind
 {
-  GBytes  *bytes;
-  guint    position;
-  guint    length;
-  gboolean must_discard;
-} SpellingFragment;
+  SPELLING_EDIT_INSERT,
+  SPELLING_EDIT_DELETE,
+  SPELLING_EDIT_INVALIDATE,
+} SpellingEditKind;
+
+/* An edit which touched a fragment while it was in flight. The position is
+ * relative to the edit frame of the fragment (see SpellingFragment.origin)
+ * at the time the edit was made and may be negative when a delete started
+ * before the fragment.
+ */
+typedef struct _SpellingEdit
+{
+  int              position;
+  guint            length;
+  SpellingEditKind kind;
+} SpellingEdit;
 
-typedef struct _SpellingMistakes
+typedef struct _SpellingFragment
 {
-  const SpellingFragment *fragment;
-  GArray                 *boundaries;
-} SpellingMistakes;
+  GBytes    *bytes;
+  guint      position;
+  guint      length;
+  guint      original_length;
+
+  /* Offset of the edit frame from @position. It only changes when a
+   * delete removes the start of the fragment, as @position moves to
+   * the delete position while the remaining text keeps its place in
+   * the edit frame.
+   */
+  int        origin;
+
+  /* Edits which touched the fragment, in order, or %NULL */
+  GArray    *edits;
+
+  /* Words found by the worker which segmented the fragment, allocated
+   * from the job arena, and the range of the job mistakes which belong
+   * to the fragment. See spelling_job_check_words().
+   */
+  const SpellingBoundary *words;
+  guint      n_words;
+  guint      first_mistake;
+  guint      n_mistakes;
+
+  gboolean   must_discard;
+} SpellingFragment;
 
 struct _SpellingJob
 {
   GObject             parent_instance;
   SpellingDictionary *dictionary;
   PangoLanguage      *language;
-  char               *extra_word_chars;
+  SpellingCharSet    *extra_word_chars;
   GArray             *fragments;
+
+  /* Work is queued with the scheduler on behalf of the owner */
+  gconstpointer       owner;
+
+  /* Shared with the owner, see spelling_job_set_counters() */
+  SpellingCounters   *counters;
+
+  /* Number of characters added and the time it took to check them */
+  guint               length;
+  gint64              elapsed;
+
+  /* Scratch memory and per-fragment words live in the arena until the
+   * job is disposed. Mistakes of every fragment are kept in a single
+   * vector, large enough for every word to be misspelled so that it is
+   * never moved while the main thread reads from it, which is handed to
+   * the caller by spelling_job_run_finish().
+   */
+  SpellingArena       arena;
+  SpellingMistake    *mistakes;
+
+  /* Progressive delivery, see spelling_job_set_progress_func(). The
+   * worker publishes fragments in order by advancing @n_ready, which
+   * the main thread drains from @n_drained.
+   */
+  GMainContext          *main_context;
+  SpellingJobProgressFunc progress_func;
+  gpointer               progress_data;
+  GDestroyNotify         progress_data_destroy;
+  guint                  n_ready;
+  guint                  n_drained;
+  int                    drain_queued;
+
+  /* Fragment indexes sorted by position along with a Fenwick tree of
+   * position deltas, built lazily when edits are applied while the job
+   * is in flight. See spelling_job_index_build().
+   */
+  guint              *index;
+  int                *index_delta;
+  int                *index_tree;
+  guint               index_max_length;
+
   guint               frozen : 1;
 };
 
@@ -62,7 +146,6 @@ enum {
   PROP_0,
   PROP_DICTIONARY,
   PROP_LANGUAGE,
-  PROP_EXTRA_WORD_CHARS,
   N_PROPS
 };
 
@@ -76,6 +159,21 @@ clear_fragment (gpointer data)
   SpellingFragment *fragment = data;
 
   g_clear_pointer (&fragment->bytes, g_bytes_unref);
+  g_clear_pointer (&fragment->edits, g_array_unref);
+}
+
+static void spelling_job_index_clear (SpellingJob *self);
+static void spelling_job_index_flush (SpellingJob *self);
+
+static void
+spelling_job_constructed (GObject *object)
+{
+  SpellingJob *self = (SpellingJob *)object;
+
+  G_OBJECT_CLASS (spelling_job_parent_class)->constructed (object);
+
+  if (self->dictionary != NULL)
+    self->extra_word_chars = spelling_char_set_ref (_spelling_dictionary_get_extra_word_char_set (self->dictionary));
 }
 
 static void
@@ -84,8 +182,14 @@ spelling_job_dispose (GObject *object)
   SpellingJob *self = (SpellingJob *)object;
 
   g_clear_object (&self->dictionary);
+  spelling_job_index_clear (self);
   g_clear_pointer (&self->fragments, g_array_unref);
-  g_clear_pointer (&self->extra_word_chars, g_free);
+  spelling_job_set_progress_func (self, NULL, NULL, NULL);
+  g_clear_pointer (&self->main_context, g_main_context_unref);
+  g_clear_pointer (&self->mistakes, g_free);
+  g_clear_pointer (&self->extra_word_chars, spelling_char_set_unref);
+  g_clear_pointer (&self->counters, spelling_counters_unref);
+  spelling_arena_clear (&self->arena);
 
   self->language = NULL;
 
@@ -106,10 +210,6 @@ spelling_job_get_property (GObject    *object,
       g_value_set_object (value, self->dictionary);
       break;
 
-    case PROP_EXTRA_WORD_CHARS:
-      g_value_set_string (value, self->extra_word_chars);
-      break;
-
     case PROP_LANGUAGE:
       g_value_set_pointer (value, self->language);
       break;
@@ -133,10 +233,6 @@ spelling_job_set_property (GObject      *object,
       self->dictionary = g_value_dup_object (value);
       break;
 
-    case PROP_EXTRA_WORD_CHARS:
-      self->extra_word_chars = g_value_dup_string (value);
-      break;
-
     case PROP_LANGUAGE:
       self->language = g_value_get_pointer (value);
       break;
@@ -151,6 +247,7 @@ spelling_job_class_init (SpellingJobClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
+  object_class->constructed = spelling_job_constructed;
   object_class->dispose = spelling_job_dispose;
   object_class->get_property = spelling_job_get_property;
   object_class->set_property = spelling_job_set_property;
@@ -162,13 +259,6 @@ spelling_job_class_init (SpellingJobClass *klass)
                           G_PARAM_CONSTRUCT_ONLY |
                           G_PARAM_STATIC_STRINGS));
 
-  properties[PROP_EXTRA_WORD_CHARS] =
-    g_param_spec_string ("extra-word-chars", NULL, NULL,
-                         NULL,
-                         (G_PARAM_READWRITE |
-                          G_PARAM_CONSTRUCT_ONLY |
-                          G_PARAM_STATIC_STRINGS));
-
   properties[PROP_LANGUAGE] =
     g_param_spec_pointer ("language", NULL, NULL,
                           (G_PARAM_READWRITE |
@@ -183,48 +273,29 @@ spelling_job_init (SpellingJob *self)
 {
   self->fragments = g_array_new (FALSE, FALSE, sizeof (SpellingFragment));
   g_array_set_clear_func (self->fragments, clear_fragment);
+
+  spelling_arena_init (&self->arena, 4096 * 4);
 }
 
 SpellingJob *
 spelling_job_new (SpellingDictionary *dictionary,
                   PangoLanguage      *language)
 {
-  const char *extra_word_chars;
-
   g_return_val_if_fail (SPELLING_IS_DICTIONARY (dictionary), NULL);
   g_return_val_if_fail (language != NULL, NULL);
 
-  extra_word_chars = spelling_dictionary_get_extra_word_chars (dictionary);
-
   return g_object_new (SPELLING_TYPE_JOB,
                        "dictionary", dictionary,
-                       "extra-word-chars", extra_word_chars,
                        "language", language,
                        NULL);
 }
 
-static inline gboolean
-is_extra_word_char (const char *extra_word_chars,
-                    gunichar    ch)
-{
-  if (extra_word_chars == NULL)
-    return FALSE;
-
-  for (const char *c = extra_word_chars; *c; c = g_utf8_next_char (c))
-    {
-      if (ch == g_utf8_get_char (c))
-        return TRUE;
-    }
-
-  return FALSE;
-}
-
 static gboolean
-find_word_start (const char         **textptr,
-                 gsize               *iptr,
-                 const PangoLogAttr  *attrs,
-                 gsize                attrslen,
-                 const char          *extra_word_chars)
+find_word_start (const char            **textptr,
+                 gsize                  *iptr,
+                 const PangoLogAttr     *attrs,
+                 gsize                   attrslen,
+                 const SpellingCharSet  *extra_word_chars)
 {
   while (*iptr < attrslen)
     {
@@ -235,7 +306,7 @@ find_word_start (const char         **textptr,
         {
           gunichar ch = g_utf8_get_char (*textptr);
 
-          if (is_extra_word_char (extra_word_chars, ch))
+          if (spelling_char_set_contains (extra_word_chars, ch))
             return TRUE;
         }
 
@@ -247,11 +318,11 @@ find_word_start (const char         **textptr,
 }
 
 static gboolean
-find_word_end (const char         **textptr,
-               gsize               *iptr,
-               const PangoLogAttr  *attrs,
-               gsize                attrslen,
-               const char          *extra_word_chars)
+find_word_end (const char            **textptr,
+               gsize                  *iptr,
+               const PangoLogAttr     *attrs,
+               gsize                   attrslen,
+               const SpellingCharSet  *extra_word_chars)
 {
   while (*iptr < attrslen)
     {
@@ -264,7 +335,7 @@ find_word_end (const char         **textptr,
            */
           while (*iptr < attrslen &&
                  !attrs[*iptr].is_white &&
-                 is_extra_word_char (extra_word_chars, g_utf8_get_char (*textptr)))
+                 spelling_char_set_contains (extra_word_chars, g_utf8_get_char (*textptr)))
             {
               skipped = TRUE;
               *textptr = g_utf8_next_char (*textptr);
@@ -290,387 +361,1724 @@ find_word_end (const char         **textptr,
   return FALSE;
 }
 
-static void
-clear_mistakes (gpointer data)
+/* The fast path below reproduces the word starts and ends produced by
+ * pango_get_log_attrs() for text made only of code points below U+0100.
+ * That covers ASCII and Latin-1 which is the bulk of what users type,
+ * and avoids the PangoLogAttr allocation as well as the full Unicode
+ * break algorithm for each fragment.
+ *
+ * Pango considers letters and numbers to be word characters, absorbs
+ * marks and format characters (only U+00AD in this range) into the
+ * current word and ends a word on anything else. A word of letters also
+ * ends where numbers begin and the other way around, so `mp3` is two
+ * words.
+ */
+typedef enum _LatinClass
 {
-  SpellingMistakes *mistakes = data;
-
-  mistakes->fragment = NULL;
-  g_clear_pointer (&mistakes->boundaries, g_array_unref);
-}
-
-static void
-spelling_job_check (GTask        *task,
-                    gpointer      source_object,
-                    gpointer      task_data,
-                    GCancellable *cancellable)
+  LATIN_OTHER,
+  LATIN_WHITE,
+  LATIN_LETTER,
+  LATIN_NUMBER,
+  LATIN_ABSORB,
+} LatinClass;
+
+typedef struct _LatinScanner
 {
-  SpellingJob *self = source_object;
-  SpellingBoundaries boundaries;
-  g_autoptr(GArray) result = NULL;
-
-  g_assert (G_IS_TASK (task));
-  g_assert (SPELLING_IS_JOB (self));
-  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+  const char *p;
+  const char *end;
+  gsize       i;
+  gunichar    ch;
+  LatinClass  klass;
+  /* LATIN_LETTER or LATIN_NUMBER within a word, otherwise LATIN_OTHER */
+  LatinClass  word;
+} LatinScanner;
 
-  spelling_boundaries_init (&boundaries);
-
-  result = g_array_new (FALSE, FALSE, sizeof (SpellingMistakes));
-  g_array_set_clear_func (result, clear_mistakes);
-
-  SPELLING_PROFILER_LOG ("Checking %u fragments", self->fragments->len);
+static gboolean
+text_is_latin1 (const char *text,
+                gsize       len)
+{
+  gsize i = 0;
 
-  for (guint f = 0; f < self->fragments->len; f++)
+  while (i < len)
     {
-      const SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, f);
-      G_GNUC_UNUSED g_autofree char *message = NULL;
-      g_autoptr(GtkBitset) bitset = NULL;
-      g_autofree PangoLogAttr *attrs = NULL;
-      SpellingMistakes mistakes;
-      const char *text;
-      const char *p;
-      GtkBitsetIter iter;
-      gsize textlen;
-      gsize attrslen;
-      gsize i;
-      guint pos;
-
-      SPELLING_PROFILER_BEGIN_MARK;
+      /* Skip runs of 8 ASCII bytes at a time */
+      if (i + 8 <= len)
+        {
+          guint64 v;
 
-      spelling_boundaries_clear (&boundaries);
+          memcpy (&v, &text[i], sizeof v);
 
-      mistakes.fragment = fragment;
-      mistakes.boundaries = NULL;
+          if ((v & G_GUINT64_CONSTANT (0x8080808080808080)) == 0 &&
+              ((v - G_GUINT64_CONSTANT (0x0101010101010101)) & ~v & G_GUINT64_CONSTANT (0x8080808080808080)) == 0)
+            {
+              i += 8;
+              continue;
+            }
+        }
 
-      text = g_bytes_get_data (fragment->bytes, &textlen);
-      attrslen = g_utf8_strlen (text, textlen) + 1;
-      attrs = g_new0 (PangoLogAttr, attrslen);
+      /* Lead bytes above 0xC3 encode code points past U+00FF. Embedded
+       * NUL is left to Pango as g_utf8_strlen() stops there.
+       */
+      if ((guchar)text[i] >= 0xC4 || text[i] == 0)
+        return FALSE;
 
-      g_assert (textlen <= G_MAXINT);
-      g_assert (attrslen <= G_MAXINT);
+      i++;
+    }
 
-      pango_get_log_attrs (text, (int)textlen, -1, self->language, attrs, attrslen);
+  return TRUE;
+}
 
-      p = text;
-      i = 0;
+static inline LatinClass
+latin_classify (gunichar ch)
+{
+  if (ch < 0x80)
+    {
+      if ((ch >= 'a' && ch <= 'z') ||
+          (ch >= 'A' && ch <= 'Z'))
+        return LATIN_LETTER;
 
-      for (gsize count = 0; TRUE; count++)
-        {
-          SpellingBoundary boundary;
-          const char *before = p;
+      if (ch >= '0' && ch <= '9')
+        return LATIN_NUMBER;
 
-          /* Occasionally check to break out of large runs */
-          if ((count & 0xFF) == 0 && g_atomic_int_get (&fragment->must_discard))
-            break;
+      if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f')
+        return LATIN_WHITE;
 
-          /* Find next word start */
-          if (!find_word_start (&p, &i, attrs, attrslen-1, self->extra_word_chars))
-            break;
+      return LATIN_OTHER;
+    }
 
-          boundary.byte_offset = p - text;
-          boundary.offset = i;
+  if (ch >= 0xC0)
+    return (ch == 0xD7 || ch == 0xF7) ? LATIN_OTHER : LATIN_LETTER;
 
-          /* Ensure we've moved at least one character as find_word_end() may stop
-           * on the current character it is on.
-           */
-          if (p == before)
-            {
-              p = g_utf8_next_char (p);
-              i++;
-            }
+  switch (ch)
+    {
+    case 0xA0: /* NO-BREAK SPACE */
+      return LATIN_WHITE;
 
-          if (!find_word_end (&p, &i, attrs, attrslen-1, self->extra_word_chars))
-            break;
+    case 0xAD: /* SOFT HYPHEN */
+      return LATIN_ABSORB;
 
-          boundary.length = i - boundary.offset;
-          boundary.byte_length = p - text - boundary.byte_offset;
+    case 0xAA: case 0xB5: case 0xBA:             /* Letters */
+      return LATIN_LETTER;
 
-          if (boundary.byte_length > 0)
-            spelling_boundaries_append (&boundaries, &boundary);
-        }
+    case 0xB2: case 0xB3: case 0xB9:             /* Superscripts */
+    case 0xBC: case 0xBD: case 0xBE:             /* Vulgar fractions */
+      return LATIN_NUMBER;
 
-      if (g_atomic_int_get (&fragment->must_discard))
-        continue;
+    default:
+      return LATIN_OTHER;
+    }
+}
 
-      bitset = _spelling_dictionary_check_words (self->dictionary,
-                                                 text,
-                                                 spelling_boundaries_index (&boundaries, 0),
-                                                 spelling_boundaries_get_size (&boundaries));
+static inline void
+latin_scanner_load (LatinScanner *scanner)
+{
+  if (scanner->p < scanner->end)
+    {
+      guchar c = *scanner->p;
 
-      if (gtk_bitset_iter_init_first (&iter, bitset, &pos))
-        {
-          mistakes.boundaries = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+      if (c < 0x80)
+        scanner->ch = c;
+      else
+        scanner->ch = ((c & 0x1F) << 6) | (scanner->p[1] & 0x3F);
 
-          do
-            {
-              const SpellingBoundary *b = spelling_boundaries_index (&boundaries, pos);
-              g_array_append_vals (mistakes.boundaries, b, 1);
-            }
-          while (gtk_bitset_iter_next (&iter, &pos));
+      scanner->klass = latin_classify (scanner->ch);
+    }
+}
 
-          g_array_append_val (result, mistakes);
-        }
+static inline void
+latin_scanner_init (LatinScanner *scanner,
+                    const char   *text,
+                    gsize         len)
+{
+  scanner->p = text;
+  scanner->end = text + len;
+  scanner->i = 0;
+  scanner->word = LATIN_OTHER;
 
-      if G_UNLIKELY (SPELLING_PROFILER_ACTIVE)
-        message = g_strdup_printf ("%u chars, %u bytes, %u mistakes",
-                                   (guint)attrslen,
-                                   (guint)textlen,
-                                   mistakes.boundaries ? mistakes.boundaries->len : 0);
+  latin_scanner_load (scanner);
+}
 
-      SPELLING_PROFILER_END_MARK ("Check", message);
-    }
+static inline void
+latin_scanner_advance (LatinScanner *scanner)
+{
+  if (scanner->klass == LATIN_LETTER || scanner->klass == LATIN_NUMBER)
+    scanner->word = scanner->klass;
+  else if (scanner->klass != LATIN_ABSORB)
+    scanner->word = LATIN_OTHER;
 
-  spelling_boundaries_clear (&boundaries);
+  scanner->p += (guchar)*scanner->p < 0x80 ? 1 : 2;
+  scanner->i++;
 
-  g_task_return_pointer (task,
-                         g_steal_pointer (&result),
-                         (GDestroyNotify)g_array_unref);
+  latin_scanner_load (scanner);
 }
 
-void
-spelling_job_run (SpellingJob         *self,
-                  GAsyncReadyCallback  callback,
-                  gpointer             user_data)
+static inline gboolean
+latin_scanner_is_word_start (const LatinScanner *scanner)
 {
-  g_autoptr(GTask) task = NULL;
+  return (scanner->klass == LATIN_LETTER || scanner->klass == LATIN_NUMBER) &&
+         scanner->klass != scanner->word;
+}
 
-  g_return_if_fail (SPELLING_IS_JOB (self));
+static inline gboolean
+latin_scanner_is_word_end (const LatinScanner *scanner)
+{
+  if (scanner->word == LATIN_OTHER)
+    return FALSE;
 
-  self->frozen = TRUE;
+  if (scanner->klass == LATIN_LETTER || scanner->klass == LATIN_NUMBER)
+    return scanner->klass != scanner->word;
 
-  task = g_task_new (self, NULL, callback, user_data);
-  g_task_set_source_tag (task, spelling_job_run);
-  g_task_run_in_thread (task, spelling_job_check);
+  return scanner->klass == LATIN_OTHER || scanner->klass == LATIN_WHITE;
 }
 
-void
-spelling_job_run_finish (SpellingJob       *self,
-                         GAsyncResult      *result,
-                         SpellingBoundary **fragments,
-                         guint             *n_fragments,
-                         SpellingMistake  **mistakes,
-                         guint             *n_mistakes)
+static gboolean
+latin_find_word_start (LatinScanner          *scanner,
+                       const SpellingCharSet *extra_word_chars)
 {
-  g_autoptr(GArray) ar = NULL;
-
-  g_return_if_fail (SPELLING_IS_JOB (self));
-  g_return_if_fail (G_IS_TASK (result));
-  g_return_if_fail (n_fragments != NULL || fragments == NULL);
-  g_return_if_fail (mistakes != NULL);
-  g_return_if_fail (n_mistakes != NULL);
+  while (scanner->p < scanner->end)
+    {
+      if (latin_scanner_is_word_start (scanner))
+        return TRUE;
 
-  *n_mistakes = 0;
-  *mistakes = NULL;
+      if (scanner->klass != LATIN_WHITE &&
+          spelling_char_set_contains (extra_word_chars, scanner->ch))
+        return TRUE;
 
-  if (n_fragments != NULL)
-    *n_fragments = 0;
+      latin_scanner_advance (scanner);
+    }
 
-  if (fragments != NULL)
-    *fragments = NULL;
+  return FALSE;
+}
 
-  if (n_fragments != NULL)
+static gboolean
+latin_find_word_end (LatinScanner          *scanner,
+                     const SpellingCharSet *extra_word_chars)
+{
+  while (scanner->p < scanner->end)
     {
-      for (guint i = 0; i < self->fragments->len; i++)
+      if (latin_scanner_is_word_end (scanner))
         {
-          const SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, i);
+          gboolean skipped = FALSE;
 
-          if (fragment->must_discard)
-            continue;
+          /* Same as find_word_end(), see there for details */
+          while (scanner->p < scanner->end &&
+                 scanner->klass != LATIN_WHITE &&
+                 spelling_char_set_contains (extra_word_chars, scanner->ch))
+            {
+              skipped = TRUE;
+              latin_scanner_advance (scanner);
+            }
+
+          if (skipped &&
+              scanner->p < scanner->end &&
+              latin_scanner_is_word_start (scanner))
+            (void)latin_find_word_end (scanner, extra_word_chars);
 
-          (*n_fragments)++;
+          return TRUE;
         }
+
+      latin_scanner_advance (scanner);
     }
 
-  if (fragments != NULL)
+  return FALSE;
+}
+
+/* Per-thread state reused for every fragment a thread segments so that
+ * nothing is allocated per fragment once it has warmed up.
+ */
+typedef struct _SpellingJobScratch
+{
+  SpellingArena       arena;
+  SpellingBoundaries  boundaries;
+  PangoLogAttr       *attrs;
+  gsize               n_attrs;
+} SpellingJobScratch;
+
+static void
+spelling_job_segment_latin (SpellingJob            *self,
+                            const SpellingFragment *fragment,
+                            const char             *text,
+                            gsize                   textlen,
+                            SpellingBoundaries     *boundaries)
+{
+  LatinScanner scanner;
+
+  latin_scanner_init (&scanner, text, textlen);
+
+  for (gsize count = 0; TRUE; count++)
     {
-      guint pos = 0;
+      SpellingBoundary boundary;
+      const char *before = scanner.p;
 
-      *fragments = g_new0 (SpellingBoundary, *n_fragments);
+      /* Occasionally check to break out of large runs */
+      if ((count & 0xFF) == 0 && g_atomic_int_get (&fragment->must_discard))
+        break;
 
-      for (guint i = 0; i < self->fragments->len; i++)
-        {
-          const SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, i);
+      if (!latin_find_word_start (&scanner, self->extra_word_chars))
+        break;
 
-          if (fragment->must_discard)
-            continue;
+      boundary.byte_offset = scanner.p - text;
+      boundary.offset = scanner.i;
 
-          (*fragments)[pos].offset = fragment->position;
-          (*fragments)[pos].length = fragment->length;
+      if (scanner.p == before)
+        latin_scanner_advance (&scanner);
 
-          pos++;
-        }
+      if (!latin_find_word_end (&scanner, self->extra_word_chars))
+        break;
+
+      boundary.length = scanner.i - boundary.offset;
+      boundary.byte_length = scanner.p - text - boundary.byte_offset;
+
+      if (boundary.byte_length > 0)
+        spelling_boundaries_append (boundaries, &boundary);
     }
+}
+
+static void
+spelling_job_segment_pango (SpellingJob            *self,
+                            const SpellingFragment *fragment,
+                            const char             *text,
+                            gsize                   textlen,
+                            SpellingJobScratch     *scratch)
+{
+  SpellingBoundaries *boundaries = &scratch->boundaries;
+  PangoLogAttr *attrs;
+  const char *p;
+  gsize attrslen;
+  gsize i;
 
-  ar = g_task_propagate_pointer (G_TASK (result), NULL);
+  attrslen = g_utf8_strlen (text, textlen) + 1;
 
-  if (ar != NULL)
+  if (attrslen > scratch->n_attrs)
     {
-      guint pos = 0;
-
-      for (guint i = 0; i < ar->len; i++)
-        {
-          const SpellingMistakes *m = &g_array_index (ar, SpellingMistakes, i);
+      scratch->n_attrs = MAX (attrslen, scratch->n_attrs * 2);
+      scratch->attrs = g_renew (PangoLogAttr, scratch->attrs, scratch->n_attrs);
+    }
 
-          if (m->fragment->must_discard)
-            continue;
+  attrs = scratch->attrs;
+  memset (attrs, 0, sizeof (PangoLogAttr) * attrslen);
 
-          *n_mistakes += m->boundaries->len;
-        }
+  g_assert (textlen <= G_MAXINT);
+  g_assert (attrslen <= G_MAXINT);
 
-      if (*n_mistakes == 0)
-        return;
+  pango_get_log_attrs (text, (int)textlen, -1, self->language, attrs, attrslen);
 
-      *mistakes = g_new0 (SpellingMistake, *n_mistakes);
+  p = text;
+  i = 0;
 
-      for (guint i = 0; i < ar->len; i++)
-        {
-          const SpellingMistakes *m = &g_array_index (ar, SpellingMistakes, i);
+  for (gsize count = 0; TRUE; count++)
+    {
+      SpellingBoundary boundary;
+      const char *before = p;
 
-          if (m->fragment->must_discard)
-            continue;
+      /* Occasionally check to break out of large runs */
+      if ((count & 0xFF) == 0 && g_atomic_int_get (&fragment->must_discard))
+        break;
 
-          for (guint j = 0; j < m->boundaries->len; j++)
-            {
-              const SpellingBoundary *boundary = &g_array_index (m->boundaries, SpellingBoundary, j);
+      /* Find next word start */
+      if (!find_word_start (&p, &i, attrs, attrslen-1, self->extra_word_chars))
+        break;
 
-              (*mistakes)[pos].offset = m->fragment->position + boundary->offset;
-              (*mistakes)[pos].length = boundary->length;
+      boundary.byte_offset = p - text;
+      boundary.offset = i;
 
-              pos++;
-            }
+      /* Ensure we've moved at least one character as find_word_end() may stop
+       * on the current character it is on.
+       */
+      if (p == before)
+        {
+          p = g_utf8_next_char (p);
+          i++;
         }
 
-      g_assert (pos == *n_mistakes);
+      if (!find_word_end (&p, &i, attrs, attrslen-1, self->extra_word_chars))
+        break;
+
+      boundary.length = i - boundary.offset;
+      boundary.byte_length = p - text - boundary.byte_offset;
+
+      if (boundary.byte_length > 0)
+        spelling_boundaries_append (boundaries, &boundary);
     }
 }
 
-void
-spelling_job_run_sync (SpellingJob       *self,
-                       SpellingBoundary **fragments,
-                       guint             *n_fragments,
-                       SpellingMistake  **mistakes,
-                       guint             *n_mistakes)
+static void
+spelling_job_check_fragment (SpellingJob        *self,
+                             SpellingFragment   *fragment,
+                             SpellingJobScratch *scratch)
 {
-  g_autoptr(GTask) task = NULL;
+  G_GNUC_UNUSED g_autofree char *message = NULL;
+  SpellingBoundaries *boundaries = &scratch->boundaries;
+  const char *text;
+  gboolean fast_path;
+  gsize textlen;
+  guint n_words;
 
-  g_return_if_fail (SPELLING_IS_JOB (self));
-  g_return_if_fail (n_fragments != NULL || fragments == NULL);
-  g_return_if_fail (mistakes != NULL);
-  g_return_if_fail (n_mistakes != NULL);
+  SPELLING_PROFILER_BEGIN_MARK;
 
-  self->frozen = TRUE;
+  spelling_boundaries_set_size (boundaries, 0);
 
-  task = g_task_new (self, NULL, NULL, NULL);
-  g_task_set_source_tag (task, spelling_job_run);
-  spelling_job_check (task, self, NULL, NULL);
+  fragment->words = NULL;
+  fragment->n_words = 0;
 
-  spelling_job_run_finish (self, G_ASYNC_RESULT (task), fragments, n_fragments, mistakes, n_mistakes);
-}
+  text = g_bytes_get_data (fragment->bytes, &textlen);
 
-void
-spelling_job_add_fragment (SpellingJob *self,
-                           GBytes      *bytes,
-                           guint        position,
-                           guint        length)
-{
-  SpellingFragment fragment = {0};
+  if ((fast_path = text_is_latin1 (text, textlen)))
+    spelling_job_segment_latin (self, fragment, text, textlen, boundaries);
+  else
+    spelling_job_segment_pango (self, fragment, text, textlen, scratch);
 
-  g_return_if_fail (SPELLING_IS_JOB (self));
-  g_return_if_fail (bytes != NULL);
-  g_return_if_fail (self->frozen == FALSE);
+  if (g_atomic_int_get (&fragment->must_discard))
+    return;
 
-  fragment.bytes = g_bytes_ref (bytes);
-  fragment.position = position;
-  fragment.length = length;
-  fragment.must_discard = FALSE;
+  n_words = spelling_boundaries_get_size (boundaries);
 
-  g_array_append_val (self->fragments, fragment);
+  /* Keep every word so that they can be checked once all fragments are
+   * segmented and so that the results can be salvaged word by word if
+   * the fragment is edited while in flight.
+   */
+  if (n_words > 0)
+    {
+      SpellingBoundary *words = spelling_arena_new (&scratch->arena, SpellingBoundary, n_words);
+
+      memcpy (words, spelling_boundaries_index (boundaries, 0), sizeof *words * n_words);
+
+      fragment->words = words;
+      fragment->n_words = n_words;
+    }
+
+  if G_UNLIKELY (SPELLING_PROFILER_ACTIVE)
+    message = g_strdup_printf ("%u bytes, %u words%s",
+                               (guint)textlen,
+                               n_words,
+                               fast_path ? ", latin" : "");
+
+  SPELLING_PROFILER_END_MARK ("Segment", message);
 }
 
-void
-spelling_job_notify_insert (SpellingJob *self,
-                            guint        position,
-                            guint        length)
+typedef struct _SpellingUniqueWord
 {
-  g_return_if_fail (SPELLING_IS_JOB (self));
+  guint32 hash;
+  guint   index;
+} SpellingUniqueWord;
 
-  for (guint i = 0; i < self->fragments->len; i++)
-    {
-      SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, i);
-
-      if (fragment->must_discard)
-        continue;
+static gboolean spelling_job_drain (gpointer data);
 
-      /* Inserts after w/ at least 1 position after fragment */
-      if (position > fragment->position + fragment->length)
-        continue;
+/* Makes the first @n_ready fragments available to the main thread */
+static void
+spelling_job_publish (SpellingJob *self,
+                      guint        n_ready)
+{
+  g_atomic_int_set (&self->n_ready, n_ready);
 
-      /* Inserts before w/ at least 1 position before fragment */
-      if (position < fragment->position)
-        {
-          fragment->position += length;
-          continue;
-        }
+  /* Always go through an idle source, since invoking the context would
+   * drain on the worker whenever no thread owns the context.
+   */
+  if (self->main_context != NULL &&
+      g_atomic_int_compare_and_exchange (&self->drain_queued, FALSE, TRUE))
+    {
+      g_autoptr(GSource) source = g_idle_source_new ();
 
-      g_atomic_int_set (&fragment->must_discard, TRUE);
+      g_source_set_priority (source, G_PRIORITY_DEFAULT_IDLE);
+      g_source_set_callback (source, spelling_job_drain, g_object_ref (self), g_object_unref);
+      g_source_attach (source, self->main_context);
     }
 }
 
-void
-spelling_job_notify_delete (SpellingJob *self,
-                            guint        position,
-                            guint        length)
+static void
+spelling_job_check_unique (SpellingJob            *self,
+                           const char             *text,
+                           const SpellingBoundary *unique,
+                           guint                   begin,
+                           guint                   end,
+                           guint8                 *misspelled)
 {
-  g_return_if_fail (SPELLING_IS_JOB (self));
+  G_GNUC_UNUSED g_autofree char *message = NULL;
+  g_autoptr(GtkBitset) mistakes = NULL;
+  GtkBitsetIter iter;
+  guint n_cached;
+  guint pos;
 
-  for (guint i = 0; i < self->fragments->len; i++)
-    {
-      SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, i);
+  SPELLING_PROFILER_BEGIN_MARK;
 
-      if (fragment->must_discard)
-        continue;
+  if (begin == end)
+    return;
 
-      /* Deletes after w/ at least 1 position after fragment */
-      if (position > fragment->position + fragment->length)
-        continue;
+  mistakes = _spelling_dictionary_check_words (self->dictionary, text, &unique[begin], end - begin, &n_cached);
 
-      /* If we had the ability to look back at text to see if a boundary
-       * character was before the cursor here, we could potentially avoid
-       * bailing. But that is more effort than it's worth when we can just
-       * recheck things.
-       */
+  if G_UNLIKELY (SPELLING_PROFILER_ACTIVE)
+    message = g_strdup_printf ("%u words, %u cached", end - begin, n_cached);
 
-      /* Deletes before w/ at least 1 position before fragment */
-      if (position + length < fragment->position)
-        {
-          fragment->position -= length;
-          continue;
-        }
+  SPELLING_PROFILER_END_MARK ("Lookup", message);
 
-      g_atomic_int_set (&fragment->must_discard, TRUE);
+  if (self->counters != NULL)
+    {
+      g_atomic_int_add (&self->counters->cache_hits, n_cached);
+      g_atomic_int_add (&self->counters->dictionary_calls, end - begin - n_cached);
     }
+
+  if (gtk_bitset_iter_init_first (&iter, mistakes, &pos))
+    {
+      do
+        misspelled[begin + pos] = TRUE;
+      while (gtk_bitset_iter_next (&iter, &pos));
+    }
+}
+
+/* Fragments are segmented, and then distinct words are looked up, on a
+ * shared pool of helper threads. Every participant, including the thread
+ * running the job, claims the next unclaimed item with an atomic
+ * increment until none remain, so a thread that drew a cheap item
+ * immediately picks up more work.
+ *
+ * The pool is shared by every job in the process and bounded by the
+ * number of processors. Helpers which only get scheduled after the job
+ * has run out of work do nothing, so the job never waits on a helper
+ * stuck in the pool queue behind other jobs.
+ *
+ * Only jobs of a focused owner may ask for every helper. Visible owners
+ * get a single one and background owners none, and the pool queue is
+ * sorted by priority so that helpers of a focused job go first.
+ */
+typedef struct _SpellingJobCheck SpellingJobCheck;
+
+/* Verdicts of spelling_job_check_words() being collected from the
+ * helpers, protected by the mutex of the SpellingJobCheck.
+ */
+typedef struct _SpellingJobWords
+{
+  const char             *text;
+  const SpellingBoundary *unique;
+  /* Full hash of each distinct word, passed on with its mistakes */
+  const guint64          *hashes;
+  guint8                 *misspelled;
+  const guint            *occurrences;
+  /* Number of distinct words seen up to and including each fragment */
+  const guint            *unique_end;
+  guint8                 *batch_done;
+  guint                   n_unique;
+  guint                   n_batches;
+  /* Batches, in order, whose verdicts are all known */
+  guint                   n_resolved_batches;
+  guint                   n_resolved_fragments;
+  guint                   n_resolved_words;
+  guint                   n_found;
+} SpellingJobWords;
+
+struct _SpellingJobCheck
+{
+  SpellingJob               *job;
+  void                     (*run) (SpellingJobCheck *state);
+  SpellingJobWords          *words;
+  SpellingSchedulerPriority  priority;
+  GMutex                     mutex;
+  GCond                      cond;
+  guint                      n_items;
+  guint                      next_item;
+  guint                      n_running;
+  guint                      closed : 1;
+};
+
+#define MAX_CHECK_WORKERS 16
+
+static void
+spelling_job_check_clear (gpointer data)
+{
+  SpellingJobCheck *state = data;
+
+  g_clear_object (&state->job);
+  g_mutex_clear (&state->mutex);
+  g_cond_clear (&state->cond);
+}
+
+static void
+spelling_job_check_unref (SpellingJobCheck *state)
+{
+  g_atomic_rc_box_release_full (state, spelling_job_check_clear);
+}
+
+static void
+spelling_job_check_worker (gpointer data,
+                           gpointer user_data)
+{
+  SpellingJobCheck *state = data;
+  gboolean closed;
+
+  g_mutex_lock (&state->mutex);
+  if (!(closed = state->closed))
+    state->n_running++;
+  g_mutex_unlock (&state->mutex);
+
+  if (!closed)
+    {
+      state->run (state);
+
+      g_mutex_lock (&state->mutex);
+      if (--state->n_running == 0)
+        g_cond_signal (&state->cond);
+      g_mutex_unlock (&state->mutex);
+    }
+
+  spelling_job_check_unref (state);
+}
+
+static gint
+spelling_job_check_compare (gconstpointer a,
+                            gconstpointer b,
+                            gpointer      user_data)
+{
+  const SpellingJobCheck *state_a = a;
+  const SpellingJobCheck *state_b = b;
+
+  return (gint)state_a->priority - (gint)state_b->priority;
+}
+
+static GThreadPool *
+spelling_job_get_pool (void)
+{
+  static GThreadPool *pool;
+
+  if (g_once_init_enter (&pool))
+    {
+      guint n_workers = CLAMP (g_get_num_processors (), 1, MAX_CHECK_WORKERS);
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (spelling_job_check_worker,
+                                    NULL, n_workers, FALSE, NULL);
+      g_thread_pool_set_sort_function (new_pool, spelling_job_check_compare, NULL);
+
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  return pool;
+}
+
+/* Calls @run on the job thread and on helpers until @n_items have been
+ * claimed and every helper that claimed one is done. Returns the number
+ * of helpers asked to join.
+ */
+static guint
+spelling_job_check_parallel (SpellingJob       *self,
+                             guint              n_items,
+                             void             (*run) (SpellingJobCheck *state),
+                             SpellingJobWords  *words)
+{
+  SpellingJobCheck *state;
+  guint n_helpers = 0;
+
+  state = g_atomic_rc_box_new0 (SpellingJobCheck);
+  state->job = g_object_ref (self);
+  state->run = run;
+  state->words = words;
+  state->priority = spelling_scheduler_get_priority (spelling_scheduler_get_default (), self->owner);
+  state->n_items = n_items;
+  g_mutex_init (&state->mutex);
+  g_cond_init (&state->cond);
+
+  if (n_items > 1)
+    {
+      GThreadPool *pool = spelling_job_get_pool ();
+
+      guint max_helpers;
+
+      switch (state->priority)
+        {
+        case SPELLING_SCHEDULER_PRIORITY_FOCUSED:
+          max_helpers = (guint)g_thread_pool_get_max_threads (pool);
+          break;
+
+        case SPELLING_SCHEDULER_PRIORITY_VISIBLE:
+          max_helpers = 1;
+          break;
+
+        case SPELLING_SCHEDULER_PRIORITY_BACKGROUND:
+        default:
+          max_helpers = 0;
+          break;
+        }
+
+      n_helpers = MIN (n_items - 1, max_helpers);
+
+      for (guint i = 0; i < n_helpers; i++)
+        g_thread_pool_push (pool, g_atomic_rc_box_acquire (state), NULL);
+    }
+
+  run (state);
+
+  /* Wait for helpers that are still working on an item and make sure
+   * the ones which have not started yet bail out immediately.
+   */
+  g_mutex_lock (&state->mutex);
+  state->closed = TRUE;
+  while (state->n_running > 0)
+    g_cond_wait (&state->cond, &state->mutex);
+  g_mutex_unlock (&state->mutex);
+
+  spelling_job_check_unref (state);
+
+  return n_helpers;
+}
+
+static void
+spelling_job_segment_run (SpellingJobCheck *state)
+{
+  SpellingJobScratch scratch = {0};
+  guint f;
+
+  spelling_arena_init (&scratch.arena, 4096 * 4);
+  spelling_boundaries_init (&scratch.boundaries);
+
+  while ((f = g_atomic_int_add (&state->next_item, 1)) < state->n_items)
+    {
+      SpellingFragment *fragment = &g_array_index (state->job->fragments, SpellingFragment, f);
+
+      if (g_atomic_int_get (&fragment->must_discard))
+        continue;
+
+      spelling_job_check_fragment (state->job, fragment, &scratch);
+    }
+
+  /* Words must outlive the thread, so hand them over to the job */
+  g_mutex_lock (&state->mutex);
+  spelling_arena_steal (&state->job->arena, &scratch.arena);
+  g_mutex_unlock (&state->mutex);
+
+  spelling_boundaries_clear (&scratch.boundaries);
+  g_free (scratch.attrs);
+}
+
+/* Fans the verdicts of every batch known so far, in order, back out to
+ * the fragments and publishes the fragments that are fully resolved.
+ * Must be called with the mutex of the SpellingJobCheck held.
+ */
+static void
+spelling_job_resolve_locked (SpellingJob      *self,
+                             SpellingJobWords *words)
+{
+  guint resolved = words->n_resolved_fragments;
+
+  while (words->n_resolved_batches < words->n_batches &&
+         words->batch_done[words->n_resolved_batches])
+    words->n_resolved_batches++;
+
+  while (resolved < self->fragments->len &&
+         words->unique_end[resolved] <= words->n_resolved_batches * CHECK_SLICE_WORDS)
+    {
+      SpellingFragment *ready = &g_array_index (self->fragments, SpellingFragment, resolved);
+
+      ready->first_mistake = words->n_found;
+
+      for (guint i = 0; i < ready->n_words; i++)
+        {
+          guint u = words->occurrences[words->n_resolved_words++];
+
+          if (words->misspelled[u])
+            {
+              SpellingMistake *mistake = &self->mistakes[words->n_found++];
+
+              mistake->offset = i;
+              mistake->length = ready->words[i].length;
+              mistake->hash = words->hashes[u];
+            }
+        }
+
+      ready->n_mistakes = words->n_found - ready->first_mistake;
+      resolved++;
+    }
+
+  if (resolved > words->n_resolved_fragments)
+    {
+      words->n_resolved_fragments = resolved;
+      spelling_job_publish (self, resolved);
+    }
+}
+
+static void
+spelling_job_lookup_run (SpellingJobCheck *state)
+{
+  SpellingJobWords *words = state->words;
+  guint b;
+
+  while ((b = g_atomic_int_add (&state->next_item, 1)) < state->n_items)
+    {
+      guint begin = b * CHECK_SLICE_WORDS;
+      guint end = MIN (begin + CHECK_SLICE_WORDS, words->n_unique);
+
+      spelling_job_check_unique (state->job, words->text, words->unique, begin, end, words->misspelled);
+
+      g_mutex_lock (&state->mutex);
+      words->batch_done[b] = TRUE;
+      spelling_job_resolve_locked (state->job, words);
+      g_mutex_unlock (&state->mutex);
+    }
+}
+
+/* Checks the words of every segmented fragment against the dictionary.
+ * Text tends to repeat the same few words over and over, so each distinct
+ * word is only looked up once and the verdict is fanned back out to each
+ * occurrence. Distinct words are copied next to each other into the job
+ * arena, in order of first occurrence, and looked up in batches spread
+ * over the helper pool.
+ *
+ * Fragments are resolved in order and published as soon as every word
+ * they contain has been checked so that the results can be delivered
+ * before the whole job is done.
+ *
+ * Mistakes are appended to the job mistakes in fragment order. Until the
+ * fragment is delivered the offset of each mistake is the index of the
+ * word within its fragment.
+ */
+static guint
+spelling_job_check_words (SpellingJob *self,
+                          guint       *n_helpers)
+{
+  G_GNUC_UNUSED g_autofree char *message = NULL;
+  SpellingJobWords words = {0};
+  SpellingUniqueWord *table;
+  SpellingBoundary *unique;
+  guint64 *hashes;
+  guint *occurrences;
+  guint *unique_end;
+  char *text;
+  gsize n_bytes = 0;
+  guint n_words = 0;
+  guint n_unique = 0;
+  guint n_slots = 16;
+  guint byte_offset = 0;
+  guint w = 0;
+
+  SPELLING_PROFILER_BEGIN_MARK;
+
+  g_clear_pointer (&self->mistakes, g_free);
+
+  for (guint f = 0; f < self->fragments->len; f++)
+    {
+      const SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, f);
+
+      for (guint i = 0; i < fragment->n_words; i++)
+        n_bytes += fragment->words[i].byte_length;
+
+      n_words += fragment->n_words;
+    }
+
+  if (n_words == 0)
+    {
+      spelling_job_publish (self, self->fragments->len);
+      return 0;
+    }
+
+  while (n_slots < n_words * 2)
+    n_slots *= 2;
+
+  /* Slots hold the index of a distinct word plus one, zero being empty */
+  table = spelling_arena_new0 (&self->arena, SpellingUniqueWord, n_slots);
+  unique = spelling_arena_new (&self->arena, SpellingBoundary, n_words);
+  hashes = spelling_arena_new (&self->arena, guint64, n_words);
+  occurrences = spelling_arena_new (&self->arena, guint, n_words);
+  unique_end = spelling_arena_new (&self->arena, guint, self->fragments->len);
+  text = spelling_arena_alloc (&self->arena, n_bytes);
+
+  self->mistakes = g_new (SpellingMistake, n_words);
+
+  for (guint f = 0; f < self->fragments->len; f++)
+    {
+      const SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, f);
+      const char *fragment_text = g_bytes_get_data (fragment->bytes, NULL);
+
+      for (guint i = 0; i < fragment->n_words; i++)
+        {
+          const SpellingBoundary *word = &fragment->words[i];
+          const char *bytes = &fragment_text[word->byte_offset];
+          guint64 full_hash = _spelling_word_hash (bytes, word->byte_length);
+          guint32 hash = (guint32)full_hash;
+          guint slot = hash & (n_slots - 1);
+
+          while (table[slot].index != 0)
+            {
+              const SpellingBoundary *other = &unique[table[slot].index - 1];
+
+              if (table[slot].hash == hash &&
+                  other->byte_length == word->byte_length &&
+                  memcmp (&text[other->byte_offset], bytes, word->byte_length) == 0)
+                break;
+
+              slot = (slot + 1) & (n_slots - 1);
+            }
+
+          if (table[slot].index == 0)
+            {
+              SpellingBoundary *copy = &unique[n_unique];
+
+              memcpy (&text[byte_offset], bytes, word->byte_length);
+
+              copy->offset = byte_offset;
+              copy->length = word->length;
+              copy->byte_offset = byte_offset;
+              copy->byte_length = word->byte_length;
+
+              byte_offset += word->byte_length;
+
+              hashes[n_unique] = full_hash;
+              table[slot].hash = hash;
+              table[slot].index = ++n_unique;
+            }
+
+          occurrences[w++] = table[slot].index - 1;
+        }
+
+      unique_end[f] = n_unique;
+    }
+
+  words.text = text;
+  words.unique = unique;
+  words.hashes = hashes;
+  words.misspelled = spelling_arena_new0 (&self->arena, guint8, n_unique);
+  words.occurrences = occurrences;
+  words.unique_end = unique_end;
+  words.n_unique = n_unique;
+  words.n_batches = (n_unique + CHECK_SLICE_WORDS - 1) / CHECK_SLICE_WORDS;
+  words.batch_done = spelling_arena_new0 (&self->arena, guint8, words.n_batches);
+
+  *n_helpers += spelling_job_check_parallel (self, words.n_batches, spelling_job_lookup_run, &words);
+
+  g_assert (words.n_resolved_fragments == self->fragments->len);
+
+  if (self->counters != NULL)
+    {
+      g_atomic_int_add (&self->counters->words_checked, n_words);
+      g_atomic_int_add (&self->counters->unique_words, n_unique);
+    }
+
+  if G_UNLIKELY (SPELLING_PROFILER_ACTIVE)
+    message = g_strdup_printf ("%u words, %u unique, %u mistakes",
+                               n_words, n_unique, words.n_found);
+
+  SPELLING_PROFILER_END_MARK ("Check", message);
+
+  return n_words;
+}
+
+static void
+spelling_job_check (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  SpellingJob *self = source_object;
+  gint64 begin_time = g_get_monotonic_time ();
+  guint n_helpers = 0;
+  guint n_words;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (SPELLING_IS_JOB (self));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  SPELLING_PROFILER_LOG ("Checking %u fragments", self->fragments->len);
+
+  n_helpers = spelling_job_check_parallel (self, self->fragments->len, spelling_job_segment_run, NULL);
+  n_words = spelling_job_check_words (self, &n_helpers);
+
+  if G_UNLIKELY (SPELLING_PROFILER_ACTIVE)
+    {
+      guint hits;
+      guint misses;
+
+      _spelling_dictionary_get_cache_stats (self->dictionary, &hits, &misses);
+      SPELLING_PROFILER_LOG ("Dictionary cache: %u hits, %u misses, %u helpers",
+                             hits, misses, n_helpers);
+    }
+
+  self->elapsed = g_get_monotonic_time () - begin_time;
+
+  if (self->elapsed > 0)
+    SPELLING_PROFILER_COUNTER_SET (SPELLING_PROFILER_COUNTER_WORDS_PER_SEC,
+                                   n_words * (double)G_USEC_PER_SEC / self->elapsed);
+
+  if (self->counters != NULL)
+    {
+      g_atomic_int_inc (&self->counters->jobs_run);
+      spelling_counters_add (self->counters, &self->counters->job_time, self->elapsed);
+      spelling_histogram_record (&self->counters->job_latency, self->elapsed);
+    }
+
+  /* Results are stored with each fragment and collected, in fragment
+   * order, by spelling_job_run_finish().
+   */
+  g_task_return_boolean (task, TRUE);
+}
+
+void
+spelling_job_run (SpellingJob         *self,
+                  GAsyncReadyCallback  callback,
+                  gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (SPELLING_IS_JOB (self));
+
+  self->frozen = TRUE;
+  self->n_ready = 0;
+  self->n_drained = 0;
+
+  if (self->progress_func != NULL && self->main_context == NULL)
+    self->main_context = g_main_context_ref_thread_default ();
+
+  task = g_task_new (self, NULL, callback, user_data);
+  g_task_set_source_tag (task, spelling_job_run);
+  spelling_scheduler_push (spelling_scheduler_get_default (),
+                           self->owner, task, spelling_job_check);
+}
+
+/* Maps the span [@offset, @offset+@length] of the original fragment text
+ * through the edits made while the fragment was in flight. Returns %FALSE
+ * if any edit touched the span, including edits right at either end.
+ */
+static gboolean
+spelling_fragment_map_span (const SpellingFragment *fragment,
+                            guint                   offset,
+                            guint                   length,
+                            gint64                 *mapped)
+{
+  gint64 begin = offset;
+  gint64 end = (gint64)offset + length;
+
+  for (guint i = 0; i < fragment->edits->len; i++)
+    {
+      const SpellingEdit *edit = &g_array_index (fragment->edits, SpellingEdit, i);
+      gint64 edit_begin = edit->position;
+      gint64 edit_end = edit_begin + (edit->kind == SPELLING_EDIT_INSERT ? 0 : edit->length);
+
+      if (edit_begin > end)
+        continue;
+
+      if (edit_end >= begin)
+        return FALSE;
+
+      if (edit->kind == SPELLING_EDIT_INSERT)
+        {
+          begin += edit->length;
+          end += edit->length;
+        }
+      else if (edit->kind == SPELLING_EDIT_DELETE)
+        {
+          begin -= edit->length;
+          end -= edit->length;
+        }
+    }
+
+  *mapped = begin;
+
+  return TRUE;
+}
+
+static void
+spelling_fragment_add_checked (const SpellingFragment *fragment,
+                               GArray                 *checked,
+                               guint                   first,
+                               gint64                  offset,
+                               guint                   length)
+{
+  SpellingBoundary *last;
+  SpellingBoundary range = {0};
+
+  range.offset = fragment->position + fragment->origin + offset;
+  range.length = length;
+
+  /* Coalesce with the previous range of this fragment when contiguous */
+  if (checked->len > first &&
+      (last = &g_array_index (checked, SpellingBoundary, checked->len - 1)) &&
+      last->offset + last->length == range.offset)
+    {
+      last->length += range.length;
+      return;
+    }
+
+  g_array_append_val (checked, range);
+}
+
+/* Collects what is still valid from a fragment which was edited while it
+ * was being checked. The original text is split into words and the gaps
+ * between them, and each piece which was not touched by any edit is kept
+ * at its new position. Pieces that were touched are left out so that the
+ * engine keeps them marked for checking.
+ */
+static void
+spelling_fragment_salvage (const SpellingFragment *fragment,
+                           GArray                 *checked,
+                           const SpellingMistake  *mistakes,
+                           SpellingMistake        *found,
+                           guint                  *n_found)
+{
+  guint first = checked->len;
+  guint last = 0;
+  guint m = 0;
+  gint64 mapped;
+
+  g_assert (fragment->edits != NULL);
+
+  for (guint i = 0; i < fragment->n_words; i++)
+    {
+      const SpellingBoundary *word = &fragment->words[i];
+      gboolean is_mistake = FALSE;
+      guint64 hash = 0;
+
+      if (m < fragment->n_mistakes && mistakes[fragment->first_mistake + m].offset == i)
+        {
+          is_mistake = TRUE;
+          hash = mistakes[fragment->first_mistake + m].hash;
+          m++;
+        }
+
+      if (word->offset > last &&
+          spelling_fragment_map_span (fragment, last, word->offset - last, &mapped))
+        spelling_fragment_add_checked (fragment, checked, first, mapped, word->offset - last);
+
+      if (spelling_fragment_map_span (fragment, word->offset, word->length, &mapped))
+        {
+          spelling_fragment_add_checked (fragment, checked, first, mapped, word->length);
+
+          if (is_mistake)
+            {
+              SpellingMistake *mistake = &found[(*n_found)++];
+
+              mistake->offset = fragment->position + fragment->origin + mapped;
+              mistake->length = word->length;
+              mistake->hash = hash;
+            }
+        }
+
+      last = word->offset + word->length;
+    }
+
+  if (fragment->original_length > last &&
+      spelling_fragment_map_span (fragment, last, fragment->original_length - last, &mapped))
+    spelling_fragment_add_checked (fragment, checked, first, mapped, fragment->original_length - last);
+}
+
+/* Appends the checked ranges of @fragment to @checked and its mistakes,
+ * converted from word indexes in @mistakes to buffer offsets, to @found.
+ * @found may be the same as @mistakes as entries are only ever written
+ * at or before the entry being read.
+ */
+static void
+spelling_fragment_collect (const SpellingFragment *fragment,
+                           GArray                 *checked,
+                           const SpellingMistake  *mistakes,
+                           SpellingMistake        *found,
+                           guint                  *n_found)
+{
+  if (fragment->edits != NULL)
+    {
+      spelling_fragment_salvage (fragment, checked, mistakes, found, n_found);
+      return;
+    }
+
+  spelling_fragment_add_checked (fragment, checked, checked->len, 0, fragment->length);
+
+  for (guint m = 0; m < fragment->n_mistakes; m++)
+    {
+      const SpellingBoundary *word = &fragment->words[mistakes[fragment->first_mistake + m].offset];
+      guint64 hash = mistakes[fragment->first_mistake + m].hash;
+      SpellingMistake *mistake = &found[(*n_found)++];
+
+      mistake->offset = fragment->position + fragment->origin + word->offset;
+      mistake->length = word->length;
+      mistake->hash = hash;
+    }
+}
+
+static gboolean
+spelling_job_drain (gpointer data)
+{
+  SpellingJob *self = data;
+  guint n_ready = g_atomic_int_get (&self->n_ready);
+
+  g_assert (SPELLING_IS_JOB (self));
+
+  if (self->progress_func != NULL && self->n_drained < n_ready)
+    {
+      G_GNUC_UNUSED g_autofree char *message = NULL;
+      g_autoptr(GArray) checked = NULL;
+      g_autofree SpellingMistake *found = NULL;
+      guint end = MIN (n_ready, self->n_drained + DRAIN_SLICE_FRAGMENTS);
+      guint n_found = 0;
+      guint n_mistakes = 0;
+
+      SPELLING_PROFILER_BEGIN_MARK;
+
+      spelling_job_index_flush (self);
+
+      for (guint i = self->n_drained; i < end; i++)
+        n_mistakes += g_array_index (self->fragments, SpellingFragment, i).n_mistakes;
+
+      checked = g_array_sized_new (FALSE, FALSE, sizeof (SpellingBoundary), end - self->n_drained);
+      found = g_new (SpellingMistake, MAX (n_mistakes, 1));
+
+      for (; self->n_drained < end; self->n_drained++)
+        {
+          SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, self->n_drained);
+
+          if (fragment->must_discard)
+            continue;
+
+          spelling_fragment_collect (fragment, checked, self->mistakes, found, &n_found);
+
+          /* Delivered fragments are no longer tracked for edits */
+          g_atomic_int_set (&fragment->must_discard, TRUE);
+        }
+
+      if G_UNLIKELY (SPELLING_PROFILER_ACTIVE)
+        message = g_strdup_printf ("%u fragments, %u mistakes", checked->len, n_found);
+
+      SPELLING_PROFILER_END_MARK ("Merge", message);
+
+      if (checked->len > 0 || n_found > 0)
+        self->progress_func (self,
+                             &g_array_index (checked, SpellingBoundary, 0), checked->len,
+                             found, n_found,
+                             self->progress_data);
+
+      if (self->n_drained < n_ready)
+        return G_SOURCE_CONTINUE;
+    }
+
+  g_atomic_int_set (&self->drain_queued, FALSE);
+
+  /* Catch up with fragments published while the drain was still queued */
+  if (self->progress_func != NULL &&
+      self->n_drained < (guint)g_atomic_int_get (&self->n_ready) &&
+      g_atomic_int_compare_and_exchange (&self->drain_queued, FALSE, TRUE))
+    return G_SOURCE_CONTINUE;
+
+  return G_SOURCE_REMOVE;
 }
 
 void
-spelling_job_invalidate (SpellingJob *self,
-                         guint        position,
-                         guint        length)
+spelling_job_run_finish (SpellingJob       *self,
+                         GAsyncResult      *result,
+                         SpellingBoundary **fragments,
+                         guint             *n_fragments,
+                         SpellingMistake  **mistakes,
+                         guint             *n_mistakes)
 {
+  G_GNUC_UNUSED g_autofree char *message = NULL;
+  g_autoptr(GArray) checked = NULL;
+  guint n_found = 0;
+
+  SPELLING_PROFILER_BEGIN_MARK;
+
   g_return_if_fail (SPELLING_IS_JOB (self));
+  g_return_if_fail (G_IS_TASK (result));
+  g_return_if_fail (n_fragments != NULL || fragments == NULL);
+  g_return_if_fail (mistakes != NULL);
+  g_return_if_fail (n_mistakes != NULL);
+
+  spelling_job_index_flush (self);
 
-  for (guint i = 0; i < self->fragments->len; i++)
+  /* Anything not delivered yet is part of the result */
+  spelling_job_set_progress_func (self, NULL, NULL, NULL);
+
+  *n_mistakes = 0;
+  *mistakes = NULL;
+
+  if (n_fragments != NULL)
+    *n_fragments = 0;
+
+  if (fragments != NULL)
+    *fragments = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (result), NULL))
+    return;
+
+  checked = g_array_sized_new (FALSE, FALSE, sizeof (SpellingBoundary), self->fragments->len);
+
+  /* Mistakes of each fragment are rewritten from word indexes to buffer
+   * offsets in place. Dropped mistakes only ever make the output shorter
+   * than what has been read, so the job mistakes become the result.
+   */
+  for (guint i = self->n_drained; i < self->fragments->len; i++)
     {
-      SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, i);
+      const SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, i);
 
       if (fragment->must_discard)
         continue;
 
-      if (position > fragment->position + fragment->length)
+      spelling_fragment_collect (fragment, checked, self->mistakes, self->mistakes, &n_found);
+    }
+
+  self->n_drained = self->fragments->len;
+
+  if G_UNLIKELY (SPELLING_PROFILER_ACTIVE)
+    message = g_strdup_printf ("%u fragments, %u mistakes", checked->len, n_found);
+
+  SPELLING_PROFILER_END_MARK ("Merge", message);
+
+  if (n_fragments != NULL)
+    *n_fragments = checked->len;
+
+  if (fragments != NULL && checked->len > 0)
+    *fragments = (SpellingBoundary *)(gpointer)g_array_free (g_steal_pointer (&checked), FALSE);
+
+  if (n_found > 0)
+    {
+      *n_mistakes = n_found;
+      *mistakes = g_steal_pointer (&self->mistakes);
+    }
+}
+
+/* Sets a function which receives the results of fragments, in order and
+ * in small slices on the main context the job was run from, as soon as
+ * they are ready rather than when the whole job is finished.
+ *
+ * Results which were delivered to @func are not part of the result of
+ * spelling_job_run_finish(), which only contains the remainder. The
+ * function is cleared when the job is finished.
+ */
+void
+spelling_job_set_progress_func (SpellingJob             *self,
+                                SpellingJobProgressFunc  func,
+                                gpointer                 user_data,
+                                GDestroyNotify           user_data_destroy)
+{
+  GDestroyNotify notify;
+  gpointer data;
+
+  g_return_if_fail (SPELLING_IS_JOB (self));
+
+  notify = self->progress_data_destroy;
+  data = self->progress_data;
+
+  self->progress_func = func;
+  self->progress_data = user_data;
+  self->progress_data_destroy = user_data_destroy;
+
+  if (notify != NULL)
+    notify (data);
+}
+
+/* Sets on whose behalf the job is queued with the scheduler, which
+ * decides on the order of jobs based on the priority of the owner.
+ */
+void
+spelling_job_set_owner (SpellingJob   *self,
+                        gconstpointer  owner)
+{
+  g_return_if_fail (SPELLING_IS_JOB (self));
+  g_return_if_fail (!self->frozen);
+
+  self->owner = owner;
+}
+
+/* Sets the counters updated while the job runs, which may be shared by
+ * any number of jobs running at once.
+ */
+void
+spelling_job_set_counters (SpellingJob      *self,
+                           SpellingCounters *counters)
+{
+  g_return_if_fail (SPELLING_IS_JOB (self));
+  g_return_if_fail (!self->frozen);
+
+  if (counters != NULL)
+    spelling_counters_ref (counters);
+
+  g_clear_pointer (&self->counters, spelling_counters_unref);
+  self->counters = counters;
+}
+
+void
+spelling_job_run_sync (SpellingJob       *self,
+                       SpellingBoundary **fragments,
+                       guint             *n_fragments,
+                       SpellingMistake  **mistakes,
+                       guint             *n_mistakes)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (SPELLING_IS_JOB (self));
+  g_return_if_fail (n_fragments != NULL || fragments == NULL);
+  g_return_if_fail (mistakes != NULL);
+  g_return_if_fail (n_mistakes != NULL);
+
+  self->frozen = TRUE;
+  self->n_ready = 0;
+  self->n_drained = 0;
+
+  task = g_task_new (self, NULL, NULL, NULL);
+  g_task_set_source_tag (task, spelling_job_run);
+  spelling_job_check (task, self, NULL, NULL);
+
+  spelling_job_run_finish (self, G_ASYNC_RESULT (task), fragments, n_fragments, mistakes, n_mistakes);
+}
+
+void
+spelling_job_add_fragment (SpellingJob *self,
+                           GBytes      *bytes,
+                           guint        position,
+                           guint        length)
+{
+  SpellingFragment fragment = {0};
+
+  g_return_if_fail (SPELLING_IS_JOB (self));
+  g_return_if_fail (bytes != NULL);
+  g_return_if_fail (self->frozen == FALSE);
+
+  /* Positions may have been adjusted lazily by edits */
+  spelling_job_index_flush (self);
+
+  fragment.bytes = g_bytes_ref (bytes);
+  fragment.position = position;
+  fragment.length = length;
+  fragment.original_length = length;
+  fragment.must_discard = FALSE;
+
+  g_array_append_val (self->fragments, fragment);
+
+  self->length += length;
+}
+
+/* While a job is in flight the engine forwards every edit so the job can
+ * adjust fragment positions and record edits on the fragments they touch,
+ * which lets the unaffected words be salvaged once checking is done. To keep
+ * that cheap for jobs with many fragments, the fragments are indexed by
+ * position and every edit only touches the fragments near it.
+ *
+ * Shifting every fragment after an edit is done lazily by adding a delta
+ * for a suffix of the sorted index into a Fenwick tree. The position of a
+ * fragment is then its stored position plus the prefix sum at its rank.
+ * Stored positions use modular arithmetic so that a fragment may carry a
+ * negative offset relative to the accumulated delta.
+ *
+ * Edits never reorder fragments, as fragments which start inside of a
+ * delete are clamped to the delete position so that the index stays sorted.
+ */
+
+static int
+compare_fragment_index (gconstpointer a,
+                        gconstpointer b,
+                        gpointer      user_data)
+{
+  const SpellingFragment *fragments = user_data;
+  guint ia = *(const guint *)a;
+  guint ib = *(const guint *)b;
+
+  if (fragments[ia].position < fragments[ib].position)
+    return -1;
+  else if (fragments[ia].position > fragments[ib].position)
+    return 1;
+  else if (ia < ib)
+    return -1;
+  else if (ia > ib)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+spelling_job_index_build (SpellingJob *self)
+{
+  guint n = self->fragments->len;
+
+  g_assert (self->index == NULL);
+
+  self->index = g_new (guint, n);
+  self->index_delta = g_new0 (int, n);
+  self->index_tree = g_new0 (int, n + 1);
+  self->index_max_length = 0;
+
+  for (guint i = 0; i < n; i++)
+    {
+      const SpellingFragment *fragment = &g_array_index (self->fragments, SpellingFragment, i);
+
+      self->index[i] = i;
+      self->index_max_length = MAX (self->index_max_length, fragment->length);
+    }
+
+  g_qsort_with_data (self->index, n, sizeof (guint),
+                     compare_fragment_index,
+                     self->fragments->data);
+}
+
+static inline SpellingFragment *
+spelling_job_index_get_fragment (SpellingJob *self,
+                                 guint        rank)
+{
+  return &g_array_index (self->fragments, SpellingFragment, self->index[rank]);
+}
+
+static inline guint
+spelling_job_index_get_position (SpellingJob *self,
+                                 guint        rank)
+{
+  int sum = 0;
+
+  for (guint i = rank + 1; i > 0; i -= i & -i)
+    sum += self->index_tree[i];
+
+  return spelling_job_index_get_fragment (self, rank)->position + (guint)sum;
+}
+
+static inline void
+spelling_job_index_set_position (SpellingJob *self,
+                                 guint        rank,
+                                 guint        position)
+{
+  SpellingFragment *fragment = spelling_job_index_get_fragment (self, rank);
+
+  fragment->position += position - spelling_job_index_get_position (self, rank);
+}
+
+static void
+spelling_job_index_shift (SpellingJob *self,
+                          guint        rank,
+                          int          delta)
+{
+  guint n = self->fragments->len;
+
+  if (rank >= n || delta == 0)
+    return;
+
+  self->index_delta[rank] += delta;
+
+  for (guint i = rank + 1; i <= n; i += i & -i)
+    self->index_tree[i] += delta;
+}
+
+/* Returns the rank of the first fragment starting after @position */
+static guint
+spelling_job_index_upper_bound (SpellingJob *self,
+                                guint        position)
+{
+  guint lo = 0;
+  guint hi = self->fragments->len;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (spelling_job_index_get_position (self, mid) <= position)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static void
+spelling_job_index_ensure (SpellingJob *self)
+{
+  if (self->index == NULL)
+    spelling_job_index_build (self);
+}
+
+/* Writes the effective positions back into the fragments */
+static void
+spelling_job_index_flush (SpellingJob *self)
+{
+  int sum = 0;
+
+  if (self->index == NULL)
+    return;
+
+  for (guint rank = 0; rank < self->fragments->len; rank++)
+    {
+      sum += self->index_delta[rank];
+      spelling_job_index_get_fragment (self, rank)->position += (guint)sum;
+    }
+
+  spelling_job_index_clear (self);
+}
+
+static void
+spelling_job_index_clear (SpellingJob *self)
+{
+  g_clear_pointer (&self->index, g_free);
+  g_clear_pointer (&self->index_delta, g_free);
+  g_clear_pointer (&self->index_tree, g_free);
+  self->index_max_length = 0;
+}
+
+/* Drops the results of @fragment, which the engine checks again */
+static void
+spelling_job_discard_fragment (SpellingJob      *self,
+                               SpellingFragment *fragment)
+{
+  g_atomic_int_set (&fragment->must_discard, TRUE);
+
+  if (self->counters != NULL)
+    g_atomic_int_inc (&self->counters->discarded_fragments);
+}
+
+static void
+spelling_fragment_add_edit (SpellingJob      *self,
+                            SpellingFragment *fragment,
+                            SpellingEditKind  kind,
+                            int               position,
+                            guint             length)
+{
+  SpellingEdit edit;
+
+  if (fragment->edits == NULL)
+    fragment->edits = g_array_new (FALSE, FALSE, sizeof (SpellingEdit));
+
+  /* Give up on salvaging fragments that keep getting edited and just
+   * let the engine check them again.
+   */
+  if (fragment->edits->len >= MAX_FRAGMENT_EDITS)
+    {
+      spelling_job_discard_fragment (self, fragment);
+      return;
+    }
+
+  edit.kind = kind;
+  edit.position = position;
+  edit.length = length;
+
+  g_array_append_val (fragment->edits, edit);
+}
+
+/* Records an edit on every fragment in ranks before @end which contains
+ * any position between @begin and @begin+@length (inclusive), walking
+ * backwards until no earlier fragment can reach @begin. Positions and
+ * lengths of the touched fragments are updated to cover the text as it
+ * is after the edit.
+ */
+static void
+spelling_job_index_touch (SpellingJob      *self,
+                          guint             end,
+                          SpellingEditKind  kind,
+                          guint             begin,
+                          guint             length)
+{
+  for (guint rank = end; rank > 0; rank--)
+    {
+      SpellingFragment *fragment = spelling_job_index_get_fragment (self, rank - 1);
+      guint position = spelling_job_index_get_position (self, rank - 1);
+      guint touch_length = kind == SPELLING_EDIT_INSERT ? 0 : length;
+      int local;
+
+      if ((guint64)position + self->index_max_length < begin)
+        break;
+
+      /* Discarded fragments are moved out of the way of a delete too,
+       * so that the index stays sorted.
+       */
+      if (kind == SPELLING_EDIT_DELETE && position > begin)
+        spelling_job_index_set_position (self, rank - 1, begin);
+
+      if (fragment->must_discard)
         continue;
 
-      if (position + length < fragment->position)
+      if ((guint64)position + fragment->length < begin ||
+          (guint64)begin + touch_length < position)
         continue;
 
-      g_atomic_int_set (&fragment->must_discard, TRUE);
+      local = (int)begin - (int)position - fragment->origin;
+
+      spelling_fragment_add_edit (self, fragment, kind, local, length);
+
+      if (kind == SPELLING_EDIT_INSERT)
+        {
+          fragment->length += length;
+          self->index_max_length = MAX (self->index_max_length, fragment->length);
+        }
+      else if (kind == SPELLING_EDIT_DELETE)
+        {
+          guint64 overlap_begin = MAX (position, begin);
+          guint64 overlap_end = MIN ((guint64)position + fragment->length, (guint64)begin + length);
+
+          if (overlap_end > overlap_begin)
+            fragment->length -= overlap_end - overlap_begin;
+
+          if (position > begin)
+            fragment->origin += position - begin;
+
+          if (fragment->length == 0)
+            spelling_job_discard_fragment (self, fragment);
+        }
     }
 }
+
+void
+spelling_job_notify_insert (SpellingJob *self,
+                            guint        position,
+                            guint        length)
+{
+  guint after;
+
+  g_return_if_fail (SPELLING_IS_JOB (self));
+
+  if (self->fragments->len == 0)
+    return;
+
+  spelling_job_index_ensure (self);
+
+  /* Inserts before w/ at least 1 position before fragment are shifted */
+  after = spelling_job_index_upper_bound (self, position);
+
+  /* Anything touching the insert position keeps what it can */
+  spelling_job_index_touch (self, after, SPELLING_EDIT_INSERT, position, length);
+
+  spelling_job_index_shift (self, after, length);
+}
+
+void
+spelling_job_notify_delete (SpellingJob *self,
+                            guint        position,
+                            guint        length)
+{
+  guint after;
+
+  g_return_if_fail (SPELLING_IS_JOB (self));
+
+  if (self->fragments->len == 0)
+    return;
+
+  spelling_job_index_ensure (self);
+
+  /* Deletes before w/ at least 1 position before fragment are shifted */
+  after = spelling_job_index_upper_bound (self, position + length);
+
+  spelling_job_index_touch (self, after, SPELLING_EDIT_DELETE, position, length);
+
+  spelling_job_index_shift (self, after, -(int)length);
+}
+
+void
+spelling_job_invalidate (SpellingJob *self,
+                         guint        position,
+                         guint        length)
+{
+  guint after;
+
+  g_return_if_fail (SPELLING_IS_JOB (self));
+
+  if (self->fragments->len == 0)
+    return;
+
+  spelling_job_index_ensure (self);
+
+  after = spelling_job_index_upper_bound (self, position + length);
+
+  spelling_job_index_touch (self, after, SPELLING_EDIT_INVALIDATE, position, length);
+}
+
+guint
+spelling_job_get_length (SpellingJob *self)
+{
+  g_return_val_if_fail (SPELLING_IS_JOB (self), 0);
+
+  return self->length;
+}
+
+/* Returns the time, in microseconds, it took to check the job or 0 if
+ * it has not been run yet.
+ */
+gint64
+spelling_job_get_elapsed (SpellingJob *self)
+{
+  g_return_val_if_fail (SPELLING_IS_JOB (self), 0);
+
+  return self->elapsed;
+}
@@ -0,0 +1,55 @@
+/* spelling-scheduler-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum _SpellingSchedulerPriority
+{
+  SPELLING_SCHEDULER_PRIORITY_FOCUSED,
+  SPELLING_SCHEDULER_PRIORITY_VISIBLE,
+  SPELLING_SCHEDULER_PRIORITY_BACKGROUND,
+  SPELLING_SCHEDULER_N_PRIORITIES,
+} SpellingSchedulerPriority;
+
+#define SPELLING_TYPE_SCHEDULER (spelling_scheduler_get_type())
+
+G_DECLARE_FINAL_TYPE (SpellingScheduler, spelling_scheduler, SPELLING, SCHEDULER, GObject)
+
+SpellingScheduler         *spelling_scheduler_get_default  (void);
+SpellingScheduler         *spelling_scheduler_new          (guint                      max_running);
+SpellingSchedulerPriority  spelling_scheduler_get_priority (SpellingScheduler         *self,
+                                                            gconstpointer              owner);
+void                       spelling_scheduler_set_priority (SpellingScheduler         *self,
+                                                            gconstpointer              owner,
+                                                            SpellingSchedulerPriority  priority);
+void                       spelling_scheduler_push         (SpellingScheduler         *self,
+                                                            gconstpointer              owner,
+                                                            GTask                     *task,
+                                                            GTaskThreadFunc            thread_func);
+void                       spelling_scheduler_cancel       (SpellingScheduler         *self,
+                                                            gconstpointer              owner);
+void                       spelling_scheduler_forget       (SpellingScheduler         *self,
+                                                            gconstpointer              owner);
+
+G_END_DECLS
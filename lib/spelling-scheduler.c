@@ -0,0 +1,396 @@
+/* spelling-scheduler.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "spelling-scheduler-private.h"
+#include "spelling-trace.h"
+
+/* The scheduler runs the thread part of tasks from every engine in the
+ * process on a small pool of its own, so that restoring a session with
+ * hundreds of buffers does not flood the default GTask pool.
+ *
+ * Work is queued per owner (an engine). Owners with queued work wait in
+ * a round-robin queue for their priority so that one large buffer cannot
+ * starve the others. Focused owners go before visible ones, and
+ * background owners only get capacity that nobody else asked for and
+ * never more than MAX_RUNNING_BACKGROUND tasks at once.
+ */
+#define MAX_RUNNING            4
+#define MAX_RUNNING_BACKGROUND 1
+
+typedef struct _SpellingSchedulerClient
+{
+  gconstpointer             owner;
+  GQueue                    pending;
+  GList                     ready_link;
+  SpellingSchedulerPriority priority;
+  guint                     queued : 1;
+} SpellingSchedulerClient;
+
+typedef struct _SpellingSchedulerEntry
+{
+  GTask           *task;
+  GTaskThreadFunc  thread_func;
+  guint            background : 1;
+} SpellingSchedulerEntry;
+
+struct _SpellingScheduler
+{
+  GObject       parent_instance;
+  GMutex        mutex;
+  GThreadPool  *pool;
+  GHashTable   *clients;
+  GQueue        ready[SPELLING_SCHEDULER_N_PRIORITIES];
+  guint         max_running;
+  guint         n_running;
+  guint         n_running_background;
+};
+
+G_DEFINE_FINAL_TYPE (SpellingScheduler, spelling_scheduler, G_TYPE_OBJECT)
+
+static void
+spelling_scheduler_entry_free (SpellingSchedulerEntry *entry)
+{
+  g_clear_object (&entry->task);
+  g_free (entry);
+}
+
+static void
+spelling_scheduler_client_free (SpellingSchedulerClient *client)
+{
+  g_assert (client->pending.length == 0);
+  g_assert (!client->queued);
+
+  g_free (client);
+}
+
+static SpellingSchedulerClient *
+spelling_scheduler_get_client_locked (SpellingScheduler *self,
+                                      gconstpointer      owner)
+{
+  SpellingSchedulerClient *client;
+
+  if (!(client = g_hash_table_lookup (self->clients, owner)))
+    {
+      client = g_new0 (SpellingSchedulerClient, 1);
+      client->owner = owner;
+      client->ready_link.data = client;
+      client->priority = SPELLING_SCHEDULER_PRIORITY_VISIBLE;
+      g_hash_table_insert (self->clients, (gpointer)owner, client);
+    }
+
+  return client;
+}
+
+static void
+spelling_scheduler_dispatch_locked (SpellingScheduler *self)
+{
+  while (self->n_running < self->max_running)
+    {
+      SpellingSchedulerClient *client = NULL;
+      SpellingSchedulerEntry *entry;
+
+      for (guint p = 0; p < SPELLING_SCHEDULER_PRIORITY_BACKGROUND; p++)
+        {
+          if ((client = g_queue_peek_head (&self->ready[p])))
+            break;
+        }
+
+      if (client == NULL)
+        {
+          if (self->n_running_background >= MAX_RUNNING_BACKGROUND)
+            break;
+
+          if (!(client = g_queue_peek_head (&self->ready[SPELLING_SCHEDULER_PRIORITY_BACKGROUND])))
+            break;
+        }
+
+      /* Move the owner to the back of its queue so that everyone with
+       * the same priority gets a turn before it runs again.
+       */
+      g_queue_unlink (&self->ready[client->priority], &client->ready_link);
+      entry = g_queue_pop_head (&client->pending);
+
+      if (client->pending.length > 0)
+        g_queue_push_tail_link (&self->ready[client->priority], &client->ready_link);
+      else
+        client->queued = FALSE;
+
+      entry->background = client->priority == SPELLING_SCHEDULER_PRIORITY_BACKGROUND;
+
+      self->n_running++;
+      if (entry->background)
+        self->n_running_background++;
+
+      g_thread_pool_push (self->pool, entry, NULL);
+    }
+}
+
+static void
+spelling_scheduler_worker (gpointer data,
+                           gpointer user_data)
+{
+  SpellingSchedulerEntry *entry = data;
+  SpellingScheduler *self = user_data;
+  GTask *task = entry->task;
+
+  g_assert (SPELLING_IS_SCHEDULER (self));
+  g_assert (G_IS_TASK (task));
+
+  entry->thread_func (task,
+                      g_task_get_source_object (task),
+                      g_task_get_task_data (task),
+                      g_task_get_cancellable (task));
+
+  g_mutex_lock (&self->mutex);
+  self->n_running--;
+  if (entry->background)
+    self->n_running_background--;
+  spelling_scheduler_dispatch_locked (self);
+  g_mutex_unlock (&self->mutex);
+
+  spelling_scheduler_entry_free (entry);
+}
+
+static void
+spelling_scheduler_finalize (GObject *object)
+{
+  SpellingScheduler *self = (SpellingScheduler *)object;
+
+  g_thread_pool_free (self->pool, FALSE, TRUE);
+  g_clear_pointer (&self->clients, g_hash_table_unref);
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (spelling_scheduler_parent_class)->finalize (object);
+}
+
+static void
+spelling_scheduler_class_init (SpellingSchedulerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = spelling_scheduler_finalize;
+}
+
+static void
+spelling_scheduler_init (SpellingScheduler *self)
+{
+  g_mutex_init (&self->mutex);
+
+  self->clients = g_hash_table_new_full (NULL, NULL, NULL,
+                                         (GDestroyNotify)spelling_scheduler_client_free);
+
+  for (guint p = 0; p < SPELLING_SCHEDULER_N_PRIORITIES; p++)
+    g_queue_init (&self->ready[p]);
+}
+
+SpellingScheduler *
+spelling_scheduler_new (guint max_running)
+{
+  SpellingScheduler *self;
+
+  g_return_val_if_fail (max_running > 0, NULL);
+
+  self = g_object_new (SPELLING_TYPE_SCHEDULER, NULL);
+  self->max_running = max_running;
+  self->pool = g_thread_pool_new (spelling_scheduler_worker,
+                                  self, max_running, FALSE, NULL);
+
+  return self;
+}
+
+/* Returns the scheduler shared by every engine in the process */
+SpellingScheduler *
+spelling_scheduler_get_default (void)
+{
+  static SpellingScheduler *instance;
+
+  if (g_once_init_enter (&instance))
+    {
+      guint max_running = CLAMP (g_get_num_processors () / 2, 1, MAX_RUNNING);
+
+      g_once_init_leave (&instance, spelling_scheduler_new (max_running));
+    }
+
+  return instance;
+}
+
+SpellingSchedulerPriority
+spelling_scheduler_get_priority (SpellingScheduler *self,
+                                 gconstpointer      owner)
+{
+  SpellingSchedulerClient *client;
+  SpellingSchedulerPriority ret = SPELLING_SCHEDULER_PRIORITY_VISIBLE;
+
+  g_return_val_if_fail (SPELLING_IS_SCHEDULER (self), ret);
+
+  g_mutex_lock (&self->mutex);
+  if ((client = g_hash_table_lookup (self->clients, owner)))
+    ret = client->priority;
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+/* Sets the priority of work queued by @owner, now and in the future.
+ * Owners are visible until told otherwise.
+ */
+void
+spelling_scheduler_set_priority (SpellingScheduler         *self,
+                                 gconstpointer              owner,
+                                 SpellingSchedulerPriority  priority)
+{
+  SpellingSchedulerClient *client;
+
+  g_return_if_fail (SPELLING_IS_SCHEDULER (self));
+  g_return_if_fail (priority < SPELLING_SCHEDULER_N_PRIORITIES);
+
+  g_mutex_lock (&self->mutex);
+
+  client = spelling_scheduler_get_client_locked (self, owner);
+
+  if (client->priority != priority)
+    {
+      SPELLING_PROFILER_LOG ("Scheduler owner %p priority %u -> %u",
+                             owner, client->priority, priority);
+
+      if (client->queued)
+        {
+          g_queue_unlink (&self->ready[client->priority], &client->ready_link);
+          g_queue_push_tail_link (&self->ready[priority], &client->ready_link);
+        }
+
+      client->priority = priority;
+
+      spelling_scheduler_dispatch_locked (self);
+    }
+
+  g_mutex_unlock (&self->mutex);
+}
+
+/* Queues @task to have @thread_func called on the scheduler's pool, the
+ * same way g_task_run_in_thread() would.
+ */
+void
+spelling_scheduler_push (SpellingScheduler *self,
+                         gconstpointer      owner,
+                         GTask             *task,
+                         GTaskThreadFunc    thread_func)
+{
+  SpellingSchedulerClient *client;
+  SpellingSchedulerEntry *entry;
+
+  g_return_if_fail (SPELLING_IS_SCHEDULER (self));
+  g_return_if_fail (G_IS_TASK (task));
+  g_return_if_fail (thread_func != NULL);
+
+  entry = g_new0 (SpellingSchedulerEntry, 1);
+  entry->task = g_object_ref (task);
+  entry->thread_func = thread_func;
+
+  g_mutex_lock (&self->mutex);
+
+  client = spelling_scheduler_get_client_locked (self, owner);
+  g_queue_push_tail (&client->pending, entry);
+
+  if (!client->queued)
+    {
+      g_queue_push_tail_link (&self->ready[client->priority], &client->ready_link);
+      client->queued = TRUE;
+    }
+
+  spelling_scheduler_dispatch_locked (self);
+
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+spelling_scheduler_steal_locked (SpellingScheduler       *self,
+                                 SpellingSchedulerClient *client,
+                                 GQueue                  *stolen)
+{
+  *stolen = client->pending;
+  g_queue_init (&client->pending);
+
+  if (client->queued)
+    {
+      g_queue_unlink (&self->ready[client->priority], &client->ready_link);
+      client->queued = FALSE;
+    }
+}
+
+static void
+spelling_scheduler_return_cancelled (GQueue *stolen)
+{
+  SpellingSchedulerEntry *entry;
+
+  while ((entry = g_queue_pop_head (stolen)))
+    {
+      g_task_return_new_error (entry->task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_CANCELLED,
+                               "The operation was cancelled");
+      spelling_scheduler_entry_free (entry);
+    }
+}
+
+/* Drops work of @owner that did not start yet. The tasks complete with
+ * %G_IO_ERROR_CANCELLED. Work that is already running is not affected.
+ */
+void
+spelling_scheduler_cancel (SpellingScheduler *self,
+                           gconstpointer      owner)
+{
+  SpellingSchedulerClient *client;
+  GQueue stolen = G_QUEUE_INIT;
+
+  g_return_if_fail (SPELLING_IS_SCHEDULER (self));
+
+  g_mutex_lock (&self->mutex);
+  if ((client = g_hash_table_lookup (self->clients, owner)))
+    spelling_scheduler_steal_locked (self, client, &stolen);
+  g_mutex_unlock (&self->mutex);
+
+  spelling_scheduler_return_cancelled (&stolen);
+}
+
+/* Like spelling_scheduler_cancel() but also forgets the priority of
+ * @owner, which must be called before @owner is freed.
+ */
+void
+spelling_scheduler_forget (SpellingScheduler *self,
+                           gconstpointer      owner)
+{
+  SpellingSchedulerClient *client;
+  GQueue stolen = G_QUEUE_INIT;
+
+  g_return_if_fail (SPELLING_IS_SCHEDULER (self));
+
+  g_mutex_lock (&self->mutex);
+  if ((client = g_hash_table_lookup (self->clients, owner)))
+    {
+      spelling_scheduler_steal_locked (self, client, &stolen);
+      g_hash_table_remove (self->clients, owner);
+    }
+  g_mutex_unlock (&self->mutex);
+
+  spelling_scheduler_return_cancelled (&stolen);
+}
@@ -0,0 +1,70 @@
+/* spelling-stats-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "spelling-stats.h"
+
+G_BEGIN_DECLS
+
+/* Latencies are counted in buckets of a quarter of a power of two
+ * microseconds, which keeps percentiles within 25% of the real value
+ * for anything from a microsecond to over an hour.
+ */
+#define SPELLING_HISTOGRAM_N_BUCKETS 124
+
+typedef struct _SpellingHistogram
+{
+  guint buckets[SPELLING_HISTOGRAM_N_BUCKETS];
+} SpellingHistogram;
+
+/* Counters are shared by an engine and its jobs, which update them from
+ * worker threads, so every field is only ever touched atomically. The
+ * 64-bit totals cannot be on every platform and use @mutex instead.
+ */
+typedef struct _SpellingCounters
+{
+  guint             words_checked;
+  guint             unique_words;
+  guint             dictionary_calls;
+  guint             cache_hits;
+  guint             jobs_run;
+  guint             discarded_fragments;
+  GMutex            mutex;
+  guint64           bytes_copied;
+  guint64           job_time;
+  SpellingHistogram job_latency;
+  SpellingHistogram apply_latency;
+} SpellingCounters;
+
+SpellingCounters *spelling_counters_new      (void);
+SpellingCounters *spelling_counters_ref      (SpellingCounters        *self);
+void              spelling_counters_unref    (SpellingCounters        *self);
+void              spelling_counters_add      (SpellingCounters        *self,
+                                              guint64                 *counter,
+                                              guint64                  value);
+void              spelling_histogram_record  (SpellingHistogram       *self,
+                                              gint64                   usec);
+SpellingStats    *_spelling_stats_new        (const SpellingCounters  *counters,
+                                              guint                    queue_depth);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (SpellingCounters, spelling_counters_unref)
+
+G_END_DECLS
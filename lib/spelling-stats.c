@@ -0,0 +1,402 @@
+/* spelling-stats.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "spelling-stats-private.h"
+
+/**
+ * SpellingStats:
+ *
+ * A snapshot of what spellchecking a buffer has cost so far.
+ *
+ * Counters start at zero when the [class@Spelling.TextBufferAdapter] is
+ * created and only ever grow, so that they can be sampled periodically
+ * and reported as differences between samples. Latencies are tracked
+ * as histograms from which percentiles are computed.
+ */
+struct _SpellingStats
+{
+  SpellingCounters counters;
+  guint            queue_depth;
+};
+
+G_DEFINE_BOXED_TYPE (SpellingStats, spelling_stats, spelling_stats_ref, spelling_stats_unref)
+
+SpellingCounters *
+spelling_counters_new (void)
+{
+  SpellingCounters *self = g_atomic_rc_box_new0 (SpellingCounters);
+
+  g_mutex_init (&self->mutex);
+
+  return self;
+}
+
+static void
+spelling_counters_clear (gpointer data)
+{
+  SpellingCounters *self = data;
+
+  g_mutex_clear (&self->mutex);
+}
+
+SpellingCounters *
+spelling_counters_ref (SpellingCounters *self)
+{
+  return g_atomic_rc_box_acquire (self);
+}
+
+void
+spelling_counters_unref (SpellingCounters *self)
+{
+  g_atomic_rc_box_release_full (self, spelling_counters_clear);
+}
+
+/* Adds @value to @counter, one of the 64-bit totals of @self */
+void
+spelling_counters_add (SpellingCounters *self,
+                       guint64          *counter,
+                       guint64           value)
+{
+  g_mutex_lock (&self->mutex);
+  *counter += value;
+  g_mutex_unlock (&self->mutex);
+}
+
+static guint
+spelling_histogram_get_bucket (guint64 usec)
+{
+  guint log;
+
+  if (usec < 4)
+    return usec;
+
+  usec = MIN (usec, G_MAXUINT32);
+  log = g_bit_storage (usec) - 1;
+
+  return (log - 1) * 4 + ((usec >> (log - 2)) & 3);
+}
+
+/* Returns the largest value counted in @bucket */
+static gint64
+spelling_histogram_get_bucket_max (guint bucket)
+{
+  guint log;
+  guint64 width;
+
+  if (bucket < 4)
+    return bucket;
+
+  log = bucket / 4 + 1;
+  width = G_GUINT64_CONSTANT (1) << (log - 2);
+
+  return (4 + bucket % 4) * width + width - 1;
+}
+
+void
+spelling_histogram_record (SpellingHistogram *self,
+                           gint64             usec)
+{
+  g_atomic_int_inc (&self->buckets[spelling_histogram_get_bucket (MAX (usec, 0))]);
+}
+
+static gint64
+spelling_histogram_get_percentile (const SpellingHistogram *self,
+                                   double                   percentile)
+{
+  guint64 total = 0;
+  guint64 rank;
+  guint64 seen = 0;
+
+  for (guint i = 0; i < SPELLING_HISTOGRAM_N_BUCKETS; i++)
+    total += self->buckets[i];
+
+  if (total == 0)
+    return 0;
+
+  /* Rounded up, in hundredths of a percent to stay in integers */
+  rank = (total * (guint64)(CLAMP (percentile, 0, 100) * 100) + 9999) / 10000;
+  rank = MAX (1, rank);
+
+  for (guint i = 0; i < SPELLING_HISTOGRAM_N_BUCKETS; i++)
+    {
+      seen += self->buckets[i];
+
+      if (seen >= rank)
+        return spelling_histogram_get_bucket_max (i);
+    }
+
+  g_assert_not_reached ();
+}
+
+static void
+spelling_histogram_copy (SpellingHistogram       *dest,
+                         const SpellingHistogram *src)
+{
+  for (guint i = 0; i < SPELLING_HISTOGRAM_N_BUCKETS; i++)
+    dest->buckets[i] = g_atomic_int_get (&src->buckets[i]);
+}
+
+SpellingStats *
+_spelling_stats_new (const SpellingCounters *counters,
+                     guint                   queue_depth)
+{
+  SpellingStats *self;
+
+  g_return_val_if_fail (counters != NULL, NULL);
+
+  self = g_atomic_rc_box_new0 (SpellingStats);
+  self->counters.words_checked = g_atomic_int_get (&counters->words_checked);
+  self->counters.unique_words = g_atomic_int_get (&counters->unique_words);
+  self->counters.dictionary_calls = g_atomic_int_get (&counters->dictionary_calls);
+  self->counters.cache_hits = g_atomic_int_get (&counters->cache_hits);
+  self->counters.jobs_run = g_atomic_int_get (&counters->jobs_run);
+  self->counters.discarded_fragments = g_atomic_int_get (&counters->discarded_fragments);
+  g_mutex_lock ((GMutex *)&counters->mutex);
+  self->counters.bytes_copied = counters->bytes_copied;
+  self->counters.job_time = counters->job_time;
+  g_mutex_unlock ((GMutex *)&counters->mutex);
+  spelling_histogram_copy (&self->counters.job_latency, &counters->job_latency);
+  spelling_histogram_copy (&self->counters.apply_latency, &counters->apply_latency);
+  self->queue_depth = queue_depth;
+
+  return self;
+}
+
+/**
+ * spelling_stats_ref:
+ * @self: a `SpellingStats`
+ *
+ * Increments the reference count of @self.
+ *
+ * Returns: (transfer full): @self
+ */
+SpellingStats *
+spelling_stats_ref (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return g_atomic_rc_box_acquire (self);
+}
+
+/**
+ * spelling_stats_unref:
+ * @self: a `SpellingStats`
+ *
+ * Decrements the reference count of @self.
+ */
+void
+spelling_stats_unref (SpellingStats *self)
+{
+  g_return_if_fail (self != NULL);
+
+  g_atomic_rc_box_release (self);
+}
+
+/**
+ * spelling_stats_get_words_checked:
+ * @self: a `SpellingStats`
+ *
+ * Gets the number of words that were checked, counting every
+ * occurrence of a word.
+ *
+ * Returns: the number of words checked
+ */
+guint
+spelling_stats_get_words_checked (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->counters.words_checked;
+}
+
+/**
+ * spelling_stats_get_unique_words:
+ * @self: a `SpellingStats`
+ *
+ * Gets the number of distinct words that were checked. Words are
+ * distinct within a single job, so a word checked by two jobs is
+ * counted twice.
+ *
+ * Returns: the number of distinct words checked
+ */
+guint
+spelling_stats_get_unique_words (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->counters.unique_words;
+}
+
+/**
+ * spelling_stats_get_dictionary_calls:
+ * @self: a `SpellingStats`
+ *
+ * Gets the number of words which had to be looked up by the
+ * dictionary provider because they were not in its cache.
+ *
+ * Returns: the number of words looked up by the provider
+ */
+guint
+spelling_stats_get_dictionary_calls (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->counters.dictionary_calls;
+}
+
+/**
+ * spelling_stats_get_cache_hits:
+ * @self: a `SpellingStats`
+ *
+ * Gets the number of words which were found in the cache of the
+ * dictionary.
+ *
+ * Returns: the number of cache hits
+ */
+guint
+spelling_stats_get_cache_hits (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->counters.cache_hits;
+}
+
+/**
+ * spelling_stats_get_jobs_run:
+ * @self: a `SpellingStats`
+ *
+ * Gets the number of jobs which were run on a worker thread.
+ *
+ * Returns: the number of jobs run
+ */
+guint
+spelling_stats_get_jobs_run (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->counters.jobs_run;
+}
+
+/**
+ * spelling_stats_get_discarded_fragments:
+ * @self: a `SpellingStats`
+ *
+ * Gets the number of fragments whose results were thrown away because
+ * the text was edited while they were being checked.
+ *
+ * Returns: the number of discarded fragments
+ */
+guint
+spelling_stats_get_discarded_fragments (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->counters.discarded_fragments;
+}
+
+/**
+ * spelling_stats_get_queue_depth:
+ * @self: a `SpellingStats`
+ *
+ * Gets the number of jobs in flight plus the number of results waiting
+ * to be applied when the snapshot was taken.
+ *
+ * Returns: the queue depth
+ */
+guint
+spelling_stats_get_queue_depth (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->queue_depth;
+}
+
+/**
+ * spelling_stats_get_bytes_copied:
+ * @self: a `SpellingStats`
+ *
+ * Gets the number of bytes of text copied out of the buffer to be
+ * checked.
+ *
+ * Returns: the number of bytes copied
+ */
+guint64
+spelling_stats_get_bytes_copied (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->counters.bytes_copied;
+}
+
+/**
+ * spelling_stats_get_job_time:
+ * @self: a `SpellingStats`
+ *
+ * Gets the time spent checking jobs on worker threads, in total.
+ *
+ * Returns: the time in microseconds
+ */
+gint64
+spelling_stats_get_job_time (SpellingStats *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->counters.job_time;
+}
+
+/**
+ * spelling_stats_get_job_latency:
+ * @self: a `SpellingStats`
+ * @percentile: the percentile, from 0 to 100
+ *
+ * Gets how long it took to check jobs on a worker thread, such as the
+ * median with a @percentile of 50.
+ *
+ * Returns: the latency in microseconds, or 0 if no job was run
+ */
+gint64
+spelling_stats_get_job_latency (SpellingStats *self,
+                                double         percentile)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return spelling_histogram_get_percentile (&self->counters.job_latency, percentile);
+}
+
+/**
+ * spelling_stats_get_apply_latency:
+ * @self: a `SpellingStats`
+ * @percentile: the percentile, from 0 to 100
+ *
+ * Gets how long it took to apply results to the buffer, measured per
+ * slice of results applied within a frame.
+ *
+ * Returns: the latency in microseconds, or 0 if nothing was applied
+ */
+gint64
+spelling_stats_get_apply_latency (SpellingStats *self,
+                                  double         percentile)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return spelling_histogram_get_percentile (&self->counters.apply_latency, percentile);
+}
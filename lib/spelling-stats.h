@@ -0,0 +1,70 @@
+/* spelling-stats.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#if !defined(LIBSPELLING_INSIDE) && !defined(LIBSPELLING_COMPILATION)
+# error "Only <libspelling.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include "spelling-version-macros.h"
+
+G_BEGIN_DECLS
+
+#define SPELLING_TYPE_STATS (spelling_stats_get_type())
+
+typedef struct _SpellingStats SpellingStats;
+
+SPELLING_AVAILABLE_IN_ALL
+GType          spelling_stats_get_type                (void) G_GNUC_CONST;
+SPELLING_AVAILABLE_IN_ALL
+SpellingStats *spelling_stats_ref                     (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+void           spelling_stats_unref                   (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+guint          spelling_stats_get_words_checked       (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+guint          spelling_stats_get_unique_words        (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+guint          spelling_stats_get_dictionary_calls    (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+guint          spelling_stats_get_cache_hits          (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+guint          spelling_stats_get_jobs_run            (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+guint          spelling_stats_get_discarded_fragments (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+guint          spelling_stats_get_queue_depth         (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+guint64        spelling_stats_get_bytes_copied        (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+gint64         spelling_stats_get_job_time            (SpellingStats *self);
+SPELLING_AVAILABLE_IN_ALL
+gint64         spelling_stats_get_job_latency         (SpellingStats *self,
+                                                       double         percentile);
+SPELLING_AVAILABLE_IN_ALL
+gint64         spelling_stats_get_apply_latency       (SpellingStats *self,
+                                                       double         percentile);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (SpellingStats, spelling_stats_unref)
+
+G_END_DECLS
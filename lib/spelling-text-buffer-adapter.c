@@ -26,6 +26,8 @@
 #include "spelling-compat-private.h"
 #include "spelling-checker-private.h"
 #include "spelling-cursor-private.h"
+#include "spelling-dictionary-internal.h"
+#include "spelling-edit-trace-private.h"
 #include "spelling-engine-private.h"
 #include "spelling-menu-private.h"
 #include "spelling-text-buffer-adapter.h"
@@ -37,6 +39,11 @@
  *
  * `SpellingTextBufferAdapter` implements helpers to easily add spellchecking
  * capabilities to a `GtkSourceBuffer`.
+ *
+ * When the `LIBSPELLING_EDIT_TRACE_DIR` environment variable is set, every
+ * adapter records the edits and cursor movements of its buffer to a file in
+ * that directory, to be replayed with `spelling-replay`. Such traces contain
+ * the text of the buffer.
  */
 
 #define INVALIDATE_DELAY_MSECS 100
@@ -44,28 +51,33 @@
 
 struct _SpellingTextBufferAdapter
 {
-  GObject          parent_instance;
-
-  SpellingEngine  *engine;
-  GSignalGroup    *buffer_signals;
-  GWeakRef         buffer_wr;
-  SpellingChecker *checker;
-  GtkTextTag      *no_spell_check_tag;
-  GMenuModel      *menu;
-  GMenu           *top_menu;
-  char            *word_under_cursor;
+  GObject                  parent_instance;
+
+  SpellingEngine          *engine;
+  GSignalGroup            *buffer_signals;
+  GWeakRef                 buffer_wr;
+  GWeakRef                 view_wr;
+  GSignalGroup            *view_signals;
+  GSignalGroup            *vadjustment_signals;
+  SpellingChecker         *checker;
+  GtkTextTag              *no_spell_check_tag;
+  GMenuModel              *menu;
+  GMenu                   *top_menu;
+  char                    *word_under_cursor;
+  SpellingEditTraceWriter *trace;
 
   /* Borrowed pointers */
-  GtkTextMark     *insert_mark;
-  GtkTextTag      *tag;
+  GtkTextMark             *insert_mark;
+  GtkTextTag              *tag;
 
-  guint            commit_handler;
+  guint                    commit_handler;
 
-  guint            cursor_position;
-  guint            incoming_cursor_position;
-  guint            queued_cursor_moved;
+  guint                    cursor_position;
+  guint                    incoming_cursor_position;
+  guint                    queued_cursor_moved;
 
-  guint            enabled : 1;
+  guint                    enabled : 1;
+  guint                    use_cache : 1;
 };
 
 static void spelling_add_action      (SpellingTextBufferAdapter *self,
@@ -96,11 +108,46 @@ enum {
   PROP_CHECKER,
   PROP_ENABLED,
   PROP_LANGUAGE,
+  PROP_USE_CACHE,
+  PROP_VIEW,
   N_PROPS
 };
 
 static GParamSpec *properties[N_PROPS];
 
+static inline const SpellingCharSet *
+get_extra_word_chars (SpellingTextBufferAdapter *self)
+{
+  SpellingDictionary *dictionary;
+
+  if (self->checker == NULL ||
+      !(dictionary = _spelling_checker_get_dictionary (self->checker)))
+    return NULL;
+
+  return _spelling_dictionary_get_extra_word_char_set (dictionary);
+}
+
+/* Records the text inserted at @position, which must be in the buffer */
+static void
+spelling_text_buffer_adapter_trace_insert (SpellingTextBufferAdapter *self,
+                                           GtkTextBuffer             *buffer,
+                                           guint                      position,
+                                           guint                      length)
+{
+  g_autofree char *text = NULL;
+  GtkTextIter begin, end;
+
+  g_assert (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+  g_assert (self->trace != NULL);
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &begin, position);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, position + length);
+  text = gtk_text_buffer_get_slice (buffer, &begin, &end, TRUE);
+
+  spelling_edit_trace_writer_insert (self->trace, position, text);
+}
+
 static void
 spelling_text_buffer_adapter_commit_notify (GtkTextBuffer            *buffer,
                                             GtkTextBufferNotifyFlags  flags,
@@ -113,6 +160,14 @@ spelling_text_buffer_adapter_commit_notify (GtkTextBuffer            *buffer,
   g_assert (GTK_IS_TEXT_BUFFER (buffer));
   g_assert (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
 
+  if G_UNLIKELY (self->trace != NULL)
+    {
+      if (flags == GTK_TEXT_BUFFER_NOTIFY_AFTER_INSERT)
+        spelling_text_buffer_adapter_trace_insert (self, buffer, position, length);
+      else if (flags == GTK_TEXT_BUFFER_NOTIFY_BEFORE_DELETE)
+        spelling_edit_trace_writer_delete (self->trace, position, length);
+    }
+
   if (flags == GTK_TEXT_BUFFER_NOTIFY_BEFORE_INSERT)
     spelling_engine_before_insert_text (self->engine, position, length);
   else if (flags == GTK_TEXT_BUFFER_NOTIFY_AFTER_INSERT)
@@ -175,7 +230,7 @@ spelling_text_buffer_adapter_copy_text (gpointer instance,
   return gtk_text_iter_get_slice (&begin, &end);
 }
 
-static void
+static gboolean
 spelling_text_buffer_adapter_apply_tag (gpointer instance,
                                         guint    position,
                                         guint    length)
@@ -186,7 +241,7 @@ spelling_text_buffer_adapter_apply_tag (gpointer instance,
   GtkTextIter end;
 
   if (self->tag == NULL)
-    return;
+    return FALSE;
 
   /* If the position overlaps our cursor position, ignore it. We don't
    * want to show that to the user while they are typing and will
@@ -194,14 +249,16 @@ spelling_text_buffer_adapter_apply_tag (gpointer instance,
    */
   if (position <= self->cursor_position &&
       position + length >= self->cursor_position)
-    return;
+    return FALSE;
 
   if (!(buffer = g_weak_ref_get (&self->buffer_wr)))
-    return;
+    return FALSE;
 
   gtk_text_buffer_get_iter_at_offset (buffer, &begin, position);
   gtk_text_buffer_get_iter_at_offset (buffer, &end, position + length);
   gtk_text_buffer_apply_tag (buffer, self->tag, &begin, &end);
+
+  return TRUE;
 }
 
 static void
@@ -231,13 +288,10 @@ spelling_text_buffer_adapter_backward_word_start (gpointer  instance,
 {
   SpellingTextBufferAdapter *self = instance;
   g_autoptr(GtkTextBuffer) buffer = NULL;
-  const char *extra_word_chars = NULL;
+  const SpellingCharSet *extra_word_chars = get_extra_word_chars (self);
   GtkTextIter iter;
   guint prev = *position;
 
-  if (self->checker != NULL)
-    extra_word_chars = spelling_checker_get_extra_word_chars (self->checker);
-
   if (!(buffer = g_weak_ref_get (&self->buffer_wr)))
     return FALSE;
 
@@ -256,13 +310,10 @@ spelling_text_buffer_adapter_forward_word_end (gpointer  instance,
 {
   SpellingTextBufferAdapter *self = instance;
   g_autoptr(GtkTextBuffer) buffer = NULL;
-  const char *extra_word_chars = NULL;
+  const SpellingCharSet *extra_word_chars = get_extra_word_chars (self);
   GtkTextIter iter;
   guint prev = *position;
 
-  if (self->checker != NULL)
-    extra_word_chars = spelling_checker_get_extra_word_chars (self->checker);
-
   if (!(buffer = g_weak_ref_get (&self->buffer_wr)))
     return FALSE;
 
@@ -360,6 +411,62 @@ spelling_text_buffer_adapter_intersect_spellcheck_region (gpointer   instance,
     }
 }
 
+static gboolean
+spelling_text_buffer_adapter_get_visible_range (gpointer  instance,
+                                                guint    *begin,
+                                                guint    *end)
+{
+  SpellingTextBufferAdapter *self = instance;
+  g_autoptr(GtkTextBuffer) buffer = NULL;
+  g_autoptr(GtkTextView) view = NULL;
+  GdkRectangle visible;
+  GtkTextIter begin_iter;
+  GtkTextIter end_iter;
+
+  g_assert (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+
+  if (!(buffer = g_weak_ref_get (&self->buffer_wr)) ||
+      !(view = g_weak_ref_get (&self->view_wr)) ||
+      gtk_text_view_get_buffer (view) != buffer)
+    return FALSE;
+
+  gtk_text_view_get_visible_rect (view, &visible);
+
+  if (visible.width <= 0 || visible.height <= 0)
+    return FALSE;
+
+  gtk_text_view_get_iter_at_location (view, &begin_iter, visible.x, visible.y);
+  gtk_text_view_get_iter_at_location (view, &end_iter,
+                                      visible.x + visible.width,
+                                      visible.y + visible.height);
+
+  /* Whole lines so partially shown lines at the edges are included */
+  gtk_text_iter_set_line_offset (&begin_iter, 0);
+  if (!gtk_text_iter_ends_line (&end_iter))
+    gtk_text_iter_forward_to_line_end (&end_iter);
+
+  *begin = gtk_text_iter_get_offset (&begin_iter);
+  *end = gtk_text_iter_get_offset (&end_iter);
+
+  return TRUE;
+}
+
+static GdkFrameClock *
+spelling_text_buffer_adapter_get_frame_clock (gpointer instance)
+{
+  SpellingTextBufferAdapter *self = instance;
+  g_autoptr(GtkTextView) view = NULL;
+
+  g_assert (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+
+  /* Unmapped views do not get frames, results are applied when idle */
+  if (!(view = g_weak_ref_get (&self->view_wr)) ||
+      !gtk_widget_get_mapped (GTK_WIDGET (view)))
+    return NULL;
+
+  return gtk_widget_get_frame_clock (GTK_WIDGET (view));
+}
+
 static const SpellingAdapter adapter_funcs = {
   .check_enabled = spelling_text_buffer_adapter_check_enabled,
   .get_cursor = spelling_text_buffer_adapter_get_cursor,
@@ -371,30 +478,22 @@ static const SpellingAdapter adapter_funcs = {
   .get_language = spelling_text_buffer_adapter_get_pango_language,
   .get_dictionary = spelling_text_buffer_adapter_get_dictionary,
   .intersect_spellcheck_region = spelling_text_buffer_adapter_intersect_spellcheck_region,
+  .get_visible_range = spelling_text_buffer_adapter_get_visible_range,
+  .get_frame_clock = spelling_text_buffer_adapter_get_frame_clock,
 };
 
 static inline gboolean
 forward_word_end (SpellingTextBufferAdapter *self,
                   GtkTextIter               *iter)
 {
-  const char *extra_word_chars = NULL;
-
-  if (self->checker != NULL)
-    extra_word_chars = spelling_checker_get_extra_word_chars (self->checker);
-
-  return spelling_iter_forward_word_end (iter, extra_word_chars);
+  return spelling_iter_forward_word_end (iter, get_extra_word_chars (self));
 }
 
 static inline gboolean
 backward_word_start (SpellingTextBufferAdapter *self,
                      GtkTextIter               *iter)
 {
-  const char *extra_word_chars = NULL;
-
-  if (self->checker != NULL)
-    extra_word_chars = spelling_checker_get_extra_word_chars (self->checker);
-
-  return spelling_iter_backward_word_start (iter, extra_word_chars);
+  return spelling_iter_backward_word_start (iter, get_extra_word_chars (self));
 }
 
 static gboolean
@@ -597,10 +696,17 @@ spelling_text_buffer_adapter_set_buffer (SpellingTextBufferAdapter *self,
   offset = gtk_text_iter_get_offset (&begin);
   length = gtk_text_iter_get_offset (&end) - offset;
 
+  /* Edits are recorded when LIBSPELLING_EDIT_TRACE_DIR is set, starting
+   * with what the buffer already contains.
+   */
+  if ((self->trace = spelling_edit_trace_writer_new_from_env ()) && length > 0)
+    spelling_text_buffer_adapter_trace_insert (self, GTK_TEXT_BUFFER (buffer), offset, length);
+
   if (length > 0)
     {
       spelling_engine_before_insert_text (self->engine, offset, length);
       spelling_engine_after_insert_text (self->engine, offset, length);
+      spelling_engine_restore (self->engine);
     }
 
   self->tag = gtk_text_buffer_create_tag (GTK_TEXT_BUFFER (buffer), NULL,
@@ -724,6 +830,7 @@ spelling_text_buffer_adapter_set_enabled (SpellingTextBufferAdapter *self,
 
       g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_ENABLED]);
       spelling_engine_invalidate_all (self->engine);
+      spelling_engine_restore (self->engine);
     }
 }
 
@@ -777,6 +884,9 @@ spelling_text_buffer_adapter_cursor_moved (SpellingTextBufferAdapter *self,
   self->incoming_cursor_position = gtk_text_iter_get_offset (&iter);
   g_clear_handle_id (&self->queued_cursor_moved, g_source_remove);
 
+  if G_UNLIKELY (self->trace != NULL)
+    spelling_edit_trace_writer_cursor (self->trace, self->incoming_cursor_position);
+
   if (!spelling_text_buffer_adapter_check_enabled (self))
     return;
 
@@ -796,7 +906,65 @@ spelling_text_buffer_adapter_notify_loading_cb (SpellingTextBufferAdapter *self,
   g_assert (GTK_SOURCE_IS_BUFFER (buffer));
 
   if (self->engine != NULL)
-    spelling_engine_invalidate_all (self->engine);
+    {
+      spelling_engine_invalidate_all (self->engine);
+      spelling_engine_restore (self->engine);
+    }
+}
+
+static void
+spelling_text_buffer_adapter_visible_range_changed_cb (SpellingTextBufferAdapter *self)
+{
+  g_assert (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+
+  if (self->engine != NULL)
+    spelling_engine_visible_range_changed (self->engine);
+}
+
+static void
+spelling_text_buffer_adapter_update_priority (SpellingTextBufferAdapter *self)
+{
+  g_autoptr(GtkTextView) view = NULL;
+  SpellingSchedulerPriority priority;
+
+  g_assert (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+
+  if (self->engine == NULL)
+    return;
+
+  /* Without a view we cannot tell, so treat the buffer as visible */
+  if (!(view = g_weak_ref_get (&self->view_wr)))
+    priority = SPELLING_SCHEDULER_PRIORITY_VISIBLE;
+  else if (gtk_widget_has_focus (GTK_WIDGET (view)))
+    priority = SPELLING_SCHEDULER_PRIORITY_FOCUSED;
+  else if (gtk_widget_get_mapped (GTK_WIDGET (view)))
+    priority = SPELLING_SCHEDULER_PRIORITY_VISIBLE;
+  else
+    priority = SPELLING_SCHEDULER_PRIORITY_BACKGROUND;
+
+  spelling_engine_set_priority (self->engine, priority);
+}
+
+static void
+spelling_text_buffer_adapter_view_state_changed_cb (SpellingTextBufferAdapter *self)
+{
+  g_assert (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+
+  spelling_text_buffer_adapter_update_priority (self);
+  spelling_text_buffer_adapter_visible_range_changed_cb (self);
+}
+
+static void
+spelling_text_buffer_adapter_notify_vadjustment_cb (SpellingTextBufferAdapter *self,
+                                                    GParamSpec                *pspec,
+                                                    GtkTextView               *view)
+{
+  g_assert (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+  g_assert (GTK_IS_TEXT_VIEW (view));
+
+  g_signal_group_set_target (self->vadjustment_signals,
+                             gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view)));
+  spelling_text_buffer_adapter_visible_range_changed_cb (self);
 }
 
 static void
@@ -811,7 +979,10 @@ spelling_text_buffer_adapter_finalize (GObject *object)
   g_clear_object (&self->checker);
   g_clear_object (&self->no_spell_check_tag);
   g_clear_object (&self->buffer_signals);
+  g_clear_object (&self->view_signals);
+  g_clear_object (&self->vadjustment_signals);
   g_weak_ref_clear (&self->buffer_wr);
+  g_weak_ref_clear (&self->view_wr);
 
   G_OBJECT_CLASS (spelling_text_buffer_adapter_parent_class)->finalize (object);
 }
@@ -822,6 +993,10 @@ spelling_text_buffer_adapter_dispose (GObject *object)
   SpellingTextBufferAdapter *self = (SpellingTextBufferAdapter *)object;
   g_autoptr(GtkTextBuffer) buffer = NULL;
 
+  /* Last chance to copy the text for the cache */
+  if (self->engine != NULL)
+    spelling_engine_flush_cache (self->engine);
+
   if ((buffer = g_weak_ref_get (&self->buffer_wr)))
     {
       gtk_text_buffer_remove_commit_notify (buffer, self->commit_handler);
@@ -830,6 +1005,10 @@ spelling_text_buffer_adapter_dispose (GObject *object)
     }
 
   g_signal_group_set_target (self->buffer_signals, NULL);
+  g_signal_group_set_target (self->view_signals, NULL);
+  g_signal_group_set_target (self->vadjustment_signals, NULL);
+  g_weak_ref_set (&self->view_wr, NULL);
+  g_clear_pointer (&self->trace, spelling_edit_trace_writer_free);
   g_clear_object (&self->engine);
   g_clear_object (&self->menu);
   g_clear_object (&self->top_menu);
@@ -863,6 +1042,14 @@ spelling_text_buffer_adapter_get_property (GObject    *object,
       g_value_set_string (value, spelling_text_buffer_adapter_get_language (self));
       break;
 
+    case PROP_USE_CACHE:
+      g_value_set_boolean (value, spelling_text_buffer_adapter_get_use_cache (self));
+      break;
+
+    case PROP_VIEW:
+      g_value_take_object (value, g_weak_ref_get (&self->view_wr));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -894,6 +1081,14 @@ spelling_text_buffer_adapter_set_property (GObject      *object,
       spelling_text_buffer_adapter_set_language (self, g_value_get_string (value));
       break;
 
+    case PROP_USE_CACHE:
+      spelling_text_buffer_adapter_set_use_cache (self, g_value_get_boolean (value));
+      break;
+
+    case PROP_VIEW:
+      spelling_text_buffer_adapter_set_view (self, g_value_get_object (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -949,6 +1144,34 @@ spelling_text_buffer_adapter_class_init (SpellingTextBufferAdapterClass *klass)
                          NULL,
                          (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * SpellingTextBufferAdapter:use-cache:
+   *
+   * Whether to keep the mistakes found in the buffer in a cache below
+   * the user cache directory.
+   *
+   * When the same text is loaded again with the same dictionary, the
+   * cached mistakes are shown right away while the text is checked
+   * again in the background.
+   */
+  properties[PROP_USE_CACHE] =
+    g_param_spec_boolean ("use-cache", NULL, NULL,
+                          FALSE,
+                          (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * SpellingTextBufferAdapter:view:
+   *
+   * The [class@Gtk.TextView] displaying the buffer, if any.
+   *
+   * When set, the part of the buffer that is visible in the view is
+   * checked before the rest of the buffer.
+   */
+  properties[PROP_VIEW] =
+    g_param_spec_object ("view", NULL, NULL,
+                         GTK_TYPE_TEXT_VIEW,
+                         (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_properties (object_class, N_PROPS, properties);
 }
 
@@ -956,6 +1179,7 @@ static void
 spelling_text_buffer_adapter_init (SpellingTextBufferAdapter *self)
 {
   g_weak_ref_init (&self->buffer_wr, NULL);
+  g_weak_ref_init (&self->view_wr, NULL);
 
   self->enabled = TRUE;
   spelling_text_buffer_adapter_set_action_state (self,
@@ -975,6 +1199,42 @@ spelling_text_buffer_adapter_init (SpellingTextBufferAdapter *self)
                                  self,
                                  G_CONNECT_SWAPPED);
 
+  self->view_signals = g_signal_group_new (GTK_TYPE_TEXT_VIEW);
+
+  g_signal_group_connect_object (self->view_signals,
+                                 "notify::vadjustment",
+                                 G_CALLBACK (spelling_text_buffer_adapter_notify_vadjustment_cb),
+                                 self,
+                                 G_CONNECT_SWAPPED);
+  g_signal_group_connect_object (self->view_signals,
+                                 "notify::has-focus",
+                                 G_CALLBACK (spelling_text_buffer_adapter_update_priority),
+                                 self,
+                                 G_CONNECT_SWAPPED);
+  g_signal_group_connect_object (self->view_signals,
+                                 "map",
+                                 G_CALLBACK (spelling_text_buffer_adapter_view_state_changed_cb),
+                                 self,
+                                 G_CONNECT_SWAPPED);
+  g_signal_group_connect_object (self->view_signals,
+                                 "unmap",
+                                 G_CALLBACK (spelling_text_buffer_adapter_update_priority),
+                                 self,
+                                 G_CONNECT_SWAPPED);
+
+  self->vadjustment_signals = g_signal_group_new (GTK_TYPE_ADJUSTMENT);
+
+  g_signal_group_connect_object (self->vadjustment_signals,
+                                 "value-changed",
+                                 G_CALLBACK (spelling_text_buffer_adapter_visible_range_changed_cb),
+                                 self,
+                                 G_CONNECT_SWAPPED);
+  g_signal_group_connect_object (self->vadjustment_signals,
+                                 "changed",
+                                 G_CALLBACK (spelling_text_buffer_adapter_visible_range_changed_cb),
+                                 self,
+                                 G_CONNECT_SWAPPED);
+
   self->engine = spelling_engine_new (&adapter_funcs, G_OBJECT (self));
 }
 
@@ -1049,6 +1309,7 @@ spelling_text_buffer_adapter_set_checker (SpellingTextBufferAdapter *self,
     }
 
   spelling_engine_invalidate_all (self->engine);
+  spelling_engine_restore (self->engine);
 
   spelling_text_buffer_adapter_set_action_state (self, "language", g_variant_new_string (code));
 
@@ -1077,6 +1338,64 @@ spelling_text_buffer_adapter_get_buffer (SpellingTextBufferAdapter *self)
   return GTK_SOURCE_BUFFER (buffer);
 }
 
+/**
+ * spelling_text_buffer_adapter_get_view:
+ * @self: a `SpellingTextBufferAdapter`
+ *
+ * Gets the view used to prioritize checking of visible text.
+ *
+ * Returns: (transfer none) (nullable): a `GtkTextView` or %NULL
+ */
+GtkTextView *
+spelling_text_buffer_adapter_get_view (SpellingTextBufferAdapter *self)
+{
+  g_autoptr(GtkTextView) view = NULL;
+
+  g_return_val_if_fail (SPELLING_IS_TEXT_BUFFER_ADAPTER (self), NULL);
+
+  view = g_weak_ref_get (&self->view_wr);
+
+  /* return borrowed instance only */
+  return view;
+}
+
+/**
+ * spelling_text_buffer_adapter_set_view:
+ * @self: a `SpellingTextBufferAdapter`
+ * @view: (nullable): a `GtkTextView` or %NULL
+ *
+ * Sets the view displaying the buffer.
+ *
+ * Text that is visible in @view, and the text just above and below it,
+ * is checked before the rest of the buffer. Buffers whose view has the
+ * keyboard focus are checked before others, and buffers whose view is
+ * not mapped only get spare capacity. The adapter does not keep @view
+ * alive.
+ */
+void
+spelling_text_buffer_adapter_set_view (SpellingTextBufferAdapter *self,
+                                       GtkTextView               *view)
+{
+  g_autoptr(GtkTextView) old_view = NULL;
+
+  g_return_if_fail (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+  g_return_if_fail (!view || GTK_IS_TEXT_VIEW (view));
+
+  old_view = g_weak_ref_get (&self->view_wr);
+
+  if (old_view == view)
+    return;
+
+  g_weak_ref_set (&self->view_wr, view);
+  g_signal_group_set_target (self->view_signals, view);
+  g_signal_group_set_target (self->vadjustment_signals,
+                             view ? gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view)) : NULL);
+
+  spelling_text_buffer_adapter_view_state_changed_cb (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_VIEW]);
+}
+
 /**
  * spelling_text_buffer_adapter_get_language:
  * @self: a `SpellingTextBufferAdapter`
@@ -1159,6 +1478,71 @@ spelling_text_buffer_adapter_get_enabled (SpellingTextBufferAdapter *self)
   return self->enabled;
 }
 
+/**
+ * spelling_text_buffer_adapter_get_use_cache:
+ * @self: a `SpellingTextBufferAdapter`
+ *
+ * Gets whether mistakes are kept in a cache on disk.
+ *
+ * Returns: %TRUE if the cache is used
+ */
+gboolean
+spelling_text_buffer_adapter_get_use_cache (SpellingTextBufferAdapter *self)
+{
+  g_return_val_if_fail (SPELLING_IS_TEXT_BUFFER_ADAPTER (self), FALSE);
+
+  return self->use_cache;
+}
+
+/**
+ * spelling_text_buffer_adapter_set_use_cache:
+ * @self: a `SpellingTextBufferAdapter`
+ * @use_cache: whether to use the cache
+ *
+ * Sets whether mistakes are kept in a cache on disk so that they can be
+ * shown immediately when the same text is loaded again.
+ *
+ * See [property@Spelling.TextBufferAdapter:use-cache].
+ */
+void
+spelling_text_buffer_adapter_set_use_cache (SpellingTextBufferAdapter *self,
+                                            gboolean                   use_cache)
+{
+  g_return_if_fail (SPELLING_IS_TEXT_BUFFER_ADAPTER (self));
+
+  use_cache = !!use_cache;
+
+  if (use_cache != self->use_cache)
+    {
+      self->use_cache = use_cache;
+      spelling_engine_set_use_cache (self->engine, use_cache);
+      g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_USE_CACHE]);
+    }
+}
+
+/**
+ * spelling_text_buffer_adapter_dup_stats:
+ * @self: a `SpellingTextBufferAdapter`
+ *
+ * Gets a snapshot of what spellchecking the buffer has cost so far.
+ *
+ * Taking a snapshot is cheap, so it may be done periodically to report
+ * the cost of spellchecking in production.
+ *
+ * Returns: (transfer full) (nullable): a `SpellingStats`, or %NULL if
+ *   @self was disposed
+ */
+SpellingStats *
+spelling_text_buffer_adapter_dup_stats (SpellingTextBufferAdapter *self)
+{
+  g_return_val_if_fail (SPELLING_IS_TEXT_BUFFER_ADAPTER (self), NULL);
+
+  if (self->engine == NULL)
+    return NULL;
+
+  return spelling_engine_dup_stats (self->engine);
+}
+
 /**
  * spelling_text_buffer_adapter_get_menu_model:
  * @self: a `SpellingTextBufferAdapter`
@@ -1192,7 +1576,7 @@ spelling_add_action (SpellingTextBufferAdapter *self,
   if (self->checker != NULL)
     {
       spelling_checker_add_word (self->checker, self->word_under_cursor);
-      spelling_text_buffer_adapter_invalidate_all (self);
+      spelling_engine_recheck_word (self->engine, self->word_under_cursor);
     }
 }
 
@@ -1206,7 +1590,7 @@ spelling_ignore_action (SpellingTextBufferAdapter *self,
   if (self->checker != NULL)
     {
       spelling_checker_ignore_word (self->checker, self->word_under_cursor);
-      spelling_text_buffer_adapter_invalidate_all (self);
+      spelling_engine_recheck_word (self->engine, self->word_under_cursor);
     }
 }
 
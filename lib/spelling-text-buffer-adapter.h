@@ -23,6 +23,7 @@
 
 #include <gtksourceview/gtksource.h>
 
+#include "spelling-stats.h"
 #include "spelling-types.h"
 #include "spelling-version-macros.h"
 
@@ -39,6 +40,11 @@ SpellingTextBufferAdapter *spelling_text_buffer_adapter_new                (GtkS
 SPELLING_AVAILABLE_IN_ALL
 GtkSourceBuffer           *spelling_text_buffer_adapter_get_buffer         (SpellingTextBufferAdapter *self);
 SPELLING_AVAILABLE_IN_ALL
+GtkTextView               *spelling_text_buffer_adapter_get_view           (SpellingTextBufferAdapter *self);
+SPELLING_AVAILABLE_IN_ALL
+void                       spelling_text_buffer_adapter_set_view           (SpellingTextBufferAdapter *self,
+                                                                            GtkTextView               *view);
+SPELLING_AVAILABLE_IN_ALL
 gboolean                   spelling_text_buffer_adapter_get_enabled        (SpellingTextBufferAdapter *self);
 SPELLING_AVAILABLE_IN_ALL
 void                       spelling_text_buffer_adapter_set_enabled        (SpellingTextBufferAdapter *self,
@@ -61,5 +67,12 @@ SPELLING_AVAILABLE_IN_ALL
 GMenuModel                *spelling_text_buffer_adapter_get_menu_model     (SpellingTextBufferAdapter *self);
 SPELLING_AVAILABLE_IN_ALL
 void                       spelling_text_buffer_adapter_update_corrections (SpellingTextBufferAdapter *self);
+SPELLING_AVAILABLE_IN_ALL
+gboolean                   spelling_text_buffer_adapter_get_use_cache      (SpellingTextBufferAdapter *self);
+SPELLING_AVAILABLE_IN_ALL
+void                       spelling_text_buffer_adapter_set_use_cache      (SpellingTextBufferAdapter *self,
+                                                                            gboolean                   use_cache);
+SPELLING_AVAILABLE_IN_ALL
+SpellingStats             *spelling_text_buffer_adapter_dup_stats         (SpellingTextBufferAdapter *self);
 
 G_END_DECLS
@@ -0,0 +1,122 @@
+/* spelling-trace.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "spelling-trace.h"
+
+#ifdef HAVE_SYSPROF
+
+static const struct {
+  const char *name;
+  const char *description;
+  int         type;
+} counter_info[SPELLING_PROFILER_N_COUNTERS] = {
+  [SPELLING_PROFILER_COUNTER_WORDS_PER_SEC] = {
+    "Words/sec", "Words checked per second by the last job",
+    SYSPROF_CAPTURE_COUNTER_DOUBLE,
+  },
+  [SPELLING_PROFILER_COUNTER_UNCHECKED] = {
+    "Unchecked", "Characters waiting to be checked",
+    SYSPROF_CAPTURE_COUNTER_INT64,
+  },
+  [SPELLING_PROFILER_COUNTER_ACTIVE_JOBS] = {
+    "Active Jobs", "Jobs in flight",
+    SYSPROF_CAPTURE_COUNTER_INT64,
+  },
+};
+
+/* Gauges are summed over every engine, each adding the difference from
+ * what it reported last.
+ */
+static gssize gauges[SPELLING_PROFILER_N_COUNTERS];
+
+/* Counters are defined the first time one is set while Sysprof is
+ * recording, ids being allocated for the whole process.
+ */
+static guint
+spelling_profiler_get_counter_base (void)
+{
+  static gsize base;
+
+  if (g_once_init_enter (&base))
+    {
+      SysprofCaptureCounter counters[SPELLING_PROFILER_N_COUNTERS] = {0};
+      guint first = sysprof_collector_request_counters (SPELLING_PROFILER_N_COUNTERS);
+
+      for (guint i = 0; i < SPELLING_PROFILER_N_COUNTERS; i++)
+        {
+          g_strlcpy (counters[i].category, "Spelling", sizeof counters[i].category);
+          g_strlcpy (counters[i].name, counter_info[i].name, sizeof counters[i].name);
+          g_strlcpy (counters[i].description, counter_info[i].description, sizeof counters[i].description);
+          counters[i].id = first + i;
+          counters[i].type = counter_info[i].type;
+        }
+
+      sysprof_collector_define_counters (counters, SPELLING_PROFILER_N_COUNTERS);
+
+      /* Ids start at 1, zero means not defined yet */
+      g_once_init_leave (&base, first + 1);
+    }
+
+  return base - 1;
+}
+
+static void
+spelling_profiler_publish (SpellingProfilerCounter    counter,
+                           SysprofCaptureCounterValue value)
+{
+  guint id;
+
+  if (!SPELLING_PROFILER_ACTIVE)
+    return;
+
+  id = spelling_profiler_get_counter_base () + counter;
+  sysprof_collector_set_counters (&id, &value, 1);
+}
+
+void
+spelling_profiler_counter_add (SpellingProfilerCounter counter,
+                               gssize                  delta)
+{
+  SysprofCaptureCounterValue value;
+
+  g_return_if_fail (counter < SPELLING_PROFILER_N_COUNTERS);
+
+  if (delta == 0)
+    return;
+
+  value.v64 = g_atomic_pointer_add (&gauges[counter], delta) + delta;
+  spelling_profiler_publish (counter, value);
+}
+
+void
+spelling_profiler_counter_set (SpellingProfilerCounter counter,
+                               double                  value)
+{
+  SysprofCaptureCounterValue v;
+
+  g_return_if_fail (counter < SPELLING_PROFILER_N_COUNTERS);
+
+  v.vdbl = value;
+  spelling_profiler_publish (counter, v);
+}
+
+#endif
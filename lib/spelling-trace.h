@@ -32,6 +32,17 @@
 
 G_BEGIN_DECLS
 
+/* Counters shown by Sysprof next to the marks, shared by every engine
+ * in the process. See spelling-trace.c.
+ */
+typedef enum _SpellingProfilerCounter
+{
+  SPELLING_PROFILER_COUNTER_WORDS_PER_SEC,
+  SPELLING_PROFILER_COUNTER_UNCHECKED,
+  SPELLING_PROFILER_COUNTER_ACTIVE_JOBS,
+  SPELLING_PROFILER_N_COUNTERS,
+} SpellingProfilerCounter;
+
 #ifdef HAVE_SYSPROF
 # define SPELLING_PROFILER_ENABLED 1
 # define SPELLING_PROFILER_CURRENT_TIME SYSPROF_CAPTURE_CURRENT_TIME
@@ -52,6 +63,15 @@ G_BEGIN_DECLS
     if (SPELLING_PROFILER_ACTIVE) \
       sysprof_collector_log_printf(G_LOG_LEVEL_DEBUG, G_LOG_DOMAIN, format, __VA_ARGS__); \
   } G_STMT_END
+# define SPELLING_PROFILER_COUNTER_ADD(counter, delta) \
+  spelling_profiler_counter_add (counter, delta)
+# define SPELLING_PROFILER_COUNTER_SET(counter, value) \
+  spelling_profiler_counter_set (counter, value)
+
+void spelling_profiler_counter_add (SpellingProfilerCounter counter,
+                                    gssize                  delta);
+void spelling_profiler_counter_set (SpellingProfilerCounter counter,
+                                    double                  value);
 #else
 # undef SPELLING_PROFILER_ENABLED
 # define SPELLING_PROFILER_ACTIVE (0)
@@ -60,6 +80,8 @@ G_BEGIN_DECLS
 # define SPELLING_PROFILER_BEGIN_MARK G_STMT_START {} G_STMT_END
 # define SPELLING_PROFILER_END_MARK(name, message) G_STMT_START {} G_STMT_END
 # define SPELLING_PROFILER_LOG(format, ...) G_STMT_START {} G_STMT_END
+# define SPELLING_PROFILER_COUNTER_ADD(counter, delta) G_STMT_START {} G_STMT_END
+# define SPELLING_PROFILER_COUNTER_SET(counter, value) G_STMT_START {} G_STMT_END
 #endif
 
 G_END_DECLS
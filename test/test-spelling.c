@@ -151,6 +151,7 @@ main (int   argc,
   /* Setup spellchecking */
   checker = spelling_checker_get_default ();
   adapter = spelling_text_buffer_adapter_new (source_buffer, checker);
+  spelling_text_buffer_adapter_set_view (adapter, GTK_TEXT_VIEW (source_view));
   extra_menu = spelling_text_buffer_adapter_get_menu_model (adapter);
   gtk_text_view_set_extra_menu (GTK_TEXT_VIEW (source_view), extra_menu);
   gtk_widget_insert_action_group (GTK_WIDGET (source_view), "spelling", G_ACTION_GROUP (adapter));
@@ -0,0 +1,297 @@
+/* bench-engine.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <locale.h>
+
+#include "bench.h"
+
+#include "spelling-engine-private.h"
+
+#define N_KEYSTROKE_WORDS 50
+#define VIEWPORT_CHARS    4000
+
+/* The adapter works on an ASCII buffer so that character offsets are
+ * byte offsets and copying text out of a large buffer is cheap, leaving
+ * the cost to the engine.
+ */
+static GString *buffer;
+static GtkBitset *mispelled;
+static SpellingDictionary *dictionary;
+static guint cursor;
+
+static gboolean
+is_word_char (char ch)
+{
+  return g_ascii_isalnum (ch) || ch == '\'' || ch == '_';
+}
+
+static char *
+copy_text (gpointer instance,
+           guint    position,
+           guint    length)
+{
+  return g_strndup (buffer->str + position, length);
+}
+
+static void
+clear_tag (gpointer instance,
+           guint    position,
+           guint    length)
+{
+  gtk_bitset_remove_range (mispelled, position, length);
+}
+
+static gboolean
+apply_tag (gpointer instance,
+           guint    position,
+           guint    length)
+{
+  gtk_bitset_add_range (mispelled, position, length);
+  return TRUE;
+}
+
+static gboolean
+backward_word_start (gpointer  instance,
+                     guint    *position)
+{
+  guint pos = *position;
+
+  if (pos == 0)
+    return FALSE;
+
+  pos--;
+
+  while (pos > 0 && !is_word_char (buffer->str[pos]))
+    pos--;
+
+  if (!is_word_char (buffer->str[pos]))
+    return FALSE;
+
+  while (pos > 0 && is_word_char (buffer->str[pos - 1]))
+    pos--;
+
+  *position = pos;
+
+  return TRUE;
+}
+
+static gboolean
+forward_word_end (gpointer  instance,
+                  guint    *position)
+{
+  guint pos = *position;
+
+  if (pos >= buffer->len)
+    return FALSE;
+
+  pos++;
+
+  while (pos < buffer->len && !is_word_char (buffer->str[pos]))
+    pos++;
+
+  if (pos >= buffer->len)
+    return FALSE;
+
+  while (pos < buffer->len && is_word_char (buffer->str[pos]))
+    pos++;
+
+  *position = pos;
+
+  return TRUE;
+}
+
+static void
+intersect_spellcheck_region (gpointer   instance,
+                             GtkBitset *bitset)
+{
+}
+
+static guint
+get_cursor (gpointer instance)
+{
+  return cursor;
+}
+
+static PangoLanguage *
+get_language (gpointer instance)
+{
+  return pango_language_from_string ("en_US");
+}
+
+static SpellingDictionary *
+get_dictionary (gpointer instance)
+{
+  return dictionary;
+}
+
+static gboolean
+check_enabled (gpointer instance)
+{
+  return TRUE;
+}
+
+/* The viewport follows the cursor like a text view would */
+static gboolean
+get_visible_range (gpointer  instance,
+                   guint    *begin,
+                   guint    *end)
+{
+  *begin = cursor - MIN (cursor, VIEWPORT_CHARS / 2);
+  *end = MIN (buffer->len, *begin + VIEWPORT_CHARS);
+
+  return TRUE;
+}
+
+static const SpellingAdapter adapter = {
+  .check_enabled = check_enabled,
+  .get_cursor = get_cursor,
+  .copy_text = copy_text,
+  .clear_tag = clear_tag,
+  .apply_tag = apply_tag,
+  .backward_word_start = backward_word_start,
+  .forward_word_end = forward_word_end,
+  .intersect_spellcheck_region = intersect_spellcheck_region,
+  .get_dictionary = get_dictionary,
+  .get_language = get_language,
+  .get_visible_range = get_visible_range,
+};
+
+static void
+insert (SpellingEngine *engine,
+        const char     *text,
+        guint           position)
+{
+  guint len = strlen (text);
+
+  spelling_engine_before_insert_text (engine, position, len);
+  g_string_insert_len (buffer, position, text, len);
+  gtk_bitset_splice (mispelled, position, 0, len);
+  cursor = position + len;
+  spelling_engine_after_insert_text (engine, position, len);
+}
+
+static void
+wait_for_engine (SpellingEngine *engine)
+{
+  while (spelling_engine_get_busy (engine))
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static gboolean
+is_tagged (guint position,
+           guint length)
+{
+  for (guint i = position; i < position + length; i++)
+    {
+      if (!gtk_bitset_contains (mispelled, i))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Types misspelled words at the end of @corpus one key at a time and
+ * measures how long it takes after each key until the word as typed so
+ * far is underlined. Vocabulary words are all lowercase, so the typed
+ * words are made unknown with an uppercase letter.
+ */
+static void
+bench_keystroke (SpellingEngine *engine,
+                 BenchCorpus    *corpus)
+{
+  static const char *keys = "Qzjxv ";
+  g_autoptr(GArray) samples = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  for (guint w = 0; w < N_KEYSTROKE_WORDS; w++)
+    {
+      guint word_start = buffer->len;
+
+      for (const char *k = keys; *k != ' '; k++)
+        {
+          char key[2] = { *k, 0 };
+          gint64 begin_time = g_get_monotonic_time ();
+          gint64 latency;
+
+          insert (engine, key, buffer->len);
+
+          while (!is_tagged (word_start, buffer->len - word_start) &&
+                 spelling_engine_get_busy (engine))
+            g_main_context_iteration (NULL, TRUE);
+
+          latency = g_get_monotonic_time () - begin_time;
+          g_array_append_val (samples, latency);
+        }
+
+      insert (engine, " ", buffer->len);
+      wait_for_engine (engine);
+    }
+
+  bench_report_latency ("keystroke-to-underline", corpus->name, samples);
+}
+
+static void
+bench_engine (const char *name,
+              gsize       size)
+{
+  g_autoptr(BenchCorpus) corpus = bench_corpus_new (name, size);
+  g_autoptr(SpellingEngine) engine = NULL;
+  g_autoptr(GObject) instance = g_object_new (G_TYPE_OBJECT, NULL);
+  gint64 begin_time;
+
+  buffer = g_string_new (NULL);
+  mispelled = gtk_bitset_new_empty ();
+  dictionary = bench_dictionary_new ();
+  engine = spelling_engine_new (&adapter, instance);
+
+  /* Like loading a file and waiting for every mistake to show */
+  begin_time = g_get_monotonic_time ();
+  insert (engine, corpus->text->str, 0);
+  cursor = 0;
+  wait_for_engine (engine);
+  bench_report ("engine-time-to-clean", corpus->name,
+                corpus->text->len, corpus->n_words,
+                g_get_monotonic_time () - begin_time);
+
+  if (size == 1024 * 1024)
+    {
+      cursor = buffer->len;
+      bench_keystroke (engine, corpus);
+    }
+
+  g_clear_object (&engine);
+  g_clear_object (&dictionary);
+  g_clear_pointer (&mispelled, gtk_bitset_unref);
+  g_string_free (g_steal_pointer (&buffer), TRUE);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  setlocale (LC_ALL, "C");
+
+  bench_engine ("latin", 1024 * 1024);
+  bench_engine ("latin", 8 * 1024 * 1024);
+  bench_engine ("bundled", 1024 * 1024);
+
+  return 0;
+}
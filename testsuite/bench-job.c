@@ -0,0 +1,163 @@
+/* bench-job.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <locale.h>
+
+#include "bench.h"
+
+#include "spelling-job-private.h"
+
+#define FRAGMENT_SIZE 4096
+
+static const char *corpora[] = { "latin", "cyrillic", "bundled" };
+static const gsize sizes[] = { 64 * 1024, 1024 * 1024, 8 * 1024 * 1024 };
+
+/* Runs a job over all of @corpus, cut into fragments at line ends the
+ * way the engine hands text to jobs, and returns how long it took.
+ */
+static gint64
+bench_job_run (BenchCorpus        *corpus,
+               SpellingDictionary *dictionary)
+{
+  g_autoptr(SpellingJob) job = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autofree SpellingBoundary *fragments = NULL;
+  g_autofree SpellingMistake *mistakes = NULL;
+  const char *text = corpus->text->str;
+  gsize len = corpus->text->len;
+  guint n_fragments = 0;
+  guint n_mistakes = 0;
+  guint position = 0;
+  gsize begin = 0;
+  gint64 begin_time;
+
+  bytes = g_bytes_new_static (text, len);
+  job = spelling_job_new (dictionary, pango_language_from_string ("en_US"));
+
+  while (begin < len)
+    {
+      g_autoptr(GBytes) fragment = NULL;
+      const char *nl = NULL;
+      gsize end = len;
+      guint length;
+
+      if (len - begin > FRAGMENT_SIZE)
+        nl = memchr (text + begin + FRAGMENT_SIZE, '\n', len - begin - FRAGMENT_SIZE);
+
+      if (nl != NULL)
+        end = nl - text + 1;
+
+      length = g_utf8_strlen (text + begin, end - begin);
+      fragment = g_bytes_new_from_bytes (bytes, begin, end - begin);
+      spelling_job_add_fragment (job, fragment, position, length);
+
+      position += length;
+      begin = end;
+    }
+
+  begin_time = g_get_monotonic_time ();
+  spelling_job_run_sync (job, &fragments, &n_fragments, &mistakes, &n_mistakes);
+
+  return g_get_monotonic_time () - begin_time;
+}
+
+static void
+bench_job (void)
+{
+  for (guint c = 0; c < G_N_ELEMENTS (corpora); c++)
+    {
+      for (guint s = 0; s < G_N_ELEMENTS (sizes); s++)
+        {
+          g_autoptr(BenchCorpus) corpus = bench_corpus_new (corpora[c], sizes[s]);
+          g_autoptr(SpellingDictionary) dictionary = bench_dictionary_new ();
+          gint64 cold;
+          gint64 warm;
+
+          /* The first run fills the dictionary cache, like opening a
+           * document, while the second is like checking it again.
+           */
+          cold = bench_job_run (corpus, dictionary);
+          warm = bench_job_run (corpus, dictionary);
+
+          bench_report ("job-cold", corpus->name, corpus->text->len, corpus->n_words, cold);
+          bench_report ("job-warm", corpus->name, corpus->text->len, corpus->n_words, warm);
+        }
+    }
+}
+
+/* Looks up every word of a corpus at once, bypassing segmentation */
+static void
+bench_dictionary (void)
+{
+  for (guint c = 0; c < G_N_ELEMENTS (corpora); c++)
+    {
+      g_autoptr(BenchCorpus) corpus = bench_corpus_new (corpora[c], 1024 * 1024);
+      g_autoptr(SpellingDictionary) dictionary = bench_dictionary_new ();
+      g_autoptr(GArray) words = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+      const char *text = corpus->text->str;
+      const char *p = text;
+
+      while (*p)
+        {
+          SpellingBoundary word;
+          gsize n = strcspn (p, " ,.\n");
+
+          /* Lookups only use the byte positions */
+          if (n > 0)
+            {
+              word.offset = 0;
+              word.length = 0;
+              word.byte_offset = p - text;
+              word.byte_length = n;
+              g_array_append_val (words, word);
+            }
+
+          p += n + (p[n] != 0);
+        }
+
+      for (guint run = 0; run < 2; run++)
+        {
+          g_autoptr(GtkBitset) mistakes = NULL;
+          gint64 begin_time = g_get_monotonic_time ();
+
+          mistakes = _spelling_dictionary_check_words (dictionary, text,
+                                                       &g_array_index (words, SpellingBoundary, 0),
+                                                       words->len, NULL);
+
+          bench_report (run == 0 ? "dictionary-cold" : "dictionary-warm",
+                        corpus->name, 0, words->len,
+                        g_get_monotonic_time () - begin_time);
+        }
+    }
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  setlocale (LC_ALL, "C");
+
+  bench_job ();
+  bench_dictionary ();
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+/* bench-region.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "bench.h"
+
+#include "cjhtextregionprivate.h"
+
+#define N_RUNS 1000000
+
+static gboolean
+count_runs_cb (gsize                   offset,
+               const CjhTextRegionRun *run,
+               gpointer                user_data)
+{
+  (*(guint *)user_data)++;
+  return FALSE;
+}
+
+/* Builds a region of N_RUNS runs at random positions and then replaces,
+ * walks and removes at the same scale, which is what a buffer of a few
+ * million characters with many mistakes does to the engine regions.
+ */
+static void
+bench_region (void)
+{
+  g_autoptr(GRand) rand = g_rand_new_with_seed (BENCH_SEED);
+  CjhTextRegion *region = _cjh_text_region_new (NULL, NULL);
+  gint64 begin_time;
+  guint n_runs = 0;
+  guint n_ops = 0;
+
+  begin_time = g_get_monotonic_time ();
+  for (guint i = 0; i < N_RUNS; i++)
+    _cjh_text_region_insert (region,
+                             g_rand_int_range (rand, 0, _cjh_text_region_get_length (region) + 1),
+                             1 + i % 8,
+                             GUINT_TO_POINTER (1 + i % 3));
+  bench_report ("region-insert", NULL, 0, N_RUNS, g_get_monotonic_time () - begin_time);
+
+  begin_time = g_get_monotonic_time ();
+  for (guint i = 0; i < N_RUNS; i++)
+    {
+      guint length = _cjh_text_region_get_length (region);
+      guint offset = g_rand_int_range (rand, 0, length - 8);
+
+      _cjh_text_region_replace (region, offset, 1 + i % 8, GUINT_TO_POINTER (1 + i % 3));
+    }
+  bench_report ("region-replace", NULL, 0, N_RUNS, g_get_monotonic_time () - begin_time);
+
+  begin_time = g_get_monotonic_time ();
+  _cjh_text_region_foreach (region, count_runs_cb, &n_runs);
+  bench_report ("region-foreach", NULL, 0, n_runs, g_get_monotonic_time () - begin_time);
+
+  begin_time = g_get_monotonic_time ();
+  while (_cjh_text_region_get_length (region) > 0)
+    {
+      guint length = _cjh_text_region_get_length (region);
+      guint offset = g_rand_int_range (rand, 0, length);
+
+      _cjh_text_region_remove (region, offset, MIN (length - offset, 1 + n_ops % 8));
+      n_ops++;
+    }
+  bench_report ("region-remove", NULL, 0, n_ops, g_get_monotonic_time () - begin_time);
+
+  _cjh_text_region_free (region);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  bench_region ();
+
+  return 0;
+}
@@ -0,0 +1,288 @@
+/* bench.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include <libspelling.h>
+
+#include "spelling-dictionary-internal.h"
+
+G_BEGIN_DECLS
+
+/* Shared by the benchmarks, which each print one JSON object per line
+ * so that results can be collected from the output of meson benchmark
+ * and compared between builds.
+ *
+ * Corpora are generated from a fixed seed so that every run checks the
+ * same text. The dictionary knows every word of the corpus vocabulary
+ * and nothing else, about 2% of the words being misspelled.
+ */
+
+#define BENCH_SEED            1234
+#define BENCH_VOCABULARY_SIZE 4096
+#define BENCH_MISSPELLED_RATE 50
+
+typedef struct _BenchCorpus
+{
+  const char *name;
+  const char *misspelling;
+  GString    *text;
+  guint       n_words;
+} BenchCorpus;
+
+static GHashTable *bench_vocabulary;
+
+typedef struct _BenchDictionary
+{
+  SpellingDictionary parent_instance;
+} BenchDictionary;
+
+typedef struct _BenchDictionaryClass
+{
+  SpellingDictionaryClass parent_class;
+} BenchDictionaryClass;
+
+GType bench_dictionary_get_type (void);
+
+G_DEFINE_FINAL_TYPE (BenchDictionary, bench_dictionary, SPELLING_TYPE_DICTIONARY)
+
+static gboolean
+bench_dictionary_contains_word (SpellingDictionary *dictionary,
+                                const char         *word,
+                                gssize              word_len)
+{
+  g_autofree char *copy = g_strndup (word, word_len < 0 ? strlen (word) : (gsize)word_len);
+
+  return g_hash_table_contains (bench_vocabulary, copy);
+}
+
+static const char *
+bench_dictionary_get_extra_word_chars (SpellingDictionary *dictionary)
+{
+  return "'";
+}
+
+static void
+bench_dictionary_class_init (BenchDictionaryClass *klass)
+{
+  SpellingDictionaryClass *dictionary_class = SPELLING_DICTIONARY_CLASS (klass);
+
+  dictionary_class->contains_word = bench_dictionary_contains_word;
+  dictionary_class->get_extra_word_chars = bench_dictionary_get_extra_word_chars;
+}
+
+static void
+bench_dictionary_init (BenchDictionary *self)
+{
+}
+
+static inline SpellingDictionary *
+bench_dictionary_new (void)
+{
+  return g_object_new (bench_dictionary_get_type (), "code", "en_US", NULL);
+}
+
+static inline void
+bench_vocabulary_add (const char *word)
+{
+  if (bench_vocabulary == NULL)
+    bench_vocabulary = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  g_hash_table_add (bench_vocabulary, g_strdup (word));
+}
+
+static inline char *
+bench_random_word (GRand      *rand,
+                   const char *alphabet)
+{
+  g_autoptr(GString) word = g_string_new (NULL);
+  guint n_letters = g_utf8_strlen (alphabet, -1);
+  guint length = g_rand_int_range (rand, 2, 11);
+
+  for (guint i = 0; i < length; i++)
+    {
+      const char *letter = g_utf8_offset_to_pointer (alphabet, g_rand_int_range (rand, 0, n_letters));
+      g_string_append_len (word, letter, g_utf8_next_char (letter) - letter);
+    }
+
+  return g_string_free (g_steal_pointer (&word), FALSE);
+}
+
+/* Appends @word, or a misspelling of it, followed by a separator */
+static inline void
+bench_corpus_append (BenchCorpus *corpus,
+                     GRand       *rand,
+                     const char  *word)
+{
+  if (g_rand_int_range (rand, 0, BENCH_MISSPELLED_RATE) == 0)
+    {
+      g_string_append (corpus->text, word);
+      g_string_append (corpus->text, corpus->misspelling);
+    }
+  else
+    {
+      g_string_append (corpus->text, word);
+    }
+
+  corpus->n_words++;
+
+  if (corpus->n_words % 12 == 0)
+    g_string_append (corpus->text, ".\n");
+  else if (corpus->n_words % 5 == 0)
+    g_string_append (corpus->text, ", ");
+  else
+    g_string_append_c (corpus->text, ' ');
+}
+
+/* Creates about @size bytes of text named @name:
+ *
+ *  - "latin", made up ASCII words
+ *  - "cyrillic", made up Cyrillic words which take the Pango path
+ *  - "bundled", the LGPL text distributed with libspelling, repeated
+ */
+static inline BenchCorpus *
+bench_corpus_new (const char *name,
+                  gsize       size)
+{
+  g_autoptr(GRand) rand = g_rand_new_with_seed (BENCH_SEED);
+  g_autoptr(GPtrArray) words = g_ptr_array_new_with_free_func (g_free);
+  BenchCorpus *corpus = g_new0 (BenchCorpus, 1);
+
+  corpus->name = name;
+  corpus->misspelling = g_str_equal (name, "cyrillic") ? "ъь" : "xq";
+  corpus->text = g_string_sized_new (size + 64);
+
+  if (g_str_equal (name, "bundled"))
+    {
+      g_autofree char *contents = NULL;
+      g_auto(GStrv) tokens = NULL;
+      g_autoptr(GError) error = NULL;
+
+      if (!g_file_get_contents (BENCH_CORPUS, &contents, NULL, &error))
+        g_error ("%s", error->message);
+
+      tokens = g_regex_split_simple ("[^A-Za-z']+", contents, 0, 0);
+
+      for (guint i = 0; tokens[i]; i++)
+        {
+          if (tokens[i][0] != 0)
+            g_ptr_array_add (words, g_steal_pointer (&tokens[i]));
+        }
+    }
+  else
+    {
+      const char *alphabet = g_str_equal (name, "cyrillic")
+                           ? "абвгдежзийклмнопрстуфхцчшщыэюя"
+                           : "abcdefghijklmnopqrstuvwxyz";
+
+      for (guint i = 0; i < BENCH_VOCABULARY_SIZE; i++)
+        g_ptr_array_add (words, bench_random_word (rand, alphabet));
+    }
+
+  for (guint i = 0; i < words->len; i++)
+    bench_vocabulary_add (g_ptr_array_index (words, i));
+
+  /* Synthetic text picks words at random while the bundled text is
+   * kept in order so that it reads like real text.
+   */
+  for (guint i = 0; corpus->text->len < size; i++)
+    {
+      guint index = g_str_equal (name, "bundled")
+                  ? i % words->len
+                  : g_rand_int_range (rand, 0, words->len);
+
+      bench_corpus_append (corpus, rand, g_ptr_array_index (words, index));
+    }
+
+  return corpus;
+}
+
+static inline void
+bench_corpus_free (BenchCorpus *corpus)
+{
+  g_string_free (corpus->text, TRUE);
+  g_free (corpus);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (BenchCorpus, bench_corpus_free)
+
+static inline int
+bench_compare_samples (gconstpointer a,
+                       gconstpointer b)
+{
+  gint64 va = *(const gint64 *)a;
+  gint64 vb = *(const gint64 *)b;
+
+  return (va > vb) - (va < vb);
+}
+
+static inline gint64
+bench_percentile (GArray *samples,
+                  guint   percentile)
+{
+  guint index;
+
+  if (samples->len == 0)
+    return 0;
+
+  g_array_sort (samples, bench_compare_samples);
+  index = MIN (samples->len - 1, (samples->len * percentile + 99) / 100 - 1);
+
+  return g_array_index (samples, gint64, index);
+}
+
+/* Prints the time it took to process @n_items items out of @n_bytes
+ * bytes of @corpus, either of which may be 0 if it does not apply.
+ */
+static inline void
+bench_report (const char *benchmark,
+              const char *corpus,
+              gsize       n_bytes,
+              guint64     n_items,
+              gint64      usec)
+{
+  double seconds = MAX (usec, 1) / (double)G_USEC_PER_SEC;
+
+  g_print ("{\"benchmark\": \"%s\", \"corpus\": \"%s\", \"bytes\": %" G_GSIZE_FORMAT ", "
+           "\"items\": %" G_GUINT64_FORMAT ", \"usec\": %" G_GINT64_FORMAT ", "
+           "\"items_per_sec\": %.0f, \"mb_per_sec\": %.2f}\n",
+           benchmark, corpus ? corpus : "", n_bytes, n_items, usec,
+           n_items / seconds, n_bytes / seconds / (1024. * 1024.));
+}
+
+/* Prints percentiles of latencies in @samples, in microseconds */
+static inline void
+bench_report_latency (const char *benchmark,
+                      const char *corpus,
+                      GArray     *samples)
+{
+  g_print ("{\"benchmark\": \"%s\", \"corpus\": \"%s\", \"samples\": %u, "
+           "\"p50_usec\": %" G_GINT64_FORMAT ", \"p99_usec\": %" G_GINT64_FORMAT ", "
+           "\"max_usec\": %" G_GINT64_FORMAT "}\n",
+           benchmark, corpus ? corpus : "", samples->len,
+           bench_percentile (samples, 50),
+           bench_percentile (samples, 99),
+           bench_percentile (samples, 100));
+}
+
+G_END_DECLS
@@ -0,0 +1,158 @@
+/* test-cache.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <time.h>
+#include <utime.h>
+
+#include <glib/gstdio.h>
+
+#include <libspelling.h>
+
+#include "spelling-cache-private.h"
+
+static void
+test_cache_path (void)
+{
+  static const char text[] = "teh quick brown fox";
+  g_autofree char *path = spelling_cache_dup_path ("en_US", text, strlen (text));
+  g_autofree char *same = spelling_cache_dup_path ("en_US", text, strlen (text));
+  g_autofree char *other_code = spelling_cache_dup_path ("en_GB", text, strlen (text));
+  g_autofree char *other_text = spelling_cache_dup_path ("en_US", text, strlen (text) - 1);
+  g_autofree char *dir = g_build_filename (g_get_user_cache_dir (), "libspelling", NULL);
+
+  g_assert_true (g_str_has_prefix (path, dir));
+  g_assert_cmpstr (path, ==, same);
+  g_assert_cmpstr (path, !=, other_code);
+  g_assert_cmpstr (path, !=, other_text);
+}
+
+static void
+test_cache_roundtrip (void)
+{
+  static const SpellingMistake mistakes[] = { { 0, 3 }, { 10, 5 }, { 16, 3 } };
+  g_autofree char *path = spelling_cache_dup_path ("en_US", "text", 4);
+  g_autofree SpellingMistake *loaded = NULL;
+  g_autoptr(GError) error = NULL;
+  guint n_loaded = 0;
+
+  g_assert_true (spelling_cache_save (path, 19, mistakes, G_N_ELEMENTS (mistakes), &error));
+  g_assert_no_error (error);
+
+  loaded = spelling_cache_load (path, 19, &n_loaded);
+  g_assert_nonnull (loaded);
+  g_assert_cmpuint (n_loaded, ==, G_N_ELEMENTS (mistakes));
+  g_assert_cmpmem (loaded, n_loaded * sizeof *loaded, mistakes, sizeof mistakes);
+  g_clear_pointer (&loaded, g_free);
+
+  /* A text of another length is not the same text */
+  g_assert_null (spelling_cache_load (path, 20, &n_loaded));
+  g_assert_cmpuint (n_loaded, ==, 0);
+}
+
+static void
+test_cache_reject (void)
+{
+  static const SpellingMistake unsorted[] = { { 10, 5 }, { 0, 3 } };
+  static const SpellingMistake overflow[] = { { 17, 3 } };
+  g_autofree char *path = spelling_cache_dup_path ("en_US", "reject", 6);
+  g_autoptr(GError) error = NULL;
+  guint n_loaded = 0;
+
+  g_assert_null (spelling_cache_load (path, 19, &n_loaded));
+
+  g_assert_true (spelling_cache_save (path, 19, unsorted, G_N_ELEMENTS (unsorted), &error));
+  g_assert_no_error (error);
+  g_assert_null (spelling_cache_load (path, 19, &n_loaded));
+
+  g_assert_true (spelling_cache_save (path, 19, overflow, G_N_ELEMENTS (overflow), &error));
+  g_assert_no_error (error);
+  g_assert_null (spelling_cache_load (path, 19, &n_loaded));
+
+  g_assert_true (g_file_set_contents (path, "garbage", -1, &error));
+  g_assert_no_error (error);
+  g_assert_null (spelling_cache_load (path, 19, &n_loaded));
+  g_assert_cmpuint (n_loaded, ==, 0);
+}
+
+/* Writes @size bytes to @name in @dir, last used @age_secs ago */
+static char *
+write_cache_file (const char *dir,
+                  const char *name,
+                  gsize       size,
+                  gint64      age_secs)
+{
+  g_autofree char *contents = g_malloc0 (size);
+  g_autoptr(GError) error = NULL;
+  char *path = g_build_filename (dir, name, NULL);
+  struct utimbuf times;
+
+  g_assert_true (g_file_set_contents (path, contents, size, &error));
+  g_assert_no_error (error);
+
+  times.actime = times.modtime = time (NULL) - age_secs;
+  g_assert_cmpint (g_utime (path, &times), ==, 0);
+
+  return path;
+}
+
+static void
+test_cache_evict (void)
+{
+  g_autofree char *dir = g_build_filename (g_get_user_cache_dir (), "libspelling", NULL);
+  g_autofree char *expired = NULL;
+  g_autofree char *oldest = NULL;
+  g_autofree char *older = NULL;
+  g_autofree char *newest = NULL;
+  g_autofree char *other = NULL;
+
+  g_assert_cmpint (g_mkdir_with_parents (dir, 0700), ==, 0);
+
+  expired = write_cache_file (dir, "expired.cache", 10, 3 * 24 * 60 * 60);
+  oldest = write_cache_file (dir, "oldest.cache", 100, 300);
+  older = write_cache_file (dir, "older.cache", 100, 200);
+  newest = write_cache_file (dir, "newest.cache", 100, 100);
+  other = write_cache_file (dir, "other.txt", 1000, 3 * 24 * 60 * 60);
+
+  /* Expired files go first, then the least recently used until the
+   * rest fits. Files which are not cache files are left alone.
+   */
+  spelling_cache_evict (dir, 250, 2 * G_TIME_SPAN_DAY);
+
+  g_assert_false (g_file_test (expired, G_FILE_TEST_EXISTS));
+  g_assert_false (g_file_test (oldest, G_FILE_TEST_EXISTS));
+  g_assert_true (g_file_test (older, G_FILE_TEST_EXISTS));
+  g_assert_true (g_file_test (newest, G_FILE_TEST_EXISTS));
+  g_assert_true (g_file_test (other, G_FILE_TEST_EXISTS));
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+  g_test_add_func ("/Spelling/Cache/path", test_cache_path);
+  g_test_add_func ("/Spelling/Cache/roundtrip", test_cache_roundtrip);
+  g_test_add_func ("/Spelling/Cache/reject", test_cache_reject);
+  g_test_add_func ("/Spelling/Cache/evict", test_cache_evict);
+  return g_test_run ();
+}
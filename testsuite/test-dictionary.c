@@ -0,0 +1,217 @@
+/* test-dictionary.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <libspelling.h>
+
+#include "spelling-dictionary-internal.h"
+
+#define TEST_TYPE_DICTIONARY (test_dictionary_get_type())
+
+G_DECLARE_FINAL_TYPE (TestDictionary, test_dictionary, TEST, DICTIONARY, SpellingDictionary)
+
+struct _TestDictionary
+{
+  SpellingDictionary  parent_instance;
+  GHashTable         *words;
+  guint               n_lookups;
+  guint               n_batches;
+};
+
+G_DEFINE_FINAL_TYPE (TestDictionary, test_dictionary, SPELLING_TYPE_DICTIONARY)
+
+static gboolean
+test_dictionary_contains_word (SpellingDictionary *dictionary,
+                               const char         *word,
+                               gssize              word_len)
+{
+  TestDictionary *self = TEST_DICTIONARY (dictionary);
+  g_autofree char *copy = g_strndup (word, word_len < 0 ? strlen (word) : word_len);
+
+  self->n_lookups++;
+
+  return g_hash_table_contains (self->words, copy);
+}
+
+static void
+test_dictionary_check_words (SpellingDictionary     *dictionary,
+                             const char             *text,
+                             const SpellingBoundary *positions,
+                             guint                   n_positions,
+                             GtkBitset              *mistakes)
+{
+  TestDictionary *self = TEST_DICTIONARY (dictionary);
+
+  self->n_batches++;
+
+  for (guint i = 0; i < n_positions; i++)
+    {
+      if (!test_dictionary_contains_word (dictionary,
+                                          &text[positions[i].byte_offset],
+                                          positions[i].byte_length))
+        gtk_bitset_add (mistakes, i);
+    }
+}
+
+static void
+test_dictionary_add_word (SpellingDictionary *dictionary,
+                          const char         *word)
+{
+  TestDictionary *self = TEST_DICTIONARY (dictionary);
+
+  g_hash_table_add (self->words, g_strdup (word));
+}
+
+static const char *
+test_dictionary_get_extra_word_chars (SpellingDictionary *dictionary)
+{
+  return "'\u2019-";
+}
+
+static void
+test_dictionary_finalize (GObject *object)
+{
+  TestDictionary *self = (TestDictionary *)object;
+
+  g_clear_pointer (&self->words, g_hash_table_unref);
+
+  G_OBJECT_CLASS (test_dictionary_parent_class)->finalize (object);
+}
+
+static void
+test_dictionary_class_init (TestDictionaryClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  SpellingDictionaryClass *dictionary_class = SPELLING_DICTIONARY_CLASS (klass);
+
+  object_class->finalize = test_dictionary_finalize;
+
+  dictionary_class->contains_word = test_dictionary_contains_word;
+  dictionary_class->add_word = test_dictionary_add_word;
+  dictionary_class->check_words = test_dictionary_check_words;
+  dictionary_class->get_extra_word_chars = test_dictionary_get_extra_word_chars;
+}
+
+static void
+test_dictionary_init (TestDictionary *self)
+{
+  self->words = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_hash_table_add (self->words, g_strdup ("word"));
+}
+
+static void
+test_dictionary_cache (void)
+{
+  g_autoptr(TestDictionary) dictionary = g_object_new (TEST_TYPE_DICTIONARY, NULL);
+  SpellingDictionary *dict = SPELLING_DICTIONARY (dictionary);
+  guint hits;
+  guint misses;
+
+  g_assert_true (spelling_dictionary_contains_word (dict, "word", -1));
+  g_assert_false (spelling_dictionary_contains_word (dict, "wrod", -1));
+  g_assert_cmpint (dictionary->n_lookups, ==, 2);
+
+  /* Repeated lookups must be answered from the cache */
+  g_assert_true (spelling_dictionary_contains_word (dict, "word", -1));
+  g_assert_false (spelling_dictionary_contains_word (dict, "wrod", 4));
+  g_assert_cmpint (dictionary->n_lookups, ==, 2);
+
+  _spelling_dictionary_get_cache_stats (dict, &hits, &misses);
+  g_assert_cmpint (hits, ==, 2);
+  g_assert_cmpint (misses, ==, 2);
+
+  /* Adding a word must invalidate any cached verdict */
+  spelling_dictionary_add_word (dict, "wrod");
+  g_assert_true (spelling_dictionary_contains_word (dict, "wrod", -1));
+  g_assert_cmpint (dictionary->n_lookups, ==, 3);
+}
+
+static void
+test_dictionary_batch (void)
+{
+  static const char text[] = "word wrod word wrod";
+  static const SpellingBoundary positions[] = {
+    { .offset = 0, .length = 4, .byte_offset = 0, .byte_length = 4 },
+    { .offset = 5, .length = 4, .byte_offset = 5, .byte_length = 4 },
+    { .offset = 10, .length = 4, .byte_offset = 10, .byte_length = 4 },
+    { .offset = 15, .length = 4, .byte_offset = 15, .byte_length = 4 },
+  };
+  g_autoptr(TestDictionary) dictionary = g_object_new (TEST_TYPE_DICTIONARY, NULL);
+  SpellingDictionary *dict = SPELLING_DICTIONARY (dictionary);
+  g_autoptr(GtkBitset) mistakes = NULL;
+  guint n_cached;
+
+  mistakes = _spelling_dictionary_check_words (dict, text, positions, G_N_ELEMENTS (positions), NULL);
+  g_assert_cmpint (gtk_bitset_get_size (mistakes), ==, 2);
+  g_assert_true (gtk_bitset_contains (mistakes, 1));
+  g_assert_true (gtk_bitset_contains (mistakes, 3));
+  g_assert_cmpint (dictionary->n_batches, ==, 1);
+  g_clear_pointer (&mistakes, gtk_bitset_unref);
+
+  /* Everything is cached now, nothing should reach the backend */
+  dictionary->n_lookups = 0;
+  mistakes = _spelling_dictionary_check_words (dict, text, positions, G_N_ELEMENTS (positions), &n_cached);
+  g_assert_cmpint (gtk_bitset_get_size (mistakes), ==, 2);
+  g_assert_cmpint (n_cached, ==, G_N_ELEMENTS (positions));
+  g_assert_cmpint (dictionary->n_lookups, ==, 0);
+  g_assert_cmpint (dictionary->n_batches, ==, 1);
+  g_clear_pointer (&mistakes, gtk_bitset_unref);
+
+  /* Only the invalidated words are handed to the backend, and the
+   * mistake indexes must map back onto the caller's positions.
+   */
+  spelling_dictionary_add_word (dict, "wrod");
+  mistakes = _spelling_dictionary_check_words (dict, text, &positions[1], 2, &n_cached);
+  g_assert_true (gtk_bitset_is_empty (mistakes));
+  g_assert_cmpint (dictionary->n_lookups, ==, 2);
+  g_assert_cmpint (dictionary->n_batches, ==, 2);
+  g_assert_cmpint (n_cached, ==, 0);
+}
+
+static void
+test_dictionary_extra_word_chars (void)
+{
+  g_autoptr(TestDictionary) dictionary = g_object_new (TEST_TYPE_DICTIONARY, NULL);
+  SpellingDictionary *dict = SPELLING_DICTIONARY (dictionary);
+  const SpellingCharSet *set = _spelling_dictionary_get_extra_word_char_set (dict);
+
+  /* The compiled set is cached on the dictionary */
+  g_assert_true (set == _spelling_dictionary_get_extra_word_char_set (dict));
+
+  g_assert_true (spelling_char_set_contains (set, '\''));
+  g_assert_true (spelling_char_set_contains (set, '-'));
+  g_assert_true (spelling_char_set_contains (set, 0x2019));
+  g_assert_false (spelling_char_set_contains (set, 0));
+  g_assert_false (spelling_char_set_contains (set, 'a'));
+  g_assert_false (spelling_char_set_contains (set, 0x2018));
+  g_assert_false (spelling_char_set_contains (NULL, '\''));
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Spelling/Dictionary/cache", test_dictionary_cache);
+  g_test_add_func ("/Spelling/Dictionary/batch", test_dictionary_batch);
+  g_test_add_func ("/Spelling/Dictionary/extra_word_chars", test_dictionary_extra_word_chars);
+  return g_test_run ();
+}
@@ -0,0 +1,296 @@
+/* test-document.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <libspelling.h>
+
+#include "spelling-dictionary-internal.h"
+#include "spelling-provider-internal.h"
+
+typedef struct _TestDictionary
+{
+  SpellingDictionary parent_instance;
+} TestDictionary;
+
+typedef struct _TestDictionaryClass
+{
+  SpellingDictionaryClass parent_class;
+} TestDictionaryClass;
+
+typedef struct _TestProvider
+{
+  SpellingProvider parent_instance;
+} TestProvider;
+
+typedef struct _TestProviderClass
+{
+  SpellingProviderClass parent_class;
+} TestProviderClass;
+
+GType test_dictionary_get_type (void);
+GType test_provider_get_type (void);
+
+G_DEFINE_FINAL_TYPE (TestDictionary, test_dictionary, SPELLING_TYPE_DICTIONARY)
+G_DEFINE_FINAL_TYPE (TestProvider, test_provider, SPELLING_TYPE_PROVIDER)
+
+static gboolean
+test_dictionary_contains_word (SpellingDictionary *self,
+                               const char         *word,
+                               gssize              word_len)
+{
+  if (word_len < 0)
+    word_len = strlen (word);
+
+  /* Tells languages apart in the tests */
+  if (g_strcmp0 (spelling_dictionary_get_code (self), "en_GB") == 0 &&
+      word_len == 3 &&
+      strncmp (word, "baz", word_len) == 0)
+    return TRUE;
+
+  return (word_len == 3 &&
+          (strncmp (word, "foo", word_len) == 0 ||
+           strncmp (word, "bar", word_len) == 0));
+}
+
+static const char *
+test_dictionary_get_extra_word_chars (SpellingDictionary *self)
+{
+  return "";
+}
+
+static void
+test_dictionary_class_init (TestDictionaryClass *klass)
+{
+  SpellingDictionaryClass *dictionary_class = SPELLING_DICTIONARY_CLASS (klass);
+
+  dictionary_class->contains_word = test_dictionary_contains_word;
+  dictionary_class->get_extra_word_chars = test_dictionary_get_extra_word_chars;
+}
+
+static void
+test_dictionary_init (TestDictionary *self)
+{
+}
+
+static SpellingDictionary *
+test_provider_load_dictionary (SpellingProvider *provider,
+                               const char       *language)
+{
+  /* A language nothing is installed for */
+  if (g_strcmp0 (language, "xx") == 0)
+    return NULL;
+
+  return g_object_new (test_dictionary_get_type (),
+                       "code", language,
+                       NULL);
+}
+
+static gboolean
+test_provider_supports_language (SpellingProvider *provider,
+                                 const char       *language)
+{
+  return g_strcmp0 (language, "xx") != 0;
+}
+
+static void
+test_provider_class_init (TestProviderClass *klass)
+{
+  SpellingProviderClass *provider_class = SPELLING_PROVIDER_CLASS (klass);
+
+  provider_class->load_dictionary = test_provider_load_dictionary;
+  provider_class->supports_language = test_provider_supports_language;
+}
+
+static void
+test_provider_init (TestProvider *self)
+{
+}
+
+static void
+check_cb (GObject      *object,
+          GAsyncResult *result,
+          gpointer      user_data)
+{
+  gboolean *done = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert_true (spelling_document_check_finish (SPELLING_DOCUMENT (object), result, &error));
+  g_assert_no_error (error);
+
+  *done = TRUE;
+}
+
+static void
+check (SpellingDocument *document)
+{
+  gboolean done = FALSE;
+
+  spelling_document_check_async (document, NULL, check_cb, &done);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_false (spelling_document_get_busy (document));
+}
+
+static void
+assert_mistakes (SpellingDocument *document,
+                 const guint      *expected,
+                 guint             n_expected)
+{
+  guint position = 0;
+  guint length = 0;
+  guint n = 0;
+
+  while (spelling_document_next_mistake (document, &position, &length))
+    {
+      g_assert_cmpuint (n + 1, <, n_expected);
+      g_assert_cmpuint (position, ==, expected[n]);
+      g_assert_cmpuint (length, ==, expected[n + 1]);
+      position += length;
+      n += 2;
+    }
+
+  g_assert_cmpuint (n, ==, n_expected);
+}
+
+static void
+test_document_edits (void)
+{
+  static const guint initial[] = { 8, 3, 16, 4 };
+  static const guint edited[] = { 0, 3, 12, 3, 20, 4 };
+  g_autoptr(SpellingProvider) provider = g_object_new (test_provider_get_type (), NULL);
+  g_autoptr(SpellingChecker) checker = spelling_checker_new (provider, "en_US");
+  g_autoptr(SpellingDocument) document = spelling_document_new (checker);
+  guint position;
+  guint length;
+
+  g_assert_true (spelling_document_get_checker (document) == checker);
+
+  /* Nothing to check completes right away */
+  check (document);
+
+  spelling_document_set_text (document, "foo bar baz foo\nquxx foo bar\n", -1);
+  g_assert_cmpuint (spelling_document_get_length (document), ==, 29);
+  check (document);
+  assert_mistakes (document, initial, G_N_ELEMENTS (initial));
+
+  /* Starting within a mistake finds the whole mistake */
+  position = 9;
+  g_assert_true (spelling_document_next_mistake (document, &position, &length));
+  g_assert_cmpuint (position, ==, 8);
+  g_assert_cmpuint (length, ==, 3);
+
+  /* Mistakes move with edits and new text is checked */
+  spelling_document_insert (document, 0, "zap ", -1);
+  check (document);
+  assert_mistakes (document, edited, G_N_ELEMENTS (edited));
+  g_assert_cmpstr (spelling_document_get_text (document), ==, "zap foo bar baz foo\nquxx foo bar\n");
+
+  /* Non-ASCII text is counted in characters */
+  spelling_document_delete (document, 0, 4);
+  spelling_document_insert (document, 0, "\xc3\xa9t\xc3\xa9 ", -1);
+  check (document);
+  g_assert_cmpuint (spelling_document_get_length (document), ==, 33);
+  position = 0;
+  g_assert_true (spelling_document_next_mistake (document, &position, &length));
+  g_assert_cmpuint (position, ==, 0);
+  g_assert_cmpuint (length, ==, 3);
+
+  spelling_document_set_text (document, "foo bar", -1);
+  check (document);
+  position = 0;
+  g_assert_false (spelling_document_next_mistake (document, &position, &length));
+}
+
+static void
+check_unsupported_cb (GObject      *object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  gboolean *done = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert_false (spelling_document_check_finish (SPELLING_DOCUMENT (object), result, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+
+  *done = TRUE;
+}
+
+static void
+test_document_language (void)
+{
+  static const guint en_us[] = { 4, 3 };
+  g_autoptr(SpellingProvider) provider = g_object_new (test_provider_get_type (), NULL);
+  g_autoptr(SpellingChecker) checker = spelling_checker_new (provider, "en_US");
+  g_autoptr(SpellingDocument) document = spelling_document_new (checker);
+  gboolean done = FALSE;
+  guint position = 0;
+  guint length;
+
+  spelling_document_set_text (document, "foo baz bar", -1);
+  check (document);
+  assert_mistakes (document, en_us, G_N_ELEMENTS (en_us));
+
+  /* Mistakes are found again for the new language */
+  spelling_checker_set_language (checker, "en_GB");
+  check (document);
+  g_assert_false (spelling_document_next_mistake (document, &position, &length));
+
+  spelling_checker_set_language (checker, "en_US");
+  check (document);
+  assert_mistakes (document, en_us, G_N_ELEMENTS (en_us));
+
+  /* Waiting fails once there is no dictionary */
+  spelling_document_insert (document, 0, "baz ", -1);
+  spelling_document_check_async (document, NULL, check_unsupported_cb, &done);
+  spelling_checker_set_language (checker, "xx");
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* And so does anything new instead of never completing */
+  done = FALSE;
+  spelling_document_check_async (document, NULL, check_unsupported_cb, &done);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  position = 0;
+  g_assert_false (spelling_document_next_mistake (document, &position, &length));
+
+  spelling_checker_set_language (checker, "en_US");
+  check (document);
+  position = 0;
+  g_assert_true (spelling_document_next_mistake (document, &position, &length));
+  g_assert_cmpuint (position, ==, 0);
+  g_assert_cmpuint (length, ==, 3);
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Spelling/Document/edits", test_document_edits);
+  g_test_add_func ("/Spelling/Document/language", test_document_language);
+  return g_test_run ();
+}
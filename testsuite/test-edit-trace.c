@@ -0,0 +1,148 @@
+/* test-edit-trace.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <glib/gstdio.h>
+
+#include "spelling-edit-trace-private.h"
+
+static char *
+record_trace (const char *dir)
+{
+  SpellingEditTraceWriter *writer;
+  const char *name;
+  GDir *d;
+  char *path;
+
+  g_setenv ("LIBSPELLING_EDIT_TRACE_DIR", dir, TRUE);
+  writer = spelling_edit_trace_writer_new_from_env ();
+  g_unsetenv ("LIBSPELLING_EDIT_TRACE_DIR");
+  g_assert_nonnull (writer);
+
+  spelling_edit_trace_writer_insert (writer, 0, "Hello wörld\n\t\"quoted\" \\ é");
+  spelling_edit_trace_writer_cursor (writer, 5);
+  spelling_edit_trace_writer_delete (writer, 3, 2);
+  spelling_edit_trace_writer_insert (writer, 3, " ");
+  spelling_edit_trace_writer_free (writer);
+
+  d = g_dir_open (dir, 0, NULL);
+  g_assert_nonnull (d);
+  name = g_dir_read_name (d);
+  g_assert_nonnull (name);
+  g_assert_true (g_str_has_suffix (name, ".trace"));
+  path = g_build_filename (dir, name, NULL);
+  g_assert_null (g_dir_read_name (d));
+  g_dir_close (d);
+
+  return path;
+}
+
+static void
+test_edit_trace_round_trip (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GArray) events = NULL;
+  g_autofree char *dir = g_dir_make_tmp ("test-edit-trace-XXXXXX", &error);
+  g_autofree char *path = NULL;
+  const SpellingEditTraceEvent *event;
+
+  g_assert_no_error (error);
+
+  g_unsetenv ("LIBSPELLING_EDIT_TRACE_DIR");
+  g_assert_null (spelling_edit_trace_writer_new_from_env ());
+
+  path = record_trace (dir);
+  events = spelling_edit_trace_load (path, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (events);
+  g_assert_cmpuint (events->len, ==, 4);
+
+  event = &g_array_index (events, SpellingEditTraceEvent, 0);
+  g_assert_cmpint (event->kind, ==, SPELLING_EDIT_TRACE_INSERT);
+  g_assert_cmpuint (event->position, ==, 0);
+  g_assert_cmpstr (event->text, ==, "Hello wörld\n\t\"quoted\" \\ é");
+  g_assert_cmpuint (event->length, ==, g_utf8_strlen (event->text, -1));
+
+  event = &g_array_index (events, SpellingEditTraceEvent, 1);
+  g_assert_cmpint (event->kind, ==, SPELLING_EDIT_TRACE_CURSOR);
+  g_assert_cmpuint (event->position, ==, 5);
+
+  event = &g_array_index (events, SpellingEditTraceEvent, 2);
+  g_assert_cmpint (event->kind, ==, SPELLING_EDIT_TRACE_DELETE);
+  g_assert_cmpuint (event->position, ==, 3);
+  g_assert_cmpuint (event->length, ==, 2);
+
+  event = &g_array_index (events, SpellingEditTraceEvent, 3);
+  g_assert_cmpint (event->kind, ==, SPELLING_EDIT_TRACE_INSERT);
+  g_assert_cmpstr (event->text, ==, " ");
+
+  for (guint i = 1; i < events->len; i++)
+    g_assert_cmpint (g_array_index (events, SpellingEditTraceEvent, i - 1).time, <=,
+                     g_array_index (events, SpellingEditTraceEvent, i).time);
+
+  g_unlink (path);
+  g_rmdir (dir);
+}
+
+static void
+test_edit_trace_invalid (void)
+{
+  static const char *invalid[] = {
+    "not a trace\n",
+    "# libspelling edit trace 1\n10 x 0\n",
+    "# libspelling edit trace 1\n10 d 4\n",
+    "# libspelling edit trace 1\n10 c 4 extra\n",
+    "# libspelling edit trace 1\n10 c 1\n5 c 2\n",
+    "# libspelling edit trace 1\n10 i 0 \\377\n",
+  };
+  g_autoptr(GError) error = NULL;
+  g_autofree char *path = NULL;
+  int fd;
+
+  fd = g_file_open_tmp ("test-edit-trace-XXXXXX.trace", &path, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+
+  for (guint i = 0; i < G_N_ELEMENTS (invalid); i++)
+    {
+      g_autoptr(GArray) events = NULL;
+
+      g_file_set_contents (path, invalid[i], -1, &error);
+      g_assert_no_error (error);
+
+      events = spelling_edit_trace_load (path, &error);
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+      g_assert_null (events);
+      g_clear_error (&error);
+    }
+
+  g_unlink (path);
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Spelling/EditTrace/round-trip", test_edit_trace_round_trip);
+  g_test_add_func ("/Spelling/EditTrace/invalid", test_edit_trace_invalid);
+  return g_test_run ();
+}
@@ -33,6 +33,12 @@ static SpellingDictionary *dictionary;
 static guint cursor;
 static guint last_clear_position;
 static guint last_clear_length;
+static guint n_clear_tag;
+static guint n_apply_tag;
+static const char *extra_word;
+static guint visible_begin;
+static guint visible_end;
+static GArray *copied;
 
 typedef struct _TestDictionary
 {
@@ -65,6 +71,11 @@ test_dictionary_contains_word (SpellingDictionary *self,
   g_assert (word != NULL);
   g_assert (word_len >= 0);
 
+  if (extra_word != NULL &&
+      strlen (extra_word) == word_len &&
+      strncmp (word, extra_word, word_len) == 0)
+    return TRUE;
+
   return (word_len == 3 &&
           (strncmp (word, "foo", word_len) == 0 ||
            strncmp (word, "bar", word_len) == 0));
@@ -143,6 +154,12 @@ copy_text (gpointer instance,
   const char *begin = g_utf8_offset_to_pointer (buffer->str, position);
   const char *end = g_utf8_offset_to_pointer (begin, length);
 
+  if (copied != NULL)
+    {
+      SpellingBoundary range = { .offset = position, .length = length };
+      g_array_append_val (copied, range);
+    }
+
   return g_strndup (begin, end - begin);
 }
 
@@ -151,18 +168,24 @@ clear_tag (gpointer instance,
            guint    position,
            guint    length)
 {
+  n_clear_tag++;
+
   last_clear_position = position;
   last_clear_length = length;
 
   gtk_bitset_remove_range (mispelled, position, length);
 }
 
-static void
+static gboolean
 apply_tag (gpointer instance,
            guint    position,
            guint    length)
 {
+  n_apply_tag++;
+
   gtk_bitset_add_range (mispelled, position, length);
+
+  return TRUE;
 }
 
 static gboolean
@@ -286,6 +309,20 @@ check_enabled (gpointer instance)
   return TRUE;
 }
 
+static gboolean
+get_visible_range (gpointer  instance,
+                   guint    *begin,
+                   guint    *end)
+{
+  if (visible_begin == visible_end)
+    return FALSE;
+
+  *begin = visible_begin;
+  *end = visible_end;
+
+  return TRUE;
+}
+
 static const SpellingAdapter adapter = {
   .check_enabled = check_enabled,
   .get_cursor = get_cursor,
@@ -297,6 +334,7 @@ static const SpellingAdapter adapter = {
   .intersect_spellcheck_region = intersect_spellcheck_region,
   .get_dictionary = get_dictionary,
   .get_language = get_language,
+  .get_visible_range = get_visible_range,
 };
 
 static inline void
@@ -412,6 +450,348 @@ test_engine_delete_invalidates_joined_word (void)
   g_object_unref (dictionary);
 }
 
+static void
+assert_disjoint (GArray *ranges)
+{
+  for (guint i = 0; i < ranges->len; i++)
+    {
+      const SpellingBoundary *a = &g_array_index (ranges, SpellingBoundary, i);
+
+      for (guint j = i + 1; j < ranges->len; j++)
+        {
+          const SpellingBoundary *b = &g_array_index (ranges, SpellingBoundary, j);
+
+          g_assert_true (a->offset + a->length <= b->offset ||
+                         b->offset + b->length <= a->offset);
+        }
+    }
+}
+
+static void
+test_engine_visible_first (void)
+{
+  g_autoptr(SpellingEngine) engine = NULL;
+  g_autoptr(GObject) instance = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr(GString) text = g_string_new (NULL);
+
+  dictionary = g_object_new (test_dictionary_get_type (),
+                             "code", "en_US",
+                             NULL);
+
+  for (guint i = 0; i < 1000; i++)
+    g_string_append (text, "foo ");
+
+  buffer = g_string_new (NULL);
+  mispelled = gtk_bitset_new_empty ();
+  engine = spelling_engine_new (&adapter, instance);
+
+  visible_begin = 2000;
+  visible_end = 2200;
+  copied = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+
+  /* Leaves the cursor at the end of the buffer */
+  insert (engine, text->str, 0, text->str);
+
+  /* The word at the cursor comes first, then the visible text */
+  g_assert_cmpuint (copied->len, >=, 2);
+  g_assert_cmpuint (g_array_index (copied, SpellingBoundary, 0).offset, >=, 3990);
+  g_assert_cmpuint (g_array_index (copied, SpellingBoundary, 1).offset, <=, visible_begin);
+  g_assert_cmpuint (g_array_index (copied, SpellingBoundary, 1).offset, >=, visible_begin - 4);
+  g_assert_cmpuint (g_array_index (copied, SpellingBoundary, 1).offset +
+                    g_array_index (copied, SpellingBoundary, 1).length, >=, visible_end);
+
+  /* Nothing is collected twice */
+  assert_disjoint (copied);
+
+  g_clear_pointer (&copied, g_array_unref);
+  visible_begin = visible_end = 0;
+
+  g_string_free (buffer, TRUE);
+  gtk_bitset_unref (mispelled);
+  g_object_unref (dictionary);
+}
+
+static void
+test_engine_pipeline (void)
+{
+  g_autoptr(SpellingEngine) engine = NULL;
+  g_autoptr(GObject) instance = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr(GString) text = g_string_new (NULL);
+  guint n_copied;
+
+  dictionary = g_object_new (test_dictionary_get_type (),
+                             "code", "en_US",
+                             NULL);
+
+  for (guint i = 0; i < 4000; i++)
+    g_string_append (text, "foo ");
+
+  buffer = g_string_new (NULL);
+  mispelled = gtk_bitset_new_empty ();
+  engine = spelling_engine_new (&adapter, instance);
+  copied = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+
+  /* Jobs are not finished without a main loop, so every iteration
+   * starts another job until the pipeline is full.
+   */
+  insert (engine, text->str, 0, text->str);
+  for (guint i = 0; i < 8; i++)
+    spelling_engine_iteration (engine);
+
+  g_assert_cmpuint (copied->len, >, 1);
+  assert_disjoint (copied);
+
+  n_copied = copied->len;
+  spelling_engine_iteration (engine);
+  g_assert_cmpuint (copied->len, ==, n_copied);
+
+  /* Edits are forwarded to every job in flight */
+  insert (engine, "bar ", 0, NULL);
+  delete (engine, 0, 4, text->str);
+  g_assert_cmpuint (copied->len, ==, n_copied);
+
+  g_clear_pointer (&copied, g_array_unref);
+
+  g_string_free (buffer, TRUE);
+  gtk_bitset_unref (mispelled);
+  g_object_unref (dictionary);
+}
+
+static void
+wait_for_engine (SpellingEngine *engine)
+{
+  while (spelling_engine_get_busy (engine))
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+set_extra_word (const char *word)
+{
+  extra_word = word;
+
+  /* Start over so that no verdict is cached */
+  g_object_unref (dictionary);
+  dictionary = g_object_new (test_dictionary_get_type (),
+                             "code", "en_US",
+                             NULL);
+}
+
+static void
+test_engine_diff_tags (void)
+{
+  g_autoptr(SpellingEngine) engine = NULL;
+  g_autoptr(GObject) instance = g_object_new (G_TYPE_OBJECT, NULL);
+
+  dictionary = g_object_new (test_dictionary_get_type (),
+                             "code", "en_US",
+                             NULL);
+
+  buffer = g_string_new (NULL);
+  mispelled = gtk_bitset_new_empty ();
+  engine = spelling_engine_new (&adapter, instance);
+
+  insert (engine, "foo bar baz foo\nbar foo bar\n", 0, NULL);
+  wait_for_engine (engine);
+
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 3);
+  g_assert_true (gtk_bitset_contains (mispelled, 8));
+  g_assert_true (gtk_bitset_contains (mispelled, 10));
+
+  /* Checking the same text again must not touch the tags */
+  n_clear_tag = 0;
+  n_apply_tag = 0;
+  spelling_engine_invalidate_all (engine);
+  wait_for_engine (engine);
+  g_assert_cmpuint (n_clear_tag, ==, 0);
+  g_assert_cmpuint (n_apply_tag, ==, 0);
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 3);
+
+  /* Only what changed is updated */
+  set_extra_word ("baz");
+  spelling_engine_invalidate_all (engine);
+  wait_for_engine (engine);
+  g_assert_cmpuint (n_clear_tag, ==, 1);
+  g_assert_cmpuint (n_apply_tag, ==, 0);
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 0);
+
+  set_extra_word (NULL);
+  spelling_engine_invalidate_all (engine);
+  wait_for_engine (engine);
+  g_assert_cmpuint (n_clear_tag, ==, 1);
+  g_assert_cmpuint (n_apply_tag, ==, 1);
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 3);
+  g_assert_true (gtk_bitset_contains (mispelled, 8));
+
+  g_string_free (buffer, TRUE);
+  gtk_bitset_unref (mispelled);
+  g_object_unref (dictionary);
+}
+
+static void
+test_engine_requeue_discarded (void)
+{
+  g_autoptr(SpellingEngine) engine = NULL;
+  g_autoptr(GObject) instance = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr(GString) text = g_string_new (NULL);
+
+  dictionary = g_object_new (test_dictionary_get_type (),
+                             "code", "en_US",
+                             NULL);
+
+  for (guint i = 0; i < 500; i++)
+    g_string_append (text, "foo baz ");
+
+  buffer = g_string_new (NULL);
+  mispelled = gtk_bitset_new_empty ();
+  engine = spelling_engine_new (&adapter, instance);
+
+  insert (engine, text->str, 0, text->str);
+
+  /* Editing a fragment in flight over and over discards it, and what
+   * was not touched by the edits must still be checked in the end.
+   */
+  for (guint i = 0; i < 20; i++)
+    {
+      insert (engine, "x", 2, NULL);
+      delete (engine, 2, 1, NULL);
+    }
+
+  assert_string (text->str);
+  wait_for_engine (engine);
+
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 500 * 3);
+
+  for (guint i = 0; i < 500; i++)
+    g_assert_true (gtk_bitset_contains (mispelled, i * 8 + 4));
+
+  g_string_free (buffer, TRUE);
+  gtk_bitset_unref (mispelled);
+  g_object_unref (dictionary);
+}
+
+static void
+test_engine_recheck_word (void)
+{
+  g_autoptr(SpellingEngine) engine = NULL;
+  g_autoptr(GObject) instance = g_object_new (G_TYPE_OBJECT, NULL);
+
+  dictionary = g_object_new (test_dictionary_get_type (),
+                             "code", "en_US",
+                             NULL);
+
+  buffer = g_string_new (NULL);
+  mispelled = gtk_bitset_new_empty ();
+  engine = spelling_engine_new (&adapter, instance);
+
+  insert (engine, "baz foo qux\nbar baz foo\n", 0, NULL);
+  wait_for_engine (engine);
+
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 9);
+
+  /* Accepting a word only looks at where that word is tagged */
+  set_extra_word ("baz");
+  n_clear_tag = 0;
+  copied = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+  spelling_engine_recheck_word (engine, "baz");
+  g_assert_cmpuint (copied->len, ==, 2);
+  g_assert_cmpuint (n_clear_tag, ==, 2);
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 3);
+  g_assert_true (gtk_bitset_contains (mispelled, 8));
+  g_clear_pointer (&copied, g_array_unref);
+
+  wait_for_engine (engine);
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 3);
+
+  set_extra_word (NULL);
+  g_string_free (buffer, TRUE);
+  gtk_bitset_unref (mispelled);
+  g_object_unref (dictionary);
+}
+
+static void
+test_engine_recheck_in_flight (void)
+{
+  g_autoptr(SpellingEngine) engine = NULL;
+  g_autoptr(GObject) instance = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr(GString) text = g_string_new (NULL);
+
+  dictionary = g_object_new (test_dictionary_get_type (),
+                             "code", "en_US",
+                             NULL);
+
+  for (guint i = 0; i < 500; i++)
+    g_string_append (text, "baz qux ");
+
+  buffer = g_string_new (NULL);
+  mispelled = gtk_bitset_new_empty ();
+  engine = spelling_engine_new (&adapter, instance);
+
+  insert (engine, text->str, 0, text->str);
+
+  /* Results looked up before the word was accepted must not tag it */
+  while (gtk_bitset_get_size (mispelled) == 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  set_extra_word ("baz");
+  spelling_engine_recheck_word (engine, "baz");
+  wait_for_engine (engine);
+
+  g_assert_cmpuint (gtk_bitset_get_size (mispelled), ==, 500 * 3);
+
+  for (guint i = 0; i < 500; i++)
+    g_assert_true (gtk_bitset_contains (mispelled, i * 8 + 4));
+
+  set_extra_word (NULL);
+  g_string_free (buffer, TRUE);
+  gtk_bitset_unref (mispelled);
+  g_object_unref (dictionary);
+}
+
+static void
+test_engine_stats (void)
+{
+  g_autoptr(SpellingEngine) engine = NULL;
+  g_autoptr(SpellingCounters) counters = spelling_counters_new ();
+  g_autoptr(SpellingStats) stats = NULL;
+  g_autoptr(GObject) instance = g_object_new (G_TYPE_OBJECT, NULL);
+
+  dictionary = g_object_new (test_dictionary_get_type (),
+                             "code", "en_US",
+                             NULL);
+
+  buffer = g_string_new (NULL);
+  mispelled = gtk_bitset_new_empty ();
+  engine = spelling_engine_new (&adapter, instance);
+
+  insert (engine, "baz foo qux\nbar baz foo\n", 0, NULL);
+  wait_for_engine (engine);
+
+  stats = spelling_engine_dup_stats (engine);
+  g_assert_cmpuint (spelling_stats_get_words_checked (stats), >=, 6);
+  g_assert_cmpuint (spelling_stats_get_unique_words (stats), <=, spelling_stats_get_words_checked (stats));
+  g_assert_cmpuint (spelling_stats_get_dictionary_calls (stats) + spelling_stats_get_cache_hits (stats),
+                    ==, spelling_stats_get_unique_words (stats));
+  g_assert_cmpuint (spelling_stats_get_jobs_run (stats), >=, 1);
+  g_assert_cmpuint (spelling_stats_get_queue_depth (stats), ==, 0);
+  g_assert_cmpuint (spelling_stats_get_bytes_copied (stats), >=, buffer->len);
+  g_assert_cmpint (spelling_stats_get_job_latency (stats, 99), >=, spelling_stats_get_job_latency (stats, 50));
+  g_clear_pointer (&stats, spelling_stats_unref);
+
+  /* Percentiles are within a quarter of the real value */
+  for (guint i = 1; i <= 100; i++)
+    spelling_histogram_record (&counters->apply_latency, i);
+  stats = _spelling_stats_new (counters, 0);
+  g_assert_cmpint (spelling_stats_get_apply_latency (stats, 50), >=, 50);
+  g_assert_cmpint (spelling_stats_get_apply_latency (stats, 50), <=, 62);
+  g_assert_cmpint (spelling_stats_get_apply_latency (stats, 99), >=, 99);
+  g_assert_cmpint (spelling_stats_get_apply_latency (stats, 99), <=, 123);
+  g_assert_cmpint (spelling_stats_get_job_latency (stats, 50), ==, 0);
+
+  g_string_free (buffer, TRUE);
+  gtk_bitset_unref (mispelled);
+  g_object_unref (dictionary);
+}
+
 int
 main (int argc,
       char *argv[])
@@ -422,5 +802,12 @@ main (int argc,
   g_test_add_func ("/Spelling/Engine/basic", test_engine_basic);
   g_test_add_func ("/Spelling/Engine/delete_invalidates_joined_word",
                    test_engine_delete_invalidates_joined_word);
+  g_test_add_func ("/Spelling/Engine/visible_first", test_engine_visible_first);
+  g_test_add_func ("/Spelling/Engine/pipeline", test_engine_pipeline);
+  g_test_add_func ("/Spelling/Engine/diff_tags", test_engine_diff_tags);
+  g_test_add_func ("/Spelling/Engine/requeue_discarded", test_engine_requeue_discarded);
+  g_test_add_func ("/Spelling/Engine/recheck_word", test_engine_recheck_word);
+  g_test_add_func ("/Spelling/Engine/recheck_in_flight", test_engine_recheck_in_flight);
+  g_test_add_func ("/Spelling/Engine/stats", test_engine_stats);
   return g_test_run ();
 }
@@ -245,6 +245,38 @@ test_job_basic (void)
         { .offset = 16, .length = 8 },
       },
     },
+    { "misplled, word",
+      1,
+      (const SpellingBoundary[]) {
+        { .offset = 0, .length = 8 },
+      },
+    },
+    { "über alles ",
+      2,
+      (const SpellingBoundary[]) {
+        { .offset = 0, .length = 4 },
+        { .offset = 5, .length = 5 },
+      },
+    },
+    { "text\u00A0misplled word",
+      1,
+      (const SpellingBoundary[]) {
+        { .offset = 5, .length = 8 },
+      },
+    },
+    { "a misplled\u00ADword ",
+      1,
+      (const SpellingBoundary[]) {
+        { .offset = 2, .length = 13 },
+      },
+    },
+    { "this text has abc123 ",
+      2,
+      (const SpellingBoundary[]) {
+        { .offset = 14, .length = 3 },
+        { .offset = 17, .length = 3 },
+      },
+    },
   };
 
   for (guint i = 0; i < G_N_ELEMENTS (tests); i++)
@@ -268,6 +300,65 @@ test_job_basic (void)
     }
 }
 
+/* Checks @text as is and with its last character replaced by U+2003,
+ * which is white space like the original but keeps the fragment off the
+ * Latin-1 fast path. Both must find the same words.
+ */
+static void
+assert_latin_matches_pango (SpellingDictionary *dictionary,
+                            const char         *text)
+{
+  g_autofree char *latin = g_strconcat (text, " ", NULL);
+  g_autofree char *other = g_strconcat (text, "\u2003", NULL);
+  g_autoptr(GBytes) latin_bytes = g_bytes_new (latin, strlen (latin));
+  g_autoptr(GBytes) other_bytes = g_bytes_new (other, strlen (other));
+  g_autoptr(SpellingJob) latin_job = spelling_job_new (dictionary, pango_language_get_default ());
+  g_autoptr(SpellingJob) other_job = spelling_job_new (dictionary, pango_language_get_default ());
+  g_autofree SpellingBoundary *latin_fragments = NULL;
+  g_autofree SpellingBoundary *other_fragments = NULL;
+  g_autofree SpellingMistake *latin_mistakes = NULL;
+  g_autofree SpellingMistake *other_mistakes = NULL;
+  guint n_latin_fragments;
+  guint n_other_fragments;
+  guint n_latin_mistakes;
+  guint n_other_mistakes;
+
+  spelling_job_add_fragment (latin_job, latin_bytes, 0, g_utf8_strlen (latin, -1));
+  spelling_job_add_fragment (other_job, other_bytes, 0, g_utf8_strlen (other, -1));
+
+  spelling_job_run_sync (latin_job, &latin_fragments, &n_latin_fragments, &latin_mistakes, &n_latin_mistakes);
+  spelling_job_run_sync (other_job, &other_fragments, &n_other_fragments, &other_mistakes, &n_other_mistakes);
+
+  g_assert_cmpuint (n_latin_mistakes, ==, n_other_mistakes);
+
+  for (guint i = 0; i < n_latin_mistakes; i++)
+    {
+      g_assert_cmpuint (latin_mistakes[i].offset, ==, other_mistakes[i].offset);
+      g_assert_cmpuint (latin_mistakes[i].length, ==, other_mistakes[i].length);
+    }
+}
+
+static void
+test_job_latin (void)
+{
+  g_autoptr(SpellingProvider) provider = g_object_new (TEST_TYPE_PROVIDER, NULL);
+  const char *default_code = spelling_provider_get_default_code (provider);
+  g_autoptr(SpellingDictionary) dictionary = spelling_provider_load_dictionary (provider, default_code);
+  static const char *texts[] = {
+    "this text has a misplled word",
+    "misplled, word it' say' it's",
+    "über alles, Straße",
+    "text\u00A0misplled\u00ADword",
+    "mp3 abc123 2nd 4x4 a1b2c3 123",
+    "it's mp3's 3's x'2",
+    "x\u00B2y 3\u00BDcup \u00BDcup caf\u00E9s2",
+    "no\u00BA1 \u00B5s10 9\u00AD9 a\u00AD1",
+  };
+
+  for (guint i = 0; i < G_N_ELEMENTS (texts); i++)
+    assert_latin_matches_pango (dictionary, texts[i]);
+}
+
 static void
 test_job_discard (void)
 {
@@ -331,13 +422,14 @@ test_job_discard (void)
   g_clear_pointer (&mistakes, g_free);
   g_clear_object (&job);
 
-  /* Now try to do a DELETE that SHOULD collide */
+  /* Now try to do a DELETE that collides but leaves the mistake alone */
   job = spelling_job_new (dictionary, pango_language_get_default ());
   spelling_job_add_fragment (job, bytes, 0, 13);
   spelling_job_notify_delete (job, 13, 1);
   spelling_job_run_sync (job, NULL, NULL, &mistakes, &n_mistakes);
-  g_assert_cmpint (n_mistakes, ==, 0);
-  g_assert_null (mistakes);
+  g_assert_cmpint (n_mistakes, ==, 1);
+  g_assert_cmpint (mistakes[0].offset, ==, 0);
+  g_assert_cmpint (mistakes[0].length, ==, 8);
   g_clear_pointer (&mistakes, g_free);
   g_clear_object (&job);
 
@@ -353,6 +445,391 @@ test_job_discard (void)
   g_clear_object (&job);
 }
 
+static void
+test_job_parallel (void)
+{
+  g_autoptr(SpellingProvider) provider = g_object_new (TEST_TYPE_PROVIDER, NULL);
+  const char *default_code = spelling_provider_get_default_code (provider);
+  g_autoptr(SpellingDictionary) dictionary = spelling_provider_load_dictionary (provider, default_code);
+  g_autoptr(GBytes) good = g_bytes_new_static ("this text has a misspelled word ", 32);
+  g_autoptr(GBytes) bad = g_bytes_new_static ("this text has a misplled word ", 30);
+  g_autoptr(SpellingJob) job = NULL;
+  g_autofree SpellingMistake *mistakes = NULL;
+  g_autofree SpellingBoundary *fragments = NULL;
+  guint n_fragments = 0;
+  guint n_mistakes = 0;
+  guint position = 0;
+  guint n_bad = 0;
+
+  job = spelling_job_new (dictionary, pango_language_get_default ());
+
+  for (guint i = 0; i < 256; i++)
+    {
+      GBytes *bytes = (i % 3) ? good : bad;
+      gsize len = g_bytes_get_size (bytes);
+
+      spelling_job_add_fragment (job, bytes, position, len);
+      position += len;
+
+      if (bytes == bad)
+        n_bad++;
+    }
+
+  g_assert_cmpint (spelling_job_get_length (job), ==, position);
+  g_assert_cmpint (spelling_job_get_elapsed (job), ==, 0);
+
+  /* Invalidate all of the first fragment to make sure discards are honored */
+  spelling_job_invalidate (job, 0, 29);
+  n_bad--;
+
+  spelling_job_run_sync (job, &fragments, &n_fragments, &mistakes, &n_mistakes);
+  g_assert_cmpint (spelling_job_get_elapsed (job), >=, 0);
+  g_assert_cmpint (n_fragments, ==, 255);
+  g_assert_cmpint (n_mistakes, ==, n_bad);
+
+  /* Mistakes must come back in fragment order */
+  for (guint i = 0; i < n_mistakes; i++)
+    {
+      guint fragment = (i + 1) * 3;
+      guint expected = (fragment / 3) * 30 + (fragment - fragment / 3) * 32 + 16;
+
+      g_assert_cmpint (mistakes[i].offset, ==, expected);
+      g_assert_cmpint (mistakes[i].length, ==, 8);
+    }
+}
+
+/* Enough distinct words to be looked up in several batches */
+static void
+test_job_unique_batches (void)
+{
+  g_autoptr(SpellingProvider) provider = g_object_new (TEST_TYPE_PROVIDER, NULL);
+  const char *default_code = spelling_provider_get_default_code (provider);
+  g_autoptr(SpellingDictionary) dictionary = spelling_provider_load_dictionary (provider, default_code);
+  g_autoptr(SpellingJob) job = NULL;
+  g_autofree SpellingMistake *mistakes = NULL;
+  g_autofree SpellingBoundary *fragments = NULL;
+  guint n_fragments = 0;
+  guint n_mistakes = 0;
+  guint position = 0;
+
+  job = spelling_job_new (dictionary, pango_language_get_default ());
+
+  for (guint i = 0; i < 2000; i++)
+    {
+      g_autoptr(GBytes) bytes = NULL;
+      char *text;
+
+      /* "this zqXYZ text " with a different misspelling every time */
+      text = g_strdup_printf ("this zq%c%c%c text ",
+                              'a' + i % 26, 'a' + (i / 26) % 26, 'a' + i / 676);
+      bytes = g_bytes_new_take (text, strlen (text));
+
+      spelling_job_add_fragment (job, bytes, position, 16);
+      position += 16;
+    }
+
+  spelling_job_run_sync (job, &fragments, &n_fragments, &mistakes, &n_mistakes);
+  g_assert_cmpint (n_fragments, ==, 2000);
+  g_assert_cmpint (n_mistakes, ==, 2000);
+
+  for (guint i = 0; i < n_mistakes; i++)
+    {
+      g_assert_cmpint (mistakes[i].offset, ==, i * 16 + 5);
+      g_assert_cmpint (mistakes[i].length, ==, 5);
+    }
+}
+
+static void
+test_job_salvage (void)
+{
+  g_autoptr(SpellingProvider) provider = g_object_new (TEST_TYPE_PROVIDER, NULL);
+  const char *default_code = spelling_provider_get_default_code (provider);
+  g_autoptr(SpellingDictionary) dictionary = spelling_provider_load_dictionary (provider, default_code);
+  g_autoptr(GBytes) bytes = g_bytes_new_static ("misplled text wrod has a mispeled word ", 39);
+  g_autoptr(SpellingJob) job = NULL;
+  g_autofree SpellingMistake *mistakes = NULL;
+  g_autofree SpellingBoundary *fragments = NULL;
+  guint n_fragments = 0;
+  guint n_mistakes = 0;
+
+  /* Typing inside of "wrod" must only cost that word */
+  job = spelling_job_new (dictionary, pango_language_get_default ());
+  spelling_job_add_fragment (job, bytes, 10, 39);
+  spelling_job_notify_insert (job, 10 + 16, 2);
+  spelling_job_run_sync (job, &fragments, &n_fragments, &mistakes, &n_mistakes);
+  g_assert_cmpint (n_mistakes, ==, 2);
+  g_assert_cmpint (mistakes[0].offset, ==, 10);
+  g_assert_cmpint (mistakes[0].length, ==, 8);
+  g_assert_cmpint (mistakes[1].offset, ==, 10 + 25 + 2);
+  g_assert_cmpint (mistakes[1].length, ==, 8);
+  g_assert_cmpint (n_fragments, ==, 2);
+  g_assert_cmpint (fragments[0].offset, ==, 10);
+  g_assert_cmpint (fragments[0].length, ==, 14);
+  g_assert_cmpint (fragments[1].offset, ==, 10 + 18 + 2);
+  g_assert_cmpint (fragments[1].length, ==, 21);
+  g_clear_pointer (&mistakes, g_free);
+  g_clear_pointer (&fragments, g_free);
+  g_clear_object (&job);
+
+  /* Deleting the start of the fragment shifts what remains, which ends
+   * up at the offset it had within the fragment.
+   */
+  job = spelling_job_new (dictionary, pango_language_get_default ());
+  spelling_job_add_fragment (job, bytes, 10, 39);
+  spelling_job_notify_delete (job, 5, 10);
+  spelling_job_run_sync (job, &fragments, &n_fragments, &mistakes, &n_mistakes);
+  g_assert_cmpint (n_mistakes, ==, 2);
+  g_assert_cmpint (mistakes[0].offset, ==, 14);
+  g_assert_cmpint (mistakes[0].length, ==, 4);
+  g_assert_cmpint (mistakes[1].offset, ==, 25);
+  g_assert_cmpint (mistakes[1].length, ==, 8);
+  g_assert_cmpint (n_fragments, ==, 1);
+  g_assert_cmpint (fragments[0].offset, ==, 8);
+  g_assert_cmpint (fragments[0].length, ==, 31);
+  g_clear_pointer (&mistakes, g_free);
+  g_clear_pointer (&fragments, g_free);
+  g_clear_object (&job);
+}
+
+typedef struct
+{
+  GArray *fragments;
+  GArray *mistakes;
+} ProgressState;
+
+static void
+job_progress (SpellingJob            *job,
+              const SpellingBoundary *fragments,
+              guint                   n_fragments,
+              const SpellingMistake  *mistakes,
+              guint                   n_mistakes,
+              gpointer                user_data)
+{
+  ProgressState *state = user_data;
+
+  g_assert (SPELLING_IS_JOB (job));
+
+  g_array_append_vals (state->fragments, fragments, n_fragments);
+  g_array_append_vals (state->mistakes, mistakes, n_mistakes);
+}
+
+static void
+job_progress_finished (GObject      *object,
+                       GAsyncResult *result,
+                       gpointer      user_data)
+{
+  g_autofree SpellingMistake *mistakes = NULL;
+  g_autofree SpellingBoundary *fragments = NULL;
+  ProgressState *state = user_data;
+  guint n_mistakes;
+  guint n_fragments;
+
+  spelling_job_run_finish (SPELLING_JOB (object), result, &fragments, &n_fragments, &mistakes, &n_mistakes);
+
+  g_array_append_vals (state->fragments, fragments, n_fragments);
+  g_array_append_vals (state->mistakes, mistakes, n_mistakes);
+
+  g_main_loop_quit (main_loop);
+}
+
+static void
+test_job_progress (void)
+{
+  g_autoptr(SpellingProvider) provider = g_object_new (TEST_TYPE_PROVIDER, NULL);
+  const char *default_code = spelling_provider_get_default_code (provider);
+  g_autoptr(SpellingDictionary) dictionary = spelling_provider_load_dictionary (provider, default_code);
+  g_autoptr(GBytes) good = g_bytes_new_static ("this text has a misspelled word ", 32);
+  g_autoptr(GBytes) bad = g_bytes_new_static ("this text has a misplled word ", 30);
+  g_autoptr(SpellingJob) job = NULL;
+  ProgressState state;
+  guint position = 0;
+  guint n_bad = 0;
+
+  state.fragments = g_array_new (FALSE, FALSE, sizeof (SpellingBoundary));
+  state.mistakes = g_array_new (FALSE, FALSE, sizeof (SpellingMistake));
+
+  job = spelling_job_new (dictionary, pango_language_get_default ());
+
+  for (guint i = 0; i < 300; i++)
+    {
+      GBytes *bytes = (i % 3) ? good : bad;
+      gsize len = g_bytes_get_size (bytes);
+
+      spelling_job_add_fragment (job, bytes, position, len);
+      position += len;
+
+      if (bytes == bad)
+        n_bad++;
+    }
+
+  spelling_job_set_progress_func (job, job_progress, &state, NULL);
+  spelling_job_run (job, job_progress_finished, &state);
+  g_main_loop_run (main_loop);
+
+  /* Nothing may be delivered once the job is finished */
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+
+  /* Whatever was delivered early plus the remainder must add up to the
+   * whole job, still in fragment order.
+   */
+  g_assert_cmpint (state.fragments->len, ==, 300);
+  g_assert_cmpint (state.mistakes->len, ==, n_bad);
+
+  for (guint i = 0; i < state.fragments->len; i++)
+    {
+      const SpellingBoundary *fragment = &g_array_index (state.fragments, SpellingBoundary, i);
+
+      guint n_bad_before = (i + 2) / 3;
+
+      g_assert_cmpint (fragment->offset, ==, n_bad_before * 30 + (i - n_bad_before) * 32);
+    }
+
+  for (guint i = 0; i < state.mistakes->len; i++)
+    {
+      const SpellingMistake *mistake = &g_array_index (state.mistakes, SpellingMistake, i);
+
+      g_assert_cmpint (mistake->offset, ==, i * (30 + 64) + 16);
+      g_assert_cmpint (mistake->length, ==, 8);
+    }
+
+  g_array_unref (state.fragments);
+  g_array_unref (state.mistakes);
+}
+
+typedef struct
+{
+  guint position;
+  guint length;
+  gboolean touched;
+  gboolean discarded;
+} ModelFragment;
+
+static void
+test_job_edits (void)
+{
+  g_autoptr(SpellingProvider) provider = g_object_new (TEST_TYPE_PROVIDER, NULL);
+  const char *default_code = spelling_provider_get_default_code (provider);
+  g_autoptr(SpellingDictionary) dictionary = spelling_provider_load_dictionary (provider, default_code);
+  g_autoptr(GBytes) bytes = g_bytes_new_static ("word ", 5);
+
+  /* Compare the indexed fragment adjustments against a linear model
+   * of the insert, delete and invalidate rules. Fragments which were
+   * not touched must come back as-is while anything salvaged from a
+   * touched fragment must stay within what is left of it.
+   */
+  for (guint iter = 0; iter < 100; iter++)
+    {
+      g_autoptr(SpellingJob) job = spelling_job_new (dictionary, pango_language_get_default ());
+      g_autofree SpellingMistake *mistakes = NULL;
+      g_autofree SpellingBoundary *fragments = NULL;
+      g_autofree ModelFragment *model = NULL;
+      guint n_fragments = 0;
+      guint n_mistakes = 0;
+      guint n_model = g_test_rand_int_range (1, 50);
+      guint n_edits = g_test_rand_int_range (0, 16);
+      guint position = g_test_rand_int_range (0, 100);
+      guint pos = 0;
+
+      model = g_new0 (ModelFragment, n_model);
+
+      for (guint i = 0; i < n_model; i++)
+        {
+          model[i].position = position;
+          model[i].length = g_test_rand_int_range (0, 200);
+          spelling_job_add_fragment (job, bytes, model[i].position, model[i].length);
+          position += model[i].length + g_test_rand_int_range (1, 100);
+        }
+
+      for (guint e = 0; e < n_edits; e++)
+        {
+          guint op = g_test_rand_int_range (0, 3);
+          guint begin = g_test_rand_int_range (0, position);
+          guint length = g_test_rand_int_range (1, 50);
+
+          if (op == 0)
+            spelling_job_notify_insert (job, begin, length);
+          else if (op == 1)
+            spelling_job_notify_delete (job, begin, length);
+          else
+            spelling_job_invalidate (job, begin, length);
+
+          for (guint i = 0; i < n_model; i++)
+            {
+              ModelFragment *f = &model[i];
+
+              if (f->discarded || begin > f->position + f->length)
+                continue;
+
+              if (op == 0)
+                {
+                  if (begin < f->position)
+                    {
+                      f->position += length;
+                    }
+                  else
+                    {
+                      f->length += length;
+                      f->touched = TRUE;
+                    }
+                }
+              else if (op == 1)
+                {
+                  if (begin + length < f->position)
+                    {
+                      f->position -= length;
+                    }
+                  else
+                    {
+                      guint overlap_begin = MAX (begin, f->position);
+                      guint overlap_end = MIN (begin + length, f->position + f->length);
+
+                      if (overlap_end > overlap_begin)
+                        f->length -= overlap_end - overlap_begin;
+
+                      f->position = MIN (f->position, begin);
+                      f->discarded = f->length == 0;
+                      f->touched = TRUE;
+                    }
+                }
+              else if (begin + length >= f->position)
+                {
+                  f->touched = TRUE;
+                }
+            }
+        }
+
+      spelling_job_run_sync (job, &fragments, &n_fragments, &mistakes, &n_mistakes);
+
+      g_assert_cmpint (n_mistakes, ==, 0);
+
+      for (guint i = 0; i < n_model; i++)
+        {
+          if (model[i].discarded)
+            continue;
+
+          if (!model[i].touched)
+            {
+              g_assert_cmpint (pos, <, n_fragments);
+              g_assert_cmpint (fragments[pos].offset, ==, model[i].position);
+              g_assert_cmpint (fragments[pos].length, ==, model[i].length);
+              pos++;
+              continue;
+            }
+
+          while (pos < n_fragments &&
+                 fragments[pos].offset >= model[i].position &&
+                 fragments[pos].offset + fragments[pos].length <= model[i].position + model[i].length)
+            {
+              g_assert_cmpint (fragments[pos].length, >, 0);
+              pos++;
+            }
+        }
+
+      g_assert_cmpint (pos, ==, n_fragments);
+    }
+}
+
 int
 main (int argc,
       char *argv[])
@@ -365,6 +842,12 @@ main (int argc,
 
   g_test_init (&argc, &argv, NULL);
   g_test_add_func ("/Spelling/Job/basic", test_job_basic);
+  g_test_add_func ("/Spelling/Job/latin", test_job_latin);
   g_test_add_func ("/Spelling/Job/discard", test_job_discard);
+  g_test_add_func ("/Spelling/Job/parallel", test_job_parallel);
+  g_test_add_func ("/Spelling/Job/unique-batches", test_job_unique_batches);
+  g_test_add_func ("/Spelling/Job/salvage", test_job_salvage);
+  g_test_add_func ("/Spelling/Job/progress", test_job_progress);
+  g_test_add_func ("/Spelling/Job/edits", test_job_edits);
   return g_test_run ();
 }
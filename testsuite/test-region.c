@@ -682,6 +682,116 @@ full_tail_node (void)
   _cjh_text_region_free (region);
 }
 
+static gboolean
+tracked_join (gsize                   offset,
+              const CjhTextRegionRun *left,
+              const CjhTextRegionRun *right)
+{
+  return left->data == right->data;
+}
+
+typedef struct
+{
+  gpointer data;
+  gsize    offset;
+  gsize    tracked;
+  gsize    begin;
+  gsize    end;
+  gboolean found;
+} TrackedState;
+
+static gboolean
+tracked_foreach_cb (gsize                   offset,
+                    const CjhTextRegionRun *run,
+                    gpointer                user_data)
+{
+  TrackedState *state = user_data;
+
+  if (run->data != state->data)
+    return FALSE;
+
+  state->tracked += run->length;
+
+  if (!state->found && offset + run->length > state->offset)
+    {
+      state->begin = MAX (offset, state->offset);
+      state->end = offset + run->length;
+      state->found = TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+assert_tracked (CjhTextRegion *region,
+                gsize          offset)
+{
+  TrackedState state = { _cjh_text_region_get_tracked (region), offset };
+  gsize begin = 0;
+  gsize end = 0;
+  gboolean found;
+
+  _cjh_text_region_foreach (region, tracked_foreach_cb, &state);
+  found = _cjh_text_region_find_tracked (region, offset, &begin, &end);
+
+  g_assert_cmpint (_cjh_text_region_get_tracked_length (region), ==, state.tracked);
+  g_assert_cmpint (found, ==, state.found);
+
+  if (found)
+    {
+      g_assert_cmpint (begin, ==, state.begin);
+      g_assert_cmpint (end, ==, state.end);
+    }
+}
+
+static void
+random_tracked (void)
+{
+  CjhTextRegion *region = _cjh_text_region_new (tracked_join, NULL);
+  gsize begin;
+  gsize end;
+
+  _cjh_text_region_set_tracked (region, GUINT_TO_POINTER (1));
+  g_assert_false (_cjh_text_region_find_tracked (region, 0, &begin, &end));
+
+  for (guint i = 0; i < 20000; i++)
+    {
+      gsize length = _cjh_text_region_get_length (region);
+      gpointer data = GUINT_TO_POINTER (g_random_int_range (0, 3));
+      guint pos = g_random_int_range (0, length + 1);
+      guint len = g_random_int_range (1, 50);
+
+      /* Favor inserts so that the tree grows a few levels deep */
+      switch (length > 0 ? g_random_int_range (0, 5) : 0)
+        {
+        case 0:
+        case 1:
+          _cjh_text_region_insert (region, pos, len, data);
+          break;
+
+        case 2:
+          pos = MIN (pos, length - 1);
+          len = MIN (len, length - pos);
+          _cjh_text_region_remove (region, pos, len);
+          break;
+
+        default:
+          pos = MIN (pos, length - 1);
+          len = MIN (len, length - pos);
+          _cjh_text_region_replace (region, pos, len, data);
+          break;
+        }
+
+      assert_tracked (region, g_random_int_range (0, _cjh_text_region_get_length (region) + 1));
+    }
+
+  _cjh_text_region_replace (region, 0, _cjh_text_region_get_length (region), NULL);
+  g_assert_cmpint (_cjh_text_region_get_tracked_length (region), ==, 0);
+  g_assert_false (_cjh_text_region_find_tracked (region, 0, &begin, &end));
+
+  _cjh_text_region_free (region);
+}
+
 int
 main (int argc,
       char *argv[])
@@ -700,5 +810,6 @@ main (int argc,
   g_test_add_func ("/Cjh/TextRegion/words_database", test_words_database);
   g_test_add_func ("/Cjh/TextRegion/get_run_at_offset", get_run_at_offset);
   g_test_add_func ("/Cjh/TextRegion/full_tail_node", full_tail_node);
+  g_test_add_func ("/Cjh/TextRegion/random_tracked", random_tracked);
   return g_test_run ();
 }
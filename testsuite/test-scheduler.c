@@ -0,0 +1,190 @@
+/* test-scheduler.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <libspelling.h>
+
+#include "spelling-scheduler-private.h"
+
+static GMutex mutex;
+static GCond cond;
+static gboolean gate_open;
+static GArray *order;
+static guint n_completed;
+static guint n_cancelled;
+
+static int owner_a;
+static int owner_b;
+static int owner_c;
+
+static void
+record_thread_func (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  int value = GPOINTER_TO_INT (task_data);
+
+  /* Everything waits for the gate so that the first task keeps the only
+   * worker busy while the rest is queued.
+   */
+  g_mutex_lock (&mutex);
+  while (!gate_open)
+    g_cond_wait (&cond, &mutex);
+  g_array_append_val (order, value);
+  g_mutex_unlock (&mutex);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+completed_cb (GObject      *object,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+      n_cancelled++;
+    }
+
+  n_completed++;
+}
+
+static void
+push (SpellingScheduler *scheduler,
+      gconstpointer      owner,
+      int                value)
+{
+  g_autoptr(GTask) task = g_task_new (NULL, NULL, completed_cb, NULL);
+
+  g_task_set_task_data (task, GINT_TO_POINTER (value), NULL);
+  spelling_scheduler_push (scheduler, owner, task, record_thread_func);
+}
+
+static void
+setup (void)
+{
+  order = g_array_new (FALSE, FALSE, sizeof (int));
+  gate_open = FALSE;
+  n_completed = 0;
+  n_cancelled = 0;
+}
+
+static void
+open_gate_and_wait (guint n_tasks)
+{
+  g_mutex_lock (&mutex);
+  gate_open = TRUE;
+  g_cond_broadcast (&cond);
+  g_mutex_unlock (&mutex);
+
+  while (n_completed < n_tasks)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+assert_order (const int *expected,
+              guint      n_expected)
+{
+  g_assert_cmpuint (order->len, ==, n_expected);
+
+  for (guint i = 0; i < n_expected; i++)
+    g_assert_cmpint (g_array_index (order, int, i), ==, expected[i]);
+
+  g_clear_pointer (&order, g_array_unref);
+}
+
+static void
+test_scheduler_priority (void)
+{
+  static const int expected[] = { 0, 3, 2, 1 };
+  g_autoptr(SpellingScheduler) scheduler = spelling_scheduler_new (1);
+
+  setup ();
+
+  g_assert_cmpint (spelling_scheduler_get_priority (scheduler, &owner_a), ==, SPELLING_SCHEDULER_PRIORITY_VISIBLE);
+
+  spelling_scheduler_set_priority (scheduler, &owner_b, SPELLING_SCHEDULER_PRIORITY_BACKGROUND);
+
+  push (scheduler, &owner_a, 0);
+  push (scheduler, &owner_b, 1);
+  push (scheduler, &owner_a, 2);
+
+  /* Raising the priority applies to work that is already queued */
+  push (scheduler, &owner_c, 3);
+  spelling_scheduler_set_priority (scheduler, &owner_c, SPELLING_SCHEDULER_PRIORITY_FOCUSED);
+
+  open_gate_and_wait (4);
+  assert_order (expected, G_N_ELEMENTS (expected));
+}
+
+static void
+test_scheduler_fairness (void)
+{
+  static const int expected[] = { 0, 10, 20, 11, 21, 12 };
+  g_autoptr(SpellingScheduler) scheduler = spelling_scheduler_new (1);
+
+  setup ();
+
+  push (scheduler, &owner_c, 0);
+  push (scheduler, &owner_a, 10);
+  push (scheduler, &owner_a, 11);
+  push (scheduler, &owner_a, 12);
+  push (scheduler, &owner_b, 20);
+  push (scheduler, &owner_b, 21);
+
+  open_gate_and_wait (6);
+  assert_order (expected, G_N_ELEMENTS (expected));
+}
+
+static void
+test_scheduler_cancel (void)
+{
+  static const int expected[] = { 0, 20 };
+  g_autoptr(SpellingScheduler) scheduler = spelling_scheduler_new (1);
+
+  setup ();
+
+  push (scheduler, &owner_c, 0);
+  push (scheduler, &owner_a, 10);
+  push (scheduler, &owner_a, 11);
+  push (scheduler, &owner_b, 20);
+
+  spelling_scheduler_cancel (scheduler, &owner_a);
+
+  open_gate_and_wait (4);
+  assert_order (expected, G_N_ELEMENTS (expected));
+  g_assert_cmpuint (n_cancelled, ==, 2);
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Spelling/Scheduler/priority", test_scheduler_priority);
+  g_test_add_func ("/Spelling/Scheduler/fairness", test_scheduler_fairness);
+  g_test_add_func ("/Spelling/Scheduler/cancel", test_scheduler_cancel);
+  return g_test_run ();
+}
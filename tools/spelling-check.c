@@ -0,0 +1,441 @@
+/* spelling-check.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libspelling.h>
+
+#include "spelling-checker-private.h"
+#include "spelling-job-private.h"
+
+/* Files are mapped into memory and cut into chunks of about CHUNK_SIZE
+ * bytes at line ends, so that large files are spread over every thread
+ * just like many small ones. Each chunk is checked by a SpellingJob, the
+ * same as text from an editor. Results are printed in order as soon as
+ * the chunks they come from are done, and each file is released once
+ * all of its results have been printed.
+ */
+#define CHUNK_SIZE (256 * 1024)
+
+typedef struct _CheckFile
+{
+  char        *path;
+  GMappedFile *mapped;
+  GBytes      *bytes;
+  GError      *error;
+} CheckFile;
+
+typedef struct _CheckResult
+{
+  guint line;
+  guint column;
+  gsize byte_offset;
+  gsize byte_length;
+} CheckResult;
+
+typedef struct _CheckChunk
+{
+  CheckFile *file;
+  gsize      begin;
+  gsize      end;
+  guint      n_lines;
+  GArray    *results;
+  gboolean   invalid;
+  gboolean   done;
+} CheckChunk;
+
+static SpellingDictionary *dictionary;
+static PangoLanguage *language;
+static GMutex done_mutex;
+static GCond done_cond;
+
+static void
+check_file_free (CheckFile *file)
+{
+  g_clear_pointer (&file->path, g_free);
+  g_clear_pointer (&file->bytes, g_bytes_unref);
+  g_clear_pointer (&file->mapped, g_mapped_file_unref);
+  g_clear_error (&file->error);
+  g_free (file);
+}
+
+static void
+check_chunk_free (CheckChunk *chunk)
+{
+  g_clear_pointer (&chunk->results, g_array_unref);
+  g_free (chunk);
+}
+
+/* Returns the number of newlines between @p and @end */
+static guint
+count_lines (const char *p,
+             const char *end)
+{
+  guint n_lines = 0;
+
+  for (; (p = memchr (p, '\n', end - p)); p++)
+    n_lines++;
+
+  return n_lines;
+}
+
+static void
+check_chunk_run (CheckChunk *chunk)
+{
+  g_autoptr(SpellingJob) job = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autofree SpellingBoundary *fragments = NULL;
+  g_autofree SpellingMistake *mistakes = NULL;
+  const char *text;
+  const char *p;
+  guint n_fragments = 0;
+  guint n_mistakes = 0;
+  guint offset = 0;
+  guint line = 0;
+  guint line_start = 0;
+  gsize len;
+
+  text = (const char *)g_bytes_get_data (chunk->file->bytes, NULL) + chunk->begin;
+  len = chunk->end - chunk->begin;
+
+  /* Later chunks still need the lines of this one for their numbers */
+  if (!g_utf8_validate_len (text, len, NULL))
+    {
+      chunk->n_lines = count_lines (text, text + len);
+      chunk->invalid = TRUE;
+      return;
+    }
+
+  bytes = g_bytes_new_from_bytes (chunk->file->bytes, chunk->begin, len);
+
+  job = spelling_job_new (dictionary, language);
+  spelling_job_add_fragment (job, bytes, 0, g_utf8_strlen (text, len));
+  spelling_job_run_sync (job, &fragments, &n_fragments, &mistakes, &n_mistakes);
+
+  /* Mistakes are in order, so lines are counted in a single pass */
+  p = text;
+
+  for (guint m = 0; m < n_mistakes; m++)
+    {
+      CheckResult result;
+
+      for (; offset < mistakes[m].offset; offset++)
+        {
+          if (*p == '\n')
+            {
+              line++;
+              line_start = offset + 1;
+            }
+
+          p = g_utf8_next_char (p);
+        }
+
+      result.line = line;
+      result.column = offset - line_start;
+      result.byte_offset = p - text;
+      result.byte_length = g_utf8_offset_to_pointer (p, mistakes[m].length) - p;
+
+      g_array_append_val (chunk->results, result);
+    }
+
+  chunk->n_lines = line + count_lines (p, text + len);
+}
+
+/* Runs on the thread pool */
+static void
+check_chunk (gpointer data,
+             gpointer user_data)
+{
+  CheckChunk *chunk = data;
+
+  check_chunk_run (chunk);
+
+  g_mutex_lock (&done_mutex);
+  chunk->done = TRUE;
+  g_cond_broadcast (&done_cond);
+  g_mutex_unlock (&done_mutex);
+}
+
+/* Blocks until @chunk has been checked */
+static void
+check_chunk_wait (CheckChunk *chunk)
+{
+  g_mutex_lock (&done_mutex);
+  while (!chunk->done)
+    g_cond_wait (&done_cond, &done_mutex);
+  g_mutex_unlock (&done_mutex);
+}
+
+static gboolean
+check_file_open (CheckFile *file)
+{
+  if (!(file->mapped = g_mapped_file_new (file->path, FALSE, &file->error)))
+    return FALSE;
+
+  file->bytes = g_mapped_file_get_bytes (file->mapped);
+
+  return TRUE;
+}
+
+/* Cuts @file into chunks ending at line ends */
+static void
+check_file_split (CheckFile *file,
+                  GPtrArray *chunks)
+{
+  const char *text = g_bytes_get_data (file->bytes, NULL);
+  gsize len = g_bytes_get_size (file->bytes);
+  gsize begin = 0;
+
+  while (begin < len)
+    {
+      CheckChunk *chunk;
+      gsize end = len;
+
+      if (len - begin > CHUNK_SIZE)
+        {
+          const char *nl = memchr (text + begin + CHUNK_SIZE, '\n', len - begin - CHUNK_SIZE);
+
+          if (nl != NULL)
+            end = nl - text + 1;
+        }
+
+      chunk = g_new0 (CheckChunk, 1);
+      chunk->file = file;
+      chunk->begin = begin;
+      chunk->end = end;
+      chunk->results = g_array_new (FALSE, FALSE, sizeof (CheckResult));
+      g_ptr_array_add (chunks, chunk);
+
+      begin = end;
+    }
+}
+
+static void
+print_json_string (GString    *out,
+                   const char *str,
+                   gssize      len)
+{
+  const char *end = str + (len < 0 ? strlen (str) : (gsize)len);
+
+  g_string_append_c (out, '"');
+
+  for (const char *p = str; p < end; p++)
+    {
+      switch (*p)
+        {
+        case '"':
+          g_string_append (out, "\\\"");
+          break;
+
+        case '\\':
+          g_string_append (out, "\\\\");
+          break;
+
+        case '\n':
+          g_string_append (out, "\\n");
+          break;
+
+        case '\t':
+          g_string_append (out, "\\t");
+          break;
+
+        default:
+          if ((guchar)*p < 0x20)
+            g_string_append_printf (out, "\\u%04x", (guchar)*p);
+          else
+            g_string_append_c (out, *p);
+        }
+    }
+
+  g_string_append_c (out, '"');
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(SpellingChecker) checker = NULL;
+  g_autoptr(GPtrArray) files = NULL;
+  g_autoptr(GPtrArray) chunks = NULL;
+  g_autoptr(GString) out = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree char *language_code = NULL;
+  GThreadPool *pool;
+  gboolean json = FALSE;
+  gboolean first = TRUE;
+  int n_threads = 0;
+  int status = EXIT_SUCCESS;
+  guint c = 0;
+
+  const GOptionEntry entries[] = {
+    { "language", 'l', 0, G_OPTION_ARG_STRING, &language_code, "The language to check with, such as en_US", "CODE" },
+    { "json", 0, 0, G_OPTION_ARG_NONE, &json, "Print mistakes as JSON", NULL },
+    { "jobs", 'j', 0, G_OPTION_ARG_INT, &n_threads, "The number of threads to use", "N" },
+    { 0 }
+  };
+
+  setlocale (LC_ALL, "");
+
+  spelling_init ();
+
+  context = g_option_context_new ("FILE… - check the spelling of files");
+  g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+  g_option_context_set_description (context,
+                                    "Mistakes are printed as FILE:LINE:COLUMN: WORD, with columns\n"
+                                    "counted in characters. The exit status is 1 if any mistake\n"
+                                    "was found and 2 if a file could not be checked.");
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 2;
+    }
+
+  if (argc < 2)
+    {
+      g_autofree char *help = g_option_context_get_help (context, TRUE, NULL);
+      g_printerr ("%s", help);
+      return 2;
+    }
+
+  checker = spelling_checker_new (NULL, language_code);
+
+  if (!(dictionary = _spelling_checker_get_dictionary (checker)))
+    {
+      const char *code = spelling_checker_get_language (checker);
+
+      g_printerr ("No dictionary available for %s\n",
+                  code ? code : "the default language");
+      return 2;
+    }
+
+  language = _spelling_checker_get_pango_language (checker);
+
+  if (n_threads <= 0)
+    n_threads = g_get_num_processors ();
+
+  files = g_ptr_array_new_with_free_func ((GDestroyNotify)check_file_free);
+  chunks = g_ptr_array_new_with_free_func ((GDestroyNotify)check_chunk_free);
+
+  for (int i = 1; i < argc; i++)
+    {
+      CheckFile *file = g_new0 (CheckFile, 1);
+
+      file->path = g_strdup (argv[i]);
+      g_ptr_array_add (files, file);
+
+      if (check_file_open (file))
+        check_file_split (file, chunks);
+    }
+
+  pool = g_thread_pool_new (check_chunk, NULL, n_threads, TRUE, NULL);
+
+  for (guint i = 0; i < chunks->len; i++)
+    g_thread_pool_push (pool, g_ptr_array_index (chunks, i), NULL);
+
+  out = g_string_new (json ? "[" : NULL);
+
+  for (guint f = 0; f < files->len; f++)
+    {
+      CheckFile *file = g_ptr_array_index (files, f);
+      const char *text = file->bytes ? g_bytes_get_data (file->bytes, NULL) : NULL;
+      guint base_line = 1;
+
+      if (file->error != NULL)
+        {
+          g_printerr ("%s: %s\n", file->path, file->error->message);
+          status = 2;
+          continue;
+        }
+
+      for (; c < chunks->len; c++)
+        {
+          CheckChunk *chunk = g_ptr_array_index (chunks, c);
+
+          if (chunk->file != file)
+            break;
+
+          check_chunk_wait (chunk);
+
+          if (chunk->invalid)
+            {
+              g_printerr ("%s:%u: not valid UTF-8\n", file->path, base_line);
+              status = 2;
+            }
+
+          for (guint r = 0; r < chunk->results->len; r++)
+            {
+              const CheckResult *result = &g_array_index (chunk->results, CheckResult, r);
+              const char *word = text + chunk->begin + result->byte_offset;
+
+              if (status == EXIT_SUCCESS)
+                status = EXIT_FAILURE;
+
+              if (json)
+                {
+                  g_string_append (out, first ? "\n  {\"file\": " : ",\n  {\"file\": ");
+                  print_json_string (out, file->path, -1);
+                  g_string_append_printf (out, ", \"line\": %u, \"column\": %u, \"word\": ",
+                                          base_line + result->line, result->column + 1);
+                  print_json_string (out, word, result->byte_length);
+                  g_string_append_c (out, '}');
+                }
+              else
+                {
+                  g_string_append_printf (out, "%s:%u:%u: %.*s\n",
+                                          file->path,
+                                          base_line + result->line,
+                                          result->column + 1,
+                                          (int)result->byte_length, word);
+                }
+
+              first = FALSE;
+            }
+
+          base_line += chunk->n_lines;
+          g_clear_pointer (&chunk->results, g_array_unref);
+
+          /* Print as we go rather than holding all output until the end */
+          if (out->len > 64 * 1024)
+            {
+              fwrite (out->str, 1, out->len, stdout);
+              g_string_truncate (out, 0);
+            }
+        }
+
+      /* Every chunk of the file has been printed, so unmap it */
+      g_clear_pointer (&file->bytes, g_bytes_unref);
+      g_clear_pointer (&file->mapped, g_mapped_file_unref);
+    }
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  if (json)
+    g_string_append (out, first ? "]\n" : "\n]\n");
+
+  fwrite (out->str, 1, out->len, stdout);
+
+  return status;
+}
@@ -0,0 +1,316 @@
+/* spelling-replay.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <locale.h>
+#include <stdlib.h>
+
+#include <libspelling.h>
+
+#include "spelling-checker-private.h"
+#include "spelling-document-private.h"
+#include "spelling-edit-trace-private.h"
+
+/* Replays an edit trace recorded by SpellingTextBufferAdapter (see
+ * LIBSPELLING_EDIT_TRACE_DIR) against a SpellingDocument, which drives
+ * the same engine without a widget.
+ *
+ * Replay runs on a virtual clock. While the engine is busy, the clock
+ * follows the real time it takes to run the main loop and to wait for
+ * workers, but never waits past the time of the next event. While the
+ * engine is idle, the clock skips ahead to the next event, so long
+ * traces replay as fast as the engine can keep up with them. An event
+ * which is delivered later than it was recorded, because the main loop
+ * was still busy, counts as input lag.
+ */
+#define CLEAN_TIMEOUT (60 * G_USEC_PER_SEC)
+
+typedef struct _ReplayClock
+{
+  /* Virtual time, comparable to the time of events */
+  gint64 now;
+  /* Time spent editing the document and dispatching sources */
+  gint64 edit_time;
+  gint64 dispatch_time;
+  /* Time spent blocked in poll() for workers or timeouts */
+  gint64 wait_time;
+} ReplayClock;
+
+static gint64 poll_time;
+static gint poll_limit = -1;
+
+static gint
+replay_poll (GPollFD *fds,
+             guint    n_fds,
+             gint     timeout)
+{
+  gint64 begin = g_get_monotonic_time ();
+  gint ret;
+
+  if (poll_limit >= 0 && (timeout < 0 || timeout > poll_limit))
+    timeout = poll_limit;
+
+  ret = g_poll (fds, n_fds, timeout);
+  poll_time += g_get_monotonic_time () - begin;
+
+  return ret;
+}
+
+/* Iterates the main context once, blocking for at most @budget
+ * microseconds.
+ */
+static void
+replay_clock_iterate (ReplayClock *clock,
+                      gint64       budget)
+{
+  gint64 begin = g_get_monotonic_time ();
+  gint64 polled = poll_time;
+  gint64 elapsed;
+  gint64 waited;
+
+  poll_limit = CLAMP ((budget + 999) / 1000, 1, G_MAXINT);
+  g_main_context_iteration (NULL, TRUE);
+  poll_limit = -1;
+
+  elapsed = g_get_monotonic_time () - begin;
+  waited = poll_time - polled;
+
+  clock->now += elapsed;
+  clock->dispatch_time += elapsed - waited;
+  clock->wait_time += waited;
+}
+
+static gboolean
+replay_event (SpellingDocument             *document,
+              const SpellingEditTraceEvent *event,
+              ReplayClock                  *clock)
+{
+  gint64 begin = g_get_monotonic_time ();
+  gint64 elapsed;
+  guint length = spelling_document_get_length (document);
+
+  switch (event->kind)
+    {
+    case SPELLING_EDIT_TRACE_INSERT:
+      if (event->position > length)
+        return FALSE;
+      spelling_document_insert (document, event->position, event->text, -1);
+      break;
+
+    case SPELLING_EDIT_TRACE_DELETE:
+      if (event->position > length || event->length > length - event->position)
+        return FALSE;
+      spelling_document_delete (document, event->position, event->length);
+      break;
+
+    case SPELLING_EDIT_TRACE_CURSOR:
+      _spelling_document_set_cursor (document, event->position);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  elapsed = g_get_monotonic_time () - begin;
+
+  clock->now += elapsed;
+  clock->edit_time += elapsed;
+
+  return TRUE;
+}
+
+static int
+compare_gint64 (gconstpointer a,
+                gconstpointer b)
+{
+  const gint64 *ia = a;
+  const gint64 *ib = b;
+
+  return *ia < *ib ? -1 : *ia > *ib;
+}
+
+static double
+percentile_msec (GArray *sorted,
+                 double  percentile)
+{
+  if (sorted->len == 0)
+    return 0;
+
+  return g_array_index (sorted, gint64, (guint)((sorted->len - 1) * percentile / 100)) / 1000.;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(SpellingChecker) checker = NULL;
+  g_autoptr(SpellingDocument) document = NULL;
+  g_autoptr(SpellingStats) stats = NULL;
+  g_autoptr(GArray) events = NULL;
+  g_autoptr(GArray) lags = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree char *language_code = NULL;
+  ReplayClock clock = {0};
+  gboolean json = FALSE;
+  gint64 wall_time;
+  gint64 recorded = 0;
+  gint64 last_event;
+  gint64 clean_time;
+  guint n_edits = 0;
+
+  const GOptionEntry entries[] = {
+    { "language", 'l', 0, G_OPTION_ARG_STRING, &language_code, "The language to check with, such as en_US", "CODE" },
+    { "json", 0, 0, G_OPTION_ARG_NONE, &json, "Print the report as JSON", NULL },
+    { 0 }
+  };
+
+  setlocale (LC_ALL, "");
+
+  spelling_init ();
+
+  context = g_option_context_new ("TRACE - replay an edit trace and report its cost");
+  g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+  g_option_context_set_description (context,
+                                    "Traces are recorded by applications using libspelling when\n"
+                                    "LIBSPELLING_EDIT_TRACE_DIR is set to a directory. Times are\n"
+                                    "reported in milliseconds.");
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (argc != 2)
+    {
+      g_autofree char *help = g_option_context_get_help (context, TRUE, NULL);
+      g_printerr ("%s", help);
+      return EXIT_FAILURE;
+    }
+
+  if (!(events = spelling_edit_trace_load (argv[1], &error)))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  checker = spelling_checker_new (NULL, language_code);
+
+  if (_spelling_checker_get_dictionary (checker) == NULL)
+    {
+      const char *code = spelling_checker_get_language (checker);
+
+      g_printerr ("No dictionary available for %s\n",
+                  code ? code : "the default language");
+      return EXIT_FAILURE;
+    }
+
+  document = spelling_document_new (checker);
+  lags = g_array_sized_new (FALSE, FALSE, sizeof (gint64), events->len);
+
+  g_main_context_set_poll_func (NULL, replay_poll);
+
+  wall_time = g_get_monotonic_time ();
+
+  for (guint i = 0; i < events->len; i++)
+    {
+      const SpellingEditTraceEvent *event = &g_array_index (events, SpellingEditTraceEvent, i);
+      gint64 lag;
+
+      while (clock.now < event->time && spelling_document_get_busy (document))
+        replay_clock_iterate (&clock, event->time - clock.now);
+
+      /* The engine was idle until the user acted again */
+      if (clock.now < event->time)
+        clock.now = event->time;
+
+      lag = clock.now - event->time;
+      g_array_append_val (lags, lag);
+
+      if (!replay_event (document, event, &clock))
+        {
+          g_printerr ("%s: event %u does not apply to the replayed text\n", argv[1], i + 1);
+          return EXIT_FAILURE;
+        }
+
+      if (event->kind != SPELLING_EDIT_TRACE_CURSOR)
+        n_edits++;
+
+      recorded = event->time;
+    }
+
+  last_event = clock.now;
+
+  while (spelling_document_get_busy (document) && clock.now - last_event < CLEAN_TIMEOUT)
+    replay_clock_iterate (&clock, CLEAN_TIMEOUT - (clock.now - last_event));
+
+  clean_time = clock.now - last_event;
+  wall_time = g_get_monotonic_time () - wall_time;
+
+  if (spelling_document_get_busy (document))
+    g_printerr ("Checking did not finish within %u seconds\n",
+                (guint)(CLEAN_TIMEOUT / G_USEC_PER_SEC));
+
+  g_array_sort (lags, compare_gint64);
+  stats = _spelling_document_dup_stats (document);
+
+  if (json)
+    {
+      g_print ("{\"events\": %u, \"edits\": %u, "
+               "\"recorded\": %.3f, \"replayed\": %.3f, \"wall\": %.3f, "
+               "\"edit\": %.3f, \"dispatch\": %.3f, \"wait\": %.3f, \"workers\": %.3f, "
+               "\"lag_p50\": %.3f, \"lag_p99\": %.3f, \"lag_max\": %.3f, "
+               "\"clean\": %.3f, \"apply_p99\": %.3f, "
+               "\"jobs\": %u, \"words\": %u, \"discarded\": %u}\n",
+               events->len, n_edits,
+               recorded / 1000., clock.now / 1000., wall_time / 1000.,
+               clock.edit_time / 1000., clock.dispatch_time / 1000., clock.wait_time / 1000.,
+               spelling_stats_get_job_time (stats) / 1000.,
+               percentile_msec (lags, 50), percentile_msec (lags, 99), percentile_msec (lags, 100),
+               clean_time / 1000.,
+               spelling_stats_get_apply_latency (stats, 99) / 1000.,
+               spelling_stats_get_jobs_run (stats),
+               spelling_stats_get_words_checked (stats),
+               spelling_stats_get_discarded_fragments (stats));
+    }
+  else
+    {
+      g_print ("Events:        %u (%u edits)\n", events->len, n_edits);
+      g_print ("Recorded:      %.3f\n", recorded / 1000.);
+      g_print ("Replayed:      %.3f virtual, %.3f wall\n", clock.now / 1000., wall_time / 1000.);
+      g_print ("Main loop:     %.3f editing, %.3f dispatching\n",
+               clock.edit_time / 1000., clock.dispatch_time / 1000.);
+      g_print ("Waiting:       %.3f\n", clock.wait_time / 1000.);
+      g_print ("Workers:       %.3f in %u jobs, %u words, %u fragments discarded\n",
+               spelling_stats_get_job_time (stats) / 1000.,
+               spelling_stats_get_jobs_run (stats),
+               spelling_stats_get_words_checked (stats),
+               spelling_stats_get_discarded_fragments (stats));
+      g_print ("Input lag:     %.3f p50, %.3f p99, %.3f max\n",
+               percentile_msec (lags, 50), percentile_msec (lags, 99), percentile_msec (lags, 100));
+      g_print ("Apply:         %.3f p99\n",
+               spelling_stats_get_apply_latency (stats, 99) / 1000.);
+      g_print ("Time to clean: %.3f after the last event\n", clean_time / 1000.);
+    }
+
+  return EXIT_SUCCESS;
+}